@@ -0,0 +1,295 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_BUFFERED_WRITER
+#define VCP_BUFFERED_WRITER
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <system_error>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vcp {
+
+class buffered_writer {
+	public:
+		constexpr static const std::size_t default_capacity = 1 << 20;
+		buffered_writer( int fd, std::size_t capacity = default_capacity, bool block_aligned = false );
+		buffered_writer( buffered_writer const & ) = delete;
+		buffered_writer & operator=( buffered_writer const & ) = delete;
+		~buffered_writer();
+		static bool enable_direct_io( int fd );
+		int descriptor() const;
+		char const * data() const;
+		std::size_t size() const;
+		void clear();
+		void put( char c );
+		void write( char const * data, std::size_t size );
+		template <typename integral_type> void write_le( integral_type value );
+		template <typename integral_type> typename std::enable_if<std::is_integral<integral_type>::value>::type write_decimal( integral_type value );
+		template <typename number_type> typename std::enable_if<!std::is_integral<number_type>::value>::type write_decimal( number_type const & value );
+		void flush();
+	private:
+		constexpr static const std::size_t block_size = 4096;
+		constexpr static const std::size_t max_decimal_digits = 20;
+		constexpr static const std::size_t max_decimal_chunks = 64;
+		static char const digit_pairs[201];
+		int fd;
+		bool block_aligned;
+		std::size_t capacity;
+		std::size_t used;
+		std::unique_ptr<char[]> storage;
+		char * buffer;
+		void drain();
+		void grow( std::size_t minimum );
+		void reserve( std::size_t size );
+		void write_fully( char const * data, std::size_t size );
+		static std::size_t decimal_digits( std::uint64_t value );
+		static void format_decimal( std::uint64_t value, char * end, std::size_t digits );
+};
+
+char const buffered_writer::digit_pairs[201] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+// A negative descriptor selects an in-memory buffer that grows as needed. Its contents are exposed through data() and size(), and flush() does nothing.
+buffered_writer::buffered_writer( int fd, std::size_t capacity, bool block_aligned ) : fd( fd ), block_aligned( block_aligned ), capacity( block_aligned ? (capacity + block_size - 1) / block_size * block_size + block_size : capacity ), used( 0 ), storage( new char[this->capacity + (block_aligned ? block_size : 0)] ), buffer( storage.get() ) {
+	if( block_aligned ) { // one block of slack for the alignment adjustment and one for the partial block retained by drain()
+		buffer += (block_size - reinterpret_cast<std::uintptr_t>( buffer ) % block_size) % block_size;
+	}
+}
+
+buffered_writer::~buffered_writer() {
+	try {
+		flush();
+	} catch( std::system_error const & ) { // callers wanting to observe write errors must flush explicitly
+	}
+}
+
+bool buffered_writer::enable_direct_io( int fd ) {
+#ifdef O_DIRECT
+	struct stat status;
+	if( fstat( fd, &status ) != 0 || !S_ISREG( status.st_mode ) ) { // O_DIRECT on a pipe selects packet mode, which readers may truncate
+		return false;
+	}
+	int flags( fcntl( fd, F_GETFL ) );
+	if( flags < 0 ) {
+		return false;
+	}
+	off_t offset( flags & O_APPEND ? status.st_size : lseek( fd, 0, SEEK_CUR ) ); // appends go to the end of the file wherever the offset is
+	if( offset < 0 || offset % block_size != 0 ) {
+		return false;
+	}
+	return fcntl( fd, F_SETFL, flags | O_DIRECT ) == 0;
+#else
+	(void)fd;
+	return false;
+#endif
+}
+
+int buffered_writer::descriptor() const {
+	return fd;
+}
+
+char const * buffered_writer::data() const {
+	return buffer;
+}
+
+std::size_t buffered_writer::size() const {
+	return used;
+}
+
+void buffered_writer::clear() {
+	used = 0;
+}
+
+void buffered_writer::put( char c ) {
+	if( used == capacity ) {
+		drain();
+	}
+	buffer[used++] = c;
+}
+
+void buffered_writer::write( char const * data, std::size_t size ) {
+	if( used + size > capacity ) {
+		if( fd < 0 ) {
+			grow( used + size );
+		} else {
+			drain();
+			if( !block_aligned && size > capacity ) {
+				write_fully( data, size );
+				return;
+			}
+			while( used + size > capacity ) {
+				std::size_t part( capacity - used );
+				std::memcpy( buffer + used, data, part );
+				used += part;
+				data += part;
+				size -= part;
+				drain();
+			}
+		}
+	}
+	std::memcpy( buffer + used, data, size );
+	used += size;
+}
+
+template <typename integral_type>
+void buffered_writer::write_le( integral_type value ) {
+	static_assert( std::is_integral<integral_type>::value && std::is_unsigned<integral_type>::value, "write_le requires an unsigned integral type" );
+	char bytes[sizeof(integral_type)];
+	for( std::size_t i( 0 ); i < sizeof(integral_type); ++i ) {
+		bytes[i] = static_cast<char>( value & 0xff );
+		value >>= CHAR_BIT;
+	}
+	write( bytes, sizeof(integral_type) );
+}
+
+template <typename integral_type>
+typename std::enable_if<std::is_integral<integral_type>::value>::type buffered_writer::write_decimal( integral_type value ) {
+	static_assert( std::is_unsigned<integral_type>::value && sizeof(integral_type) <= sizeof(std::uint64_t), "write_decimal requires an unsigned integral type of at most 64 bits" );
+	reserve( max_decimal_digits );
+	std::size_t digits( decimal_digits( value ) );
+	format_decimal( value, buffer + used + digits, digits );
+	used += digits;
+}
+
+template <typename number_type>
+typename std::enable_if<!std::is_integral<number_type>::value>::type buffered_writer::write_decimal( number_type const & value ) {
+	// peel off 19-digit chunks so that all but one division is performed in native arithmetic
+	number_type const divisor( UINT64_C(10000000000000000000) );
+	std::uint64_t chunks[max_decimal_chunks];
+	std::size_t count( 0 );
+	number_type remaining( value );
+	do {
+		assert( count < max_decimal_chunks );
+		chunks[count++] = static_cast<number_type>( remaining % divisor ).template convert_to<std::uint64_t>();
+		remaining /= divisor;
+	} while( remaining != 0 );
+	write_decimal( chunks[--count] );
+	while( count > 0 ) {
+		reserve( max_decimal_digits );
+		format_decimal( chunks[--count], buffer + used + 19, 19 );
+		used += 19;
+	}
+}
+
+void buffered_writer::flush() {
+	if( fd < 0 ) {
+		return;
+	}
+	if( block_aligned ) { // neither the final partial block nor later writes through the descriptor, such as the rewritten npy header, can be written with O_DIRECT
+#ifdef O_DIRECT
+		int flags( fcntl( fd, F_GETFL ) );
+		if( flags >= 0 && (flags & O_DIRECT) ) {
+			drain();
+			fcntl( fd, F_SETFL, flags & ~O_DIRECT );
+		}
+#endif
+	}
+	std::size_t size( used );
+	used = 0;
+	write_fully( buffer, size );
+}
+
+void buffered_writer::drain() {
+	if( fd < 0 ) {
+		grow( capacity + 1 );
+		return;
+	}
+	std::size_t size( block_aligned ? used / block_size * block_size : used );
+	std::size_t remainder( used - size );
+	write_fully( buffer, size );
+	std::memmove( buffer, buffer + size, remainder );
+	used = remainder;
+}
+
+void buffered_writer::grow( std::size_t minimum ) {
+	std::size_t grown( std::max( minimum, 2 * capacity ) );
+	std::unique_ptr<char[]> replacement( new char[grown] );
+	std::memcpy( replacement.get(), buffer, used );
+	storage.swap( replacement );
+	buffer = storage.get();
+	capacity = grown;
+}
+
+void buffered_writer::reserve( std::size_t size ) {
+	if( capacity - used < size ) {
+		drain();
+	}
+}
+
+void buffered_writer::write_fully( char const * data, std::size_t size ) {
+	while( size > 0 ) {
+		ssize_t written( ::write( fd, data, size ) );
+		if( written < 0 ) {
+			if( errno == EINTR ) {
+				continue;
+			}
+			throw std::system_error( errno, std::system_category(), "write" );
+		}
+		data += written;
+		size -= written;
+	}
+}
+
+std::size_t buffered_writer::decimal_digits( std::uint64_t value ) {
+	std::size_t digits( 1 );
+	for( ;; ) {
+		if( value < 10 ) {
+			return digits;
+		} else if( value < 100 ) {
+			return digits + 1;
+		} else if( value < 1000 ) {
+			return digits + 2;
+		} else if( value < 10000 ) {
+			return digits + 3;
+		}
+		value /= 10000;
+		digits += 4;
+	}
+}
+
+void buffered_writer::format_decimal( std::uint64_t value, char * end, std::size_t digits ) {
+	// writes exactly digits characters ending at end, zero-padding on the left
+	for( ; digits >= 2; digits -= 2 ) {
+		std::size_t pair( 2 * (value % 100) );
+		value /= 100;
+		*--end = digit_pairs[pair + 1];
+		*--end = digit_pairs[pair];
+	}
+	if( digits != 0 ) {
+		*--end = static_cast<char>( '0' + value % 10 );
+	}
+}
+
+}
+
+#endif
@@ -0,0 +1,234 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_CANDIDATE_PAIRS
+#define VCP_CANDIDATE_PAIRS
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <vcp/directed_graph.hpp>
+#include <vcp/graph.hpp>
+
+namespace vcp {
+
+template <std::size_t r> class multirelational_graph;
+template <std::size_t r> class multirelational_directed_graph;
+
+template <typename graph_type> struct is_directed_graph : std::false_type {};
+template <> struct is_directed_graph<directed_graph> : std::true_type {};
+template <std::size_t r> struct is_directed_graph<multirelational_directed_graph<r> > : std::true_type {};
+
+// enumerates, for a source vertex v1, the vertices v2 > v1 within max_distance hops of v1 but not adjacent to it; directed graphs are treated as undirected
+template <typename graph_type>
+class candidate_pairs {
+	public:
+		candidate_pairs( graph_type const & g, std::size_t max_distance = 2, std::size_t min_common = 0, std::size_t max_degree = std::numeric_limits<std::size_t>::max(), double sample_rate = 1.0, std::uint64_t seed = 0 );
+		template <typename visitor_type> void enumerate( const_vertex_iterator v1, bool sorted, visitor_type & visit );
+		std::size_t degree( const_vertex_iterator v ) const;
+	private:
+		graph_type const & g;
+		std::size_t max_distance;
+		std::size_t min_common;
+		std::size_t max_degree;
+		bool sampling;
+		std::uint64_t sample_threshold;
+		std::uint64_t seed;
+		std::size_t epoch;
+		std::vector<std::size_t> adjacent;
+		std::vector<std::size_t> reached;
+		std::vector<std::size_t> common;
+		std::vector<const_vertex_iterator> candidates;
+		std::vector<const_vertex_iterator> frontier;
+		std::vector<const_vertex_iterator> next_frontier;
+		void expand( const_vertex_iterator v1 );
+		void expand_distance_2( const_vertex_iterator v1 );
+		bool sampled( vertex_id_t v1, vertex_id_t v2 ) const;
+		template <typename function_type> void for_each_neighbor( const_vertex_iterator v, const_vertex_iterator after, function_type const & f, std::false_type ) const;
+		template <typename function_type> void for_each_neighbor( const_vertex_iterator v, const_vertex_iterator after, function_type const & f, std::true_type ) const;
+		const_edge_iterator first_after( const_edge_iterator begin, const_edge_iterator end, const_vertex_iterator after ) const;
+		std::size_t degree( const_vertex_iterator v, std::false_type ) const;
+		std::size_t degree( const_vertex_iterator v, std::true_type ) const;
+};
+
+template <typename graph_type>
+candidate_pairs<graph_type>::candidate_pairs( graph_type const & g, std::size_t max_distance, std::size_t min_common, std::size_t max_degree, double sample_rate, std::uint64_t seed ) : g( g ), max_distance( max_distance ), min_common( min_common ), max_degree( max_degree ), sampling( sample_rate < 1.0 ), sample_threshold( sample_rate <= 0.0 ? 0 : static_cast<std::uint64_t>( sample_rate * 18446744073709551616.0 ) ), seed( seed ), epoch( 0 ), adjacent( g.vertex_count(), 0 ), reached( g.vertex_count(), 0 ), common( g.vertex_count(), 0 ) {
+}
+
+template <typename graph_type>
+template <typename visitor_type>
+void candidate_pairs<graph_type>::enumerate( const_vertex_iterator v1, bool sorted, visitor_type & visit ) {
+	// epoch stamps stand in for clearing the marker arrays between source vertices
+	++epoch;
+	candidates.clear();
+	if( max_distance == 2 ) {
+		expand_distance_2( v1 );
+	} else {
+		expand( v1 );
+	}
+	if( sorted ) {
+		std::sort( candidates.begin(), candidates.end() );
+	}
+	vertex_id_t id1( g.vertex_id( v1 ) );
+	const_vertex_iterator vertices( g.vertices_begin() );
+	for( typename std::vector<const_vertex_iterator>::const_iterator it( candidates.begin() ); it != candidates.end(); ++it ) {
+		std::size_t count( common[*it - vertices] );
+		if( count >= min_common && (!sampling || sampled( id1, g.vertex_id( *it ) )) ) {
+			visit( v1, *it, count );
+		}
+	}
+}
+
+template <typename graph_type>
+void candidate_pairs<graph_type>::expand_distance_2( const_vertex_iterator v1 ) {
+	// only vertices beyond v1 can be candidates, so each scan of a neighbor list begins at the first such vertex
+	const_vertex_iterator vertices( g.vertices_begin() );
+	for_each_neighbor( v1, v1, [&]( const_vertex_iterator u ) {
+		adjacent[u - vertices] = epoch;
+	}, is_directed_graph<graph_type>() );
+	for_each_neighbor( v1, nullptr, [&]( const_vertex_iterator u ) {
+		if( degree( u ) > max_degree ) {
+			return;
+		}
+		for_each_neighbor( u, v1, [&]( const_vertex_iterator v2 ) {
+			std::size_t index( v2 - vertices );
+			if( adjacent[index] != epoch ) {
+				if( reached[index] != epoch ) {
+					reached[index] = epoch;
+					common[index] = 0;
+					candidates.push_back( v2 );
+				}
+				++common[index];
+			}
+		}, is_directed_graph<graph_type>() );
+	}, is_directed_graph<graph_type>() );
+}
+
+template <typename graph_type>
+void candidate_pairs<graph_type>::expand( const_vertex_iterator v1 ) {
+	// breadth-first search to max_distance; paths may pass through vertices below v1, so neighbor lists are scanned in full
+	const_vertex_iterator vertices( g.vertices_begin() );
+	frontier.clear();
+	reached[v1 - vertices] = epoch;
+	for_each_neighbor( v1, nullptr, [&]( const_vertex_iterator u ) {
+		adjacent[u - vertices] = epoch;
+		reached[u - vertices] = epoch;
+		frontier.push_back( u );
+	}, is_directed_graph<graph_type>() );
+	for( std::size_t distance( 2 ); distance <= max_distance && !frontier.empty(); ++distance ) {
+		next_frontier.clear();
+		for( typename std::vector<const_vertex_iterator>::const_iterator it( frontier.begin() ); it != frontier.end(); ++it ) {
+			if( degree( *it ) > max_degree ) {
+				continue;
+			}
+			for_each_neighbor( *it, nullptr, [&]( const_vertex_iterator v2 ) {
+				std::size_t index( v2 - vertices );
+				if( reached[index] != epoch ) {
+					reached[index] = epoch;
+					common[index] = 0;
+					next_frontier.push_back( v2 );
+					if( v2 > v1 ) {
+						candidates.push_back( v2 );
+					}
+				}
+				if( distance == 2 && v2 != v1 && adjacent[index] != epoch ) {
+					++common[index];
+				}
+			}, is_directed_graph<graph_type>() );
+		}
+		frontier.swap( next_frontier );
+	}
+}
+
+template <typename graph_type>
+std::size_t candidate_pairs<graph_type>::degree( const_vertex_iterator v ) const {
+	return degree( v, is_directed_graph<graph_type>() );
+}
+
+template <typename graph_type>
+bool candidate_pairs<graph_type>::sampled( vertex_id_t v1, vertex_id_t v2 ) const {
+	// splitmix64 finalizer over the pair, so that the sample is independent of thread count and output order
+	std::uint64_t z( seed + 0x9e3779b97f4a7c15ULL * (v1 + 1) + v2 );
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	z ^= z >> 31;
+	return z < sample_threshold;
+}
+
+template <typename graph_type>
+template <typename function_type>
+void candidate_pairs<graph_type>::for_each_neighbor( const_vertex_iterator v, const_vertex_iterator after, function_type const & f, std::false_type ) const {
+	const_edge_iterator end( g.neighbors_end( v ) );
+	for( const_edge_iterator it( first_after( g.neighbors_begin( v ), end, after ) ); it != end; ++it ) {
+		f( g.target_of( it ) );
+	}
+}
+
+template <typename graph_type>
+template <typename function_type>
+void candidate_pairs<graph_type>::for_each_neighbor( const_vertex_iterator v, const_vertex_iterator after, function_type const & f, std::true_type ) const {
+	// merges the sorted out- and in-neighbor lists so that reciprocated edges are visited once
+	const_edge_iterator out_end( g.out_neighbors_end( v ) );
+	const_edge_iterator in_end( g.in_neighbors_end( v ) );
+	const_edge_iterator out_it( first_after( g.out_neighbors_begin( v ), out_end, after ) );
+	const_edge_iterator in_it( first_after( g.in_neighbors_begin( v ), in_end, after ) );
+	while( out_it != out_end && in_it != in_end ) {
+		if( g.target_of( out_it ) < g.target_of( in_it ) ) {
+			f( g.target_of( out_it++ ) );
+		} else if( g.target_of( in_it ) < g.target_of( out_it ) ) {
+			f( g.target_of( in_it++ ) );
+		} else {
+			f( g.target_of( out_it++ ) );
+			++in_it;
+		}
+	}
+	for( ; out_it != out_end; ++out_it ) {
+		f( g.target_of( out_it ) );
+	}
+	for( ; in_it != in_end; ++in_it ) {
+		f( g.target_of( in_it ) );
+	}
+}
+
+template <typename graph_type>
+const_edge_iterator candidate_pairs<graph_type>::first_after( const_edge_iterator begin, const_edge_iterator end, const_vertex_iterator after ) const {
+	if( after == nullptr ) {
+		return begin;
+	}
+	while( end - begin > 0 ) { // neighbor lists are sorted, so binary search for the first target beyond after
+		const_edge_iterator middle( begin + (end - begin) / 2 );
+		if( g.target_of( middle ) <= after ) {
+			begin = middle + 1;
+		} else {
+			end = middle;
+		}
+	}
+	return begin;
+}
+
+template <typename graph_type>
+std::size_t candidate_pairs<graph_type>::degree( const_vertex_iterator v, std::false_type ) const {
+	return g.neighbors_end( v ) - g.neighbors_begin( v );
+}
+
+template <typename graph_type>
+std::size_t candidate_pairs<graph_type>::degree( const_vertex_iterator v, std::true_type ) const {
+	return (g.out_neighbors_end( v ) - g.out_neighbors_begin( v )) + (g.in_neighbors_end( v ) - g.in_neighbors_begin( v ));
+}
+
+}
+
+#endif
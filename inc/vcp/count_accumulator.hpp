@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_COUNT_ACCUMULATOR
+#define VCP_COUNT_ACCUMULATOR
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace vcp {
+
+template <typename key_type>
+class count_accumulator {
+	public:
+		count_accumulator();
+		bool empty() const;
+		void add( key_type const & key, unsigned long count = 1 );
+		template <typename sink_type> void flush( sink_type & sink );
+	private:
+		constexpr static const std::size_t min_compaction_size = 1024;
+		std::vector<std::pair<key_type,unsigned long> > entries;
+		std::size_t compaction_size;
+		void compact();
+};
+
+template <typename key_type>
+constexpr const std::size_t count_accumulator<key_type>::min_compaction_size;
+
+template <typename key_type>
+count_accumulator<key_type>::count_accumulator() : compaction_size( min_compaction_size ) {
+}
+
+template <typename key_type>
+bool count_accumulator<key_type>::empty() const {
+	return entries.empty();
+}
+
+template <typename key_type>
+void count_accumulator<key_type>::add( key_type const & key, unsigned long count ) {
+	entries.push_back( std::make_pair( key, count ) );
+	if( entries.size() >= compaction_size ) { // bound the scratch storage by the number of distinct keys; doubling the threshold keeps compaction amortized
+		compact();
+		compaction_size = std::max( min_compaction_size, 2 * entries.size() );
+	}
+}
+
+template <typename key_type>
+void count_accumulator<key_type>::compact() {
+	std::sort( entries.begin(), entries.end(), []( std::pair<key_type,unsigned long> const & a, std::pair<key_type,unsigned long> const & b ) { return a.first < b.first; } );
+	typename std::vector<std::pair<key_type,unsigned long> >::iterator out( entries.begin() );
+	for( typename std::vector<std::pair<key_type,unsigned long> >::const_iterator it( entries.begin() ); it != entries.end(); ++it ) {
+		if( out != entries.begin() && (out - 1)->first == it->first ) {
+			(out - 1)->second += it->second;
+		} else {
+			*out++ = *it;
+		}
+	}
+	entries.erase( out, entries.end() );
+}
+
+template <typename key_type>
+template <typename sink_type>
+void count_accumulator<key_type>::flush( sink_type & sink ) {
+	compact();
+	for( typename std::vector<std::pair<key_type,unsigned long> >::const_iterator it( entries.begin() ); it != entries.end(); ++it ) {
+		if( it->second != 0 ) { // complement counts, such as the vertices adjacent to neither v1 nor v2, may be zero
+			sink( it->first, it->second );
+		}
+	}
+	entries.clear(); // capacity is retained so that subsequent pairs do not allocate
+	compaction_size = min_compaction_size;
+}
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_ELEMENT_INDEX
+#define VCP_ELEMENT_INDEX
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vcp/vcp_canonical_mapper.hpp>
+#include <vcp/vcp_dynamic_mapper.hpp>
+
+namespace vcp {
+
+// assigns dense element ids to canonical subgraph addresses of the sparse VCP classes
+template <std::size_t n,std::size_t r,bool d>
+class element_index {
+	public:
+		typedef typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type subgraph_address_type;
+		constexpr static const std::size_t address_bits = n*(n-1)*r*(d+1)/2;
+		constexpr static const std::size_t max_enumerated_bits = 24; // enumerating larger spaces exhausts memory
+		element_index( std::size_t relations = r ); // addresses may pack fewer relations than r, as vcp_dynamic_mapper<n,relations,d> packs them
+		element_index( element_index const & ) = delete;
+		element_index & operator=( element_index const & ) = delete;
+		bool enumerated() const;
+		std::size_t size() const;
+		std::size_t index( subgraph_address_type const & canonical_address );
+		subgraph_address_type address( std::size_t index ) const;
+	private:
+		std::unique_ptr<vcp_canonical_mapper> classes; // every class, numbered as by vcp_map; null when the address space is too large to enumerate
+		mutable std::mutex mutex;
+		std::map<subgraph_address_type,std::size_t> observed; // otherwise, ids in order of first observation
+		std::vector<subgraph_address_type> addresses;
+		static std::size_t narrow( std::size_t address );
+		template <typename backend_type> static std::size_t narrow( boost::multiprecision::number<backend_type> const & address );
+};
+
+template <std::size_t n,std::size_t r,bool d>
+constexpr const std::size_t element_index<n,r,d>::address_bits;
+
+template <std::size_t n,std::size_t r,bool d>
+constexpr const std::size_t element_index<n,r,d>::max_enumerated_bits;
+
+template <std::size_t n,std::size_t r,bool d>
+element_index<n,r,d>::element_index( std::size_t relations ) : classes( n*(n-1)*relations*(d+1)/2 <= max_enumerated_bits ? new vcp_canonical_mapper( n, relations, d ) : nullptr ) {
+}
+
+template <std::size_t n,std::size_t r,bool d>
+bool element_index<n,r,d>::enumerated() const {
+	return classes != nullptr;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t element_index<n,r,d>::size() const {
+	if( classes != nullptr ) {
+		return classes->element_count();
+	}
+	std::lock_guard<std::mutex> lock( mutex );
+	return addresses.size();
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t element_index<n,r,d>::index( subgraph_address_type const & canonical_address ) {
+	if( classes != nullptr ) {
+		return classes->element_address( narrow( canonical_address ) );
+	}
+	std::lock_guard<std::mutex> lock( mutex );
+	typename std::map<subgraph_address_type,std::size_t>::const_iterator it( observed.lower_bound( canonical_address ) );
+	if( it != observed.end() && it->first == canonical_address ) {
+		return it->second;
+	}
+	observed.insert( it, std::make_pair( canonical_address, addresses.size() ) );
+	addresses.push_back( canonical_address );
+	return addresses.size() - 1;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+typename element_index<n,r,d>::subgraph_address_type element_index<n,r,d>::address( std::size_t index ) const {
+	if( classes != nullptr ) {
+		return subgraph_address_type( classes->subgraph_address( index ) );
+	}
+	std::lock_guard<std::mutex> lock( mutex );
+	return addresses[index];
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t element_index<n,r,d>::narrow( std::size_t address ) {
+	return address;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename backend_type>
+std::size_t element_index<n,r,d>::narrow( boost::multiprecision::number<backend_type> const & address ) { // never reached: enumerated address spaces fit in std::size_t
+	return address.template convert_to<std::size_t>();
+}
+
+}
+
+#endif
@@ -0,0 +1,377 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_GRAPH_STATISTICS
+#define VCP_GRAPH_STATISTICS
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <vcp/directed_graph.hpp>
+#include <vcp/graph.hpp>
+#include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/multirelational_graph.hpp>
+
+namespace vcp {
+
+// the global aggregates that the n=4 classes complete their vectors with, computed in one parallel pass over the edges, together with the wedge and triangle totals of the simple undirected graph underlying g. An engine given them skips its own pass over every edge, and a sidecar next to the graph file holds them for later runs
+template <std::size_t r,bool d>
+class graph_statistics {
+	public:
+		typedef typename std::conditional< d,
+				typename std::conditional< (r>1), multirelational_directed_graph<r>, directed_graph >::type,
+				typename std::conditional< (r>1), multirelational_graph<r>, graph >::type
+				>::type graph_type;
+		typedef typename multirelational_graph<r>::connectivity_address_type connectivity_address_type;
+		typedef std::pair<connectivity_address_type,connectivity_address_type> pair_type; // the values of the arcs between two vertices, smaller first, or (0, value) when one is absent or for d=0
+		graph_statistics( graph_type const & g, std::size_t threads );
+		static std::string sidecar_path( std::string const & graph_path );
+		static std::unique_ptr<graph_statistics> load( graph_type const & g, std::string const & graph_path ); // null unless the sidecar is intact and was written for this graph file
+		bool save( graph_type const & g, std::string const & graph_path ) const;
+		std::map<pair_type,unsigned long> const & pair_types() const; // every pair of vertices by type, unconnected pairs under (0, 0)
+		unsigned long count( pair_type const & type ) const;
+		unsigned long wedges() const; // paths of two edges, by center
+		unsigned long triangles() const;
+	private:
+		typedef std::pair<vertex_id_t,pair_type> neighbor_type;
+		constexpr static const char magic[9] = "VCPSTAT1";
+		constexpr static const std::size_t block_size = 1024; // vertices claimed by a thread at a time
+		std::map<pair_type,unsigned long> types;
+		unsigned long wedge_count;
+		unsigned long triangle_count;
+		graph_statistics();
+		static void neighbors( graph_type const & g, vertex_id_t v, std::vector<neighbor_type> & out, std::false_type );
+		static void neighbors( graph_type const & g, vertex_id_t v, std::vector<neighbor_type> & out, std::true_type );
+		static connectivity_address_type value( graph_type const & g, const_edge_iterator it, std::false_type );
+		static connectivity_address_type value( graph_type const & g, const_edge_iterator it, std::true_type );
+		static std::size_t arc_count( graph_type const & g, std::false_type );
+		static std::size_t arc_count( graph_type const & g, std::true_type );
+		static bool identity( graph_type const & g, std::string const & graph_path, std::vector<std::uint64_t> & words ); // r, d, the vertex and arc counts, and the size and modification time of the file
+		static std::uint64_t checksum( std::string const & data ); // FNV-1a
+		static void put( std::string & data, std::uint64_t word );
+		static bool get( std::string const & data, std::size_t & position, std::uint64_t & word );
+		static void put_address( std::string & data, std::size_t address );
+		template <typename backend_type> static void put_address( std::string & data, boost::multiprecision::number<backend_type> address );
+		static bool get_address( std::string const & data, std::size_t & position, std::size_t & address );
+		template <typename backend_type> static bool get_address( std::string const & data, std::size_t & position, boost::multiprecision::number<backend_type> & address );
+};
+
+template <std::size_t r,bool d>
+constexpr const char graph_statistics<r,d>::magic[9];
+
+template <std::size_t r,bool d>
+constexpr const std::size_t graph_statistics<r,d>::block_size;
+
+template <std::size_t r,bool d>
+graph_statistics<r,d>::graph_statistics() : wedge_count( 0 ), triangle_count( 0 ) {
+}
+
+template <std::size_t r,bool d>
+graph_statistics<r,d>::graph_statistics( graph_type const & g, std::size_t threads ) : wedge_count( 0 ), triangle_count( 0 ) {
+	std::atomic<std::size_t> next_block( 0 );
+	std::mutex mutex;
+	std::vector<std::thread> workers;
+	for( std::size_t i( 0 ); i < std::max<std::size_t>( 1, threads ); ++i ) {
+		workers.push_back( std::thread( [&]() {
+			std::map<pair_type,unsigned long> local_types;
+			unsigned long local_wedges( 0 );
+			unsigned long local_triangles( 0 );
+			std::vector<neighbor_type> v_neighbors;
+			std::vector<neighbor_type> u_neighbors;
+			for( std::size_t block( next_block++ ); block * block_size < g.vertex_count(); block = next_block++ ) {
+				for( vertex_id_t v( block * block_size ); v < std::min<std::size_t>( (block + 1) * block_size, g.vertex_count() ); ++v ) {
+					v_neighbors.clear();
+					neighbors( g, v, v_neighbors, std::integral_constant<bool,d>() );
+					local_wedges += v_neighbors.size() * (v_neighbors.size() - 1) / 2; // the unsigned product is zero for isolated vertices
+					auto const at_most = []( neighbor_type const & neighbor, vertex_id_t w ) { return neighbor.first <= w; };
+					for( typename std::vector<neighbor_type>::const_iterator u( std::lower_bound( v_neighbors.begin(), v_neighbors.end(), v, at_most ) ); u != v_neighbors.end(); ++u ) { // each pair once, from its smaller vertex
+						++local_types[ u->second ];
+						u_neighbors.clear();
+						neighbors( g, u->first, u_neighbors, std::integral_constant<bool,d>() );
+						typename std::vector<neighbor_type>::const_iterator a( u + 1 );
+						typename std::vector<neighbor_type>::const_iterator b( std::lower_bound( u_neighbors.begin(), u_neighbors.end(), u->first, at_most ) );
+						while( a != v_neighbors.end() && b != u_neighbors.end() ) { // common neighbors above u complete each triangle once
+							if( a->first < b->first ) {
+								++a;
+							} else if( b->first < a->first ) {
+								++b;
+							} else {
+								++local_triangles;
+								++a;
+								++b;
+							}
+						}
+					}
+				}
+			}
+			std::lock_guard<std::mutex> lock( mutex );
+			for( typename std::map<pair_type,unsigned long>::const_iterator it( local_types.begin() ); it != local_types.end(); ++it ) {
+				types[ it->first ] += it->second;
+			}
+			wedge_count += local_wedges;
+			triangle_count += local_triangles;
+		} ) );
+	}
+	for( std::size_t i( 0 ); i < workers.size(); ++i ) {
+		workers[i].join();
+	}
+	unsigned long connected( 0 );
+	for( typename std::map<pair_type,unsigned long>::const_iterator it( types.begin() ); it != types.end(); ++it ) {
+		connected += it->second;
+	}
+	types[ pair_type( 0, 0 ) ] = g.vertex_count() * (g.vertex_count() - 1) / 2 - connected;
+}
+
+template <std::size_t r,bool d>
+std::string graph_statistics<r,d>::sidecar_path( std::string const & graph_path ) {
+	return graph_path + ".stats";
+}
+
+template <std::size_t r,bool d>
+std::unique_ptr<graph_statistics<r,d> > graph_statistics<r,d>::load( graph_type const & g, std::string const & graph_path ) {
+	std::ifstream file( sidecar_path( graph_path ), std::ifstream::in | std::ifstream::binary );
+	std::string const data( (std::istreambuf_iterator<char>( file )), std::istreambuf_iterator<char>() );
+	std::vector<std::uint64_t> expected;
+	if( !file || data.size() < sizeof( magic ) + 8 || data.compare( 0, sizeof( magic ), magic, sizeof( magic ) ) != 0 || !identity( g, graph_path, expected ) ) {
+		return std::unique_ptr<graph_statistics>();
+	}
+	std::size_t position( data.size() - 8 );
+	std::uint64_t stored_checksum;
+	get( data, position, stored_checksum );
+	if( stored_checksum != checksum( data.substr( 0, data.size() - 8 ) ) ) { // a torn or damaged sidecar is computed again
+		return std::unique_ptr<graph_statistics>();
+	}
+	position = sizeof( magic );
+	for( std::size_t i( 0 ); i < expected.size(); ++i ) {
+		std::uint64_t word;
+		if( !get( data, position, word ) || word != expected[i] ) {
+			return std::unique_ptr<graph_statistics>();
+		}
+	}
+	std::unique_ptr<graph_statistics> statistics( new graph_statistics() );
+	std::uint64_t wedges;
+	std::uint64_t triangles;
+	std::uint64_t type_count;
+	if( !get( data, position, wedges ) || !get( data, position, triangles ) || !get( data, position, type_count ) ) {
+		return std::unique_ptr<graph_statistics>();
+	}
+	statistics->wedge_count = wedges;
+	statistics->triangle_count = triangles;
+	for( std::uint64_t i( 0 ); i < type_count; ++i ) {
+		pair_type type;
+		std::uint64_t count;
+		if( !get_address( data, position, type.first ) || !get_address( data, position, type.second ) || !get( data, position, count ) ) {
+			return std::unique_ptr<graph_statistics>();
+		}
+		statistics->types.insert( statistics->types.end(), std::make_pair( type, count ) );
+	}
+	return position == data.size() - 8 ? std::move( statistics ) : std::unique_ptr<graph_statistics>();
+}
+
+template <std::size_t r,bool d>
+bool graph_statistics<r,d>::save( graph_type const & g, std::string const & graph_path ) const { // written beside the sidecar and renamed over it, so that readers never see a partial file
+	std::vector<std::uint64_t> words;
+	if( !identity( g, graph_path, words ) ) {
+		return false;
+	}
+	std::string data( magic, sizeof( magic ) );
+	for( std::size_t i( 0 ); i < words.size(); ++i ) {
+		put( data, words[i] );
+	}
+	put( data, wedge_count );
+	put( data, triangle_count );
+	put( data, types.size() );
+	for( typename std::map<pair_type,unsigned long>::const_iterator it( types.begin() ); it != types.end(); ++it ) {
+		put_address( data, it->first.first );
+		put_address( data, it->first.second );
+		put( data, it->second );
+	}
+	put( data, checksum( data ) );
+	std::string const temporary( sidecar_path( graph_path ) + ".tmp" );
+	{
+		std::ofstream file( temporary, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc );
+		file.write( data.data(), data.size() );
+		if( !file.flush() ) {
+			std::remove( temporary.c_str() );
+			return false;
+		}
+	}
+	return std::rename( temporary.c_str(), sidecar_path( graph_path ).c_str() ) == 0;
+}
+
+template <std::size_t r,bool d>
+std::map<typename graph_statistics<r,d>::pair_type,unsigned long> const & graph_statistics<r,d>::pair_types() const {
+	return types;
+}
+
+template <std::size_t r,bool d>
+unsigned long graph_statistics<r,d>::count( pair_type const & type ) const {
+	typename std::map<pair_type,unsigned long>::const_iterator it( types.find( type ) );
+	return it != types.end() ? it->second : 0;
+}
+
+template <std::size_t r,bool d>
+unsigned long graph_statistics<r,d>::wedges() const {
+	return wedge_count;
+}
+
+template <std::size_t r,bool d>
+unsigned long graph_statistics<r,d>::triangles() const {
+	return triangle_count;
+}
+
+template <std::size_t r,bool d>
+void graph_statistics<r,d>::neighbors( graph_type const & g, vertex_id_t v, std::vector<neighbor_type> & out, std::false_type ) {
+	const_vertex_iterator const vertex( g.vertices_begin() + v );
+	for( const_edge_iterator it( g.neighbors_begin( vertex ) ); it != g.neighbors_end( vertex ); ++it ) {
+		out.push_back( neighbor_type( g.vertex_id( g.target_of( it ) ), pair_type( 0, value( g, it, std::integral_constant<bool,(r>1)>() ) ) ) );
+	}
+}
+
+template <std::size_t r,bool d>
+void graph_statistics<r,d>::neighbors( graph_type const & g, vertex_id_t v, std::vector<neighbor_type> & out, std::true_type ) { // the union of out- and in-neighbors
+	const_vertex_iterator const vertex( g.vertices_begin() + v );
+	const_edge_iterator out_it( g.out_neighbors_begin( vertex ) );
+	const_edge_iterator in_it( g.in_neighbors_begin( vertex ) );
+	while( out_it != g.out_neighbors_end( vertex ) || in_it != g.in_neighbors_end( vertex ) ) {
+		if( in_it == g.in_neighbors_end( vertex ) || (out_it != g.out_neighbors_end( vertex ) && g.target_of( out_it ) < g.target_of( in_it )) ) {
+			out.push_back( neighbor_type( g.vertex_id( g.target_of( out_it ) ), pair_type( 0, value( g, out_it, std::integral_constant<bool,(r>1)>() ) ) ) );
+			++out_it;
+		} else if( out_it == g.out_neighbors_end( vertex ) || g.target_of( in_it ) < g.target_of( out_it ) ) {
+			out.push_back( neighbor_type( g.vertex_id( g.target_of( in_it ) ), pair_type( 0, value( g, in_it, std::integral_constant<bool,(r>1)>() ) ) ) );
+			++in_it;
+		} else {
+			connectivity_address_type const forward( value( g, out_it, std::integral_constant<bool,(r>1)>() ) );
+			connectivity_address_type const backward( value( g, in_it, std::integral_constant<bool,(r>1)>() ) );
+			out.push_back( neighbor_type( g.vertex_id( g.target_of( out_it ) ), forward < backward ? pair_type( forward, backward ) : pair_type( backward, forward ) ) );
+			++out_it;
+			++in_it;
+		}
+	}
+}
+
+template <std::size_t r,bool d>
+typename graph_statistics<r,d>::connectivity_address_type graph_statistics<r,d>::value( graph_type const &, const_edge_iterator, std::false_type ) {
+	return 1;
+}
+
+template <std::size_t r,bool d>
+typename graph_statistics<r,d>::connectivity_address_type graph_statistics<r,d>::value( graph_type const & g, const_edge_iterator it, std::true_type ) {
+	return g.edge_value( it );
+}
+
+template <std::size_t r,bool d>
+std::size_t graph_statistics<r,d>::arc_count( graph_type const & g, std::false_type ) {
+	return g.edges_end() - g.edges_begin();
+}
+
+template <std::size_t r,bool d>
+std::size_t graph_statistics<r,d>::arc_count( graph_type const & g, std::true_type ) {
+	return g.out_edge_count();
+}
+
+template <std::size_t r,bool d>
+bool graph_statistics<r,d>::identity( graph_type const & g, std::string const & graph_path, std::vector<std::uint64_t> & words ) { // the graph is not fingerprinted, which would cost the pass that the sidecar saves
+	struct stat status;
+	if( stat( graph_path.c_str(), &status ) != 0 ) {
+		return false;
+	}
+	std::uint64_t const identity_words[] = { r, d, g.vertex_count(), arc_count( g, std::integral_constant<bool,d>() ), static_cast<std::uint64_t>( status.st_size ), static_cast<std::uint64_t>( status.st_mtim.tv_sec ), static_cast<std::uint64_t>( status.st_mtim.tv_nsec ) };
+	words.assign( std::begin( identity_words ), std::end( identity_words ) );
+	return true;
+}
+
+template <std::size_t r,bool d>
+std::uint64_t graph_statistics<r,d>::checksum( std::string const & data ) {
+	std::uint64_t h( 0xcbf29ce484222325ull );
+	for( std::size_t i( 0 ); i < data.size(); ++i ) {
+		h = (h ^ static_cast<unsigned char>( data[i] )) * 0x100000001b3ull;
+	}
+	return h;
+}
+
+template <std::size_t r,bool d>
+void graph_statistics<r,d>::put( std::string & data, std::uint64_t word ) { // little-endian
+	for( std::size_t byte( 0 ); byte < 8; ++byte ) {
+		data.push_back( static_cast<char>( (word >> (8 * byte)) & 0xff ) );
+	}
+}
+
+template <std::size_t r,bool d>
+bool graph_statistics<r,d>::get( std::string const & data, std::size_t & position, std::uint64_t & word ) {
+	if( data.size() - position < 8 ) {
+		return false;
+	}
+	word = 0;
+	for( std::size_t byte( 0 ); byte < 8; ++byte ) {
+		word |= std::uint64_t( static_cast<unsigned char>( data[position + byte] ) ) << (8 * byte);
+	}
+	position += 8;
+	return true;
+}
+
+template <std::size_t r,bool d>
+void graph_statistics<r,d>::put_address( std::string & data, std::size_t address ) {
+	put( data, address );
+}
+
+template <std::size_t r,bool d>
+template <typename backend_type>
+void graph_statistics<r,d>::put_address( std::string & data, boost::multiprecision::number<backend_type> address ) { // (r+63)/64 words, least significant first
+	for( std::size_t word( 0 ); word < (r + 63) / 64; ++word ) {
+		put( data, static_cast<boost::multiprecision::number<backend_type> >( address & std::numeric_limits<std::uint64_t>::max() ).template convert_to<std::uint64_t>() );
+		address >>= 64;
+	}
+}
+
+template <std::size_t r,bool d>
+bool graph_statistics<r,d>::get_address( std::string const & data, std::size_t & position, std::size_t & address ) {
+	std::uint64_t word;
+	if( !get( data, position, word ) ) {
+		return false;
+	}
+	address = word;
+	return true;
+}
+
+template <std::size_t r,bool d>
+template <typename backend_type>
+bool graph_statistics<r,d>::get_address( std::string const & data, std::size_t & position, boost::multiprecision::number<backend_type> & address ) {
+	address = 0;
+	for( std::size_t word( 0 ); word < (r + 63) / 64; ++word ) {
+		std::uint64_t value;
+		if( !get( data, position, value ) ) {
+			return false;
+		}
+		address |= boost::multiprecision::number<backend_type>( value ) << (64 * word);
+	}
+	return true;
+}
+
+}
+
+#endif
@@ -38,6 +38,8 @@ class multirelational_directed_graph {
 		typedef typename multirelational_graph<r>::connectivity_address_type connectivity_address_type;
 		multirelational_directed_graph();
 		multirelational_directed_graph( multirelational_directed_graph const & );
+		template <std::size_t source_r,typename recode_type> multirelational_directed_graph( multirelational_directed_graph<source_r> const & g, recode_type const & recode );
+		multirelational_directed_graph( multirelational_directed_graph const & g, connectivity_address_type const & mask );
 		~multirelational_directed_graph();
 		multirelational_directed_graph & operator=( multirelational_directed_graph const & );
 		std::size_t vertex_count() const;
@@ -70,17 +72,17 @@ class multirelational_directed_graph {
 		std::size_t num_out_edges;
 		std::unique_ptr<void*[]> vertices;
 		std::unique_ptr<void*[]> edges;
-		std::unique_ptr<connectivity_address_type[]> edge_values;
+		std::unique_ptr<connectivity_address_type[]> edge_values; // one trailing zero so that edge_value( in_edges_end() ) reports an absent edge
 };
 
 template <std::size_t r>
-multirelational_directed_graph<r>::multirelational_directed_graph() : num_vertices(0), num_out_edges(0), vertices(std::unique_ptr<void*[]>(new void*[1])), edges(std::unique_ptr<void*[]>(new void*[1])), edge_values( std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[0])) {
+multirelational_directed_graph<r>::multirelational_directed_graph() : num_vertices(0), num_out_edges(0), vertices(std::unique_ptr<void*[]>(new void*[1])), edges(std::unique_ptr<void*[]>(new void*[1])), edge_values( std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[1]())) {
 	vertices[0] = &edges[0];
 	edges[0] = NULL;
 }
 
 template <std::size_t r>
-multirelational_directed_graph<r>::multirelational_directed_graph( multirelational_directed_graph const & g ) : num_vertices(g.num_vertices), num_out_edges(g.num_out_edges), vertices(std::unique_ptr<void*[]>(new void*[2*g.vertex_count()+1])), edges(std::unique_ptr<void*[]>(new void*[g.out_edge_count()+g.in_edge_count()+1])), edge_values( std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[2*g.num_out_edges])) {
+multirelational_directed_graph<r>::multirelational_directed_graph( multirelational_directed_graph const & g ) : num_vertices(g.num_vertices), num_out_edges(g.num_out_edges), vertices(std::unique_ptr<void*[]>(new void*[2*g.vertex_count()+1])), edges(std::unique_ptr<void*[]>(new void*[g.out_edge_count()+g.in_edge_count()+1])), edge_values( std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[2*g.num_out_edges+1]())) {
 	for( const_vertex_iterator it = g.vertices_begin(); it != g.vertices_end(); ++it ) {
 		vertices[ g.vertex_id( it ) ] = &edges[ g.edge_id( g.out_neighbors_begin( it ) ) ];
 		vertices[ vertex_count() + g.vertex_id( it ) ] = &edges[ g.edge_id( g.in_neighbors_begin( it ) ) ];
@@ -97,6 +99,59 @@ multirelational_directed_graph<r>::multirelational_directed_graph( multirelation
 	edges[ out_edge_count() + in_edge_count() ] = NULL;
 }
 
+template <std::size_t r>
+template <std::size_t source_r,typename recode_type>
+multirelational_directed_graph<r>::multirelational_directed_graph( multirelational_directed_graph<source_r> const & g, recode_type const & recode ) : num_vertices(g.vertex_count()), num_out_edges(g.out_edge_count()), vertices(std::unique_ptr<void*[]>(new void*[2*g.vertex_count()+1])), edges(std::unique_ptr<void*[]>(new void*[g.out_edge_count()+g.in_edge_count()+1])), edge_values( std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[2*num_out_edges+1]())) { // the structure of g with each edge value v replaced by recode( v )
+	for( const_vertex_iterator it = g.vertices_begin(); it != g.vertices_end(); ++it ) {
+		vertices[ g.vertex_id( it ) ] = &edges[ g.edge_id( g.out_neighbors_begin( it ) ) ];
+		vertices[ vertex_count() + g.vertex_id( it ) ] = &edges[ g.edge_id( g.in_neighbors_begin( it ) ) ];
+	}
+	vertices[ 2*vertex_count() ]  = &edges[ out_edge_count() + in_edge_count() ];
+	for( const_edge_iterator it = g.out_edges_begin(); it != g.out_edges_end(); ++it ) {
+		edges[ g.edge_id( it ) ] = &vertices[ g.vertex_id( g.target_of( it ) ) ];
+		edge_values[ g.edge_id( it ) ] = recode( g.edge_value( it ) );
+	}
+	for( const_edge_iterator it = g.in_edges_begin(); it != g.in_edges_end(); ++it ) {
+		edges[ g.edge_id( it ) ] = &vertices[ g.vertex_id( g.target_of( it ) ) ];
+		edge_values[ g.edge_id( it ) ] = recode( g.edge_value( it ) );
+	}
+	edges[ out_edge_count() + in_edge_count() ] = NULL;
+}
+
+template <std::size_t r>
+multirelational_directed_graph<r>::multirelational_directed_graph( multirelational_directed_graph const & g, connectivity_address_type const & mask ) : num_vertices(g.vertex_count()), num_out_edges(0), vertices(std::unique_ptr<void*[]>(new void*[2*g.vertex_count()+1])) { // the projection of g onto the relations in mask, without the edges that carry none of them
+	for( const_edge_iterator it = g.out_edges_begin(); it != g.out_edges_end(); ++it ) {
+		if( (g.edge_value( it ) & mask) != 0 ) {
+			++num_out_edges;
+		}
+	}
+	edges = std::unique_ptr<void*[]>(new void*[2*num_out_edges+1]);
+	edge_values = std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[2*num_out_edges+1]());
+	edge_id_t id( 0 );
+	for( const_vertex_iterator vIt = g.vertices_begin(); vIt != g.vertices_end(); ++vIt ) {
+		vertices[ g.vertex_id( vIt ) ] = &edges[ id ];
+		for( const_edge_iterator it = g.out_neighbors_begin( vIt ); it != g.out_neighbors_end( vIt ); ++it ) {
+			connectivity_address_type const value( g.edge_value( it ) & mask );
+			if( value != 0 ) {
+				edges[ id ] = &vertices[ g.vertex_id( g.target_of( it ) ) ];
+				edge_values[ id++ ] = value;
+			}
+		}
+	}
+	for( const_vertex_iterator vIt = g.vertices_begin(); vIt != g.vertices_end(); ++vIt ) {
+		vertices[ vertex_count() + g.vertex_id( vIt ) ] = &edges[ id ];
+		for( const_edge_iterator it = g.in_neighbors_begin( vIt ); it != g.in_neighbors_end( vIt ); ++it ) {
+			connectivity_address_type const value( g.edge_value( it ) & mask );
+			if( value != 0 ) {
+				edges[ id ] = &vertices[ g.vertex_id( g.target_of( it ) ) ];
+				edge_values[ id++ ] = value;
+			}
+		}
+	}
+	vertices[ 2*vertex_count() ] = &edges[ 2*num_out_edges ];
+	edges[ 2*num_out_edges ] = NULL;
+}
+
 template <std::size_t r>
 multirelational_directed_graph<r>::~multirelational_directed_graph() {
 }
@@ -108,7 +163,7 @@ multirelational_directed_graph<r> & multirelational_directed_graph<r>::operator=
 		num_out_edges = g.num_out_edges;
 		vertices = std::unique_ptr<void*[]>(new void*[ 2*g.vertex_count()+1 ]);
 		edges = std::unique_ptr<void*[]>(new void*[ g.out_edge_count()+g.in_edge_count()+1 ]);
-		edge_values = std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[2*g.num_out_edges]);
+		edge_values = std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[2*g.num_out_edges+1]());
 		for( const_vertex_iterator it = g.vertices_begin(); it != g.vertices_end(); ++it ) {
 			vertices[ g.vertex_id( it ) ] = &edges[ g.edge_id( g.out_neighbors_begin( it ) ) ];
 			vertices[ vertex_count() + g.vertex_id( it ) ] = &edges[ g.edge_id( g.in_neighbors_begin( it ) ) ];
@@ -298,7 +353,7 @@ std::istream & operator>>( std::istream & is, multirelational_directed_graph<r>
 	
 	g.vertices = std::unique_ptr<void*[]>(new void*[ 2 * g.vertex_count() + 1 ]);
 	g.edges = std::unique_ptr<void*[]>(new void*[ g.out_edge_count() + g.in_edge_count() + 1 ]);
-	g.edge_values = std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[g.out_edge_count()+g.in_edge_count()]);
+	g.edge_values = std::unique_ptr<typename multirelational_directed_graph<r>::connectivity_address_type[]>(new typename multirelational_directed_graph<r>::connectivity_address_type[g.out_edge_count()+g.in_edge_count()+1]());
 	
 	for( size_t i = 0; i < g.vertex_count(); ++i ) {
 		g.vertices[ i ] = &g.edges[ out_v_temp[ i ] ];
@@ -39,6 +39,8 @@ class multirelational_graph {
 		typedef typename std::conditional<r<=CHAR_BIT*sizeof(std::size_t),std::size_t,boost::multiprecision::number<boost::multiprecision::cpp_int_backend<r,r,boost::multiprecision::unsigned_magnitude,boost::multiprecision::unchecked,void> > >::type connectivity_address_type;
 		multirelational_graph();
 		multirelational_graph( multirelational_graph const & );
+		template <std::size_t source_r,typename recode_type> multirelational_graph( multirelational_graph<source_r> const & g, recode_type const & recode );
+		multirelational_graph( multirelational_graph const & g, connectivity_address_type const & mask );
 		~multirelational_graph();
 		multirelational_graph & operator=( multirelational_graph const & );
 		std::size_t vertex_count() const;
@@ -64,17 +66,17 @@ class multirelational_graph {
 		std::size_t num_edges;
 		std::unique_ptr<void*[]> vertices;
 		std::unique_ptr<void*[]> edges;
-		std::unique_ptr<connectivity_address_type[]> edge_values;
+		std::unique_ptr<connectivity_address_type[]> edge_values; // one trailing zero so that edge_value( edges_end() ) reports an absent edge
 };
 
 template <std::size_t r>
-multirelational_graph<r>::multirelational_graph() : num_vertices(0), num_edges(0), vertices(std::unique_ptr<void*[]>(new void*[1])), edges(std::unique_ptr<void*[]>(new void*[1])), edge_values( std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new typename multirelational_graph<r>::connectivity_address_type[0])) {
+multirelational_graph<r>::multirelational_graph() : num_vertices(0), num_edges(0), vertices(std::unique_ptr<void*[]>(new void*[1])), edges(std::unique_ptr<void*[]>(new void*[1])), edge_values( std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new typename multirelational_graph<r>::connectivity_address_type[1]())) {
 	vertices[0] = &edges[0];
 	edges[0] = NULL;
 }
 
 template <std::size_t r>
-multirelational_graph<r>::multirelational_graph( multirelational_graph const & g ) : num_vertices(g.num_vertices), num_edges(g.num_edges), vertices(std::unique_ptr<void*[]>(new void*[g.vertex_count()+1])), edges(std::unique_ptr<void*[]>(new void*[g.num_edges+1])), edge_values( std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new multirelational_graph<r>::connectivity_address_type[g.num_edges])) {
+multirelational_graph<r>::multirelational_graph( multirelational_graph const & g ) : num_vertices(g.num_vertices), num_edges(g.num_edges), vertices(std::unique_ptr<void*[]>(new void*[g.vertex_count()+1])), edges(std::unique_ptr<void*[]>(new void*[g.num_edges+1])), edge_values( std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new multirelational_graph<r>::connectivity_address_type[g.num_edges+1]())) {
 	for( const_vertex_iterator it = g.vertices_begin(); it != g.vertices_end(); ++it ) {
 		vertices[ g.vertex_id( it ) ] = &edges[ g.edge_id( g.neighbors_begin( it ) ) ];
 	}
@@ -86,6 +88,44 @@ multirelational_graph<r>::multirelational_graph( multirelational_graph const & g
 	edges[ num_edges ] = NULL;
 }
 
+template <std::size_t r>
+template <std::size_t source_r,typename recode_type>
+multirelational_graph<r>::multirelational_graph( multirelational_graph<source_r> const & g, recode_type const & recode ) : num_vertices(g.vertex_count()), num_edges(g.edges_end()-g.edges_begin()), vertices(std::unique_ptr<void*[]>(new void*[g.vertex_count()+1])), edges(std::unique_ptr<void*[]>(new void*[num_edges+1])), edge_values( std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new multirelational_graph<r>::connectivity_address_type[num_edges+1]())) { // the structure of g with each edge value v replaced by recode( v )
+	for( const_vertex_iterator it = g.vertices_begin(); it != g.vertices_end(); ++it ) {
+		vertices[ g.vertex_id( it ) ] = &edges[ g.edge_id( g.neighbors_begin( it ) ) ];
+	}
+	vertices[ vertex_count() ] = &edges[ num_edges ];
+	for( const_edge_iterator it = g.edges_begin(); it != g.edges_end(); ++it ) {
+		edges[ g.edge_id( it ) ] = &vertices[ g.vertex_id( g.target_of( it ) ) ];
+		edge_values[ g.edge_id( it ) ] = recode( g.edge_value( it ) );
+	}
+	edges[ num_edges ] = NULL;
+}
+
+template <std::size_t r>
+multirelational_graph<r>::multirelational_graph( multirelational_graph const & g, connectivity_address_type const & mask ) : num_vertices(g.vertex_count()), num_edges(0), vertices(std::unique_ptr<void*[]>(new void*[g.vertex_count()+1])) { // the projection of g onto the relations in mask, without the edges that carry none of them
+	for( const_edge_iterator it = g.edges_begin(); it != g.edges_end(); ++it ) {
+		if( (g.edge_value( it ) & mask) != 0 ) {
+			++num_edges;
+		}
+	}
+	edges = std::unique_ptr<void*[]>(new void*[num_edges+1]);
+	edge_values = std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new typename multirelational_graph<r>::connectivity_address_type[num_edges+1]());
+	edge_id_t id( 0 );
+	for( const_vertex_iterator vIt = g.vertices_begin(); vIt != g.vertices_end(); ++vIt ) {
+		vertices[ g.vertex_id( vIt ) ] = &edges[ id ];
+		for( const_edge_iterator it = g.neighbors_begin( vIt ); it != g.neighbors_end( vIt ); ++it ) {
+			connectivity_address_type const value( g.edge_value( it ) & mask );
+			if( value != 0 ) {
+				edges[ id ] = &vertices[ g.vertex_id( g.target_of( it ) ) ];
+				edge_values[ id++ ] = value;
+			}
+		}
+	}
+	vertices[ vertex_count() ] = &edges[ num_edges ];
+	edges[ num_edges ] = NULL;
+}
+
 template <std::size_t r>
 multirelational_graph<r>::~multirelational_graph() {
 }
@@ -97,7 +137,7 @@ multirelational_graph<r> & multirelational_graph<r>::operator=( multirelational_
 		num_edges = g.num_edges;
 		vertices = std::unique_ptr<void*[]>(new void*[ g.vertex_count()+1 ]);
 		edges = std::unique_ptr<void*[]>(new void*[ g.num_edges+1 ]);
-		edge_values = std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new multirelational_graph<r>::connectivity_address_type[g.num_edges]);
+		edge_values = std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new multirelational_graph<r>::connectivity_address_type[g.num_edges+1]());
 		for( const_vertex_iterator it = g.vertices_begin(); it != g.vertices_end(); ++it ) {
 			vertex_id_t id = g.vertex_id( it );
 			vertices[ id ] = &edges[ g.edge_id( g.neighbors_begin( it ) ) ];
@@ -247,7 +287,7 @@ std::istream & operator>>( std::istream & is, multirelational_graph<r> & g ) {
 
 	g.vertices = std::unique_ptr<void*[]>(new void*[ g.vertex_count() + 1 ]);
 	g.edges = std::unique_ptr<void*[]>(new void*[ g.num_edges + 1 ]);
-	g.edge_values = std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new typename multirelational_graph<r>::connectivity_address_type[g.num_edges]);
+	g.edge_values = std::unique_ptr<typename multirelational_graph<r>::connectivity_address_type[]>(new typename multirelational_graph<r>::connectivity_address_type[g.num_edges+1]());
 
 	for( size_t i( 0 ); i < g.vertex_count(); ++i ) {
 		g.vertices[ i ] = &g.edges[ v_temp[ i ] ];
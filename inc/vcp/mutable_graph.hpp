@@ -0,0 +1,460 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_MUTABLE_GRAPH
+#define VCP_MUTABLE_GRAPH
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <vcp/directed_graph.hpp>
+#include <vcp/graph.hpp>
+#include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/multirelational_graph.hpp>
+#include <vcp/vcp.hpp>
+
+namespace vcp {
+
+// the insertion or deletion of one relation on the arc from source to target, or for d=0 on the edge between them
+struct edge_update {
+	vertex_id_t source;
+	vertex_id_t target;
+	std::size_t relation; // 0 when r=1
+	bool insertion;
+};
+
+template <typename value_type> value_type updated_value( value_type value, edge_update const & update );
+
+template <typename value_type>
+value_type updated_value( value_type value, edge_update const & update ) {
+	value_type const relation( value_type( 1 ) << update.relation );
+	return update.insertion ? value | relation : value & ~relation;
+}
+
+// a CSR graph that accepts edge updates: each vertex has sorted buffers of the arcs changed since the graph was last compacted, which override those of the immutable base, and compaction rebuilds the base in the background. Versions are published whole, so a reader holding a view sees one consistent graph however the graph changes afterwards
+template <std::size_t r,bool d>
+class mutable_graph {
+	public:
+		typedef typename std::conditional< d,
+				typename std::conditional< (r>1), multirelational_directed_graph<r>, directed_graph >::type,
+				typename std::conditional< (r>1), multirelational_graph<r>, graph >::type
+				>::type graph_type;
+		typedef typename multirelational_graph<r>::connectivity_address_type connectivity_address_type;
+		typedef std::pair<vertex_id_t,connectivity_address_type> arc_type; // neighbor and value; changed arcs of value 0 delete arcs of the base
+		class arc_iterator;
+		class view;
+		explicit mutable_graph( std::shared_ptr<graph_type const> base );
+		~mutable_graph();
+		view current() const;
+		void apply( edge_update const & update );
+		void apply( std::vector<edge_update> const & updates ); // published as one version
+		void compact(); // starts rebuilding the base from the current version unless that is under way; updates applied meanwhile are carried over
+		void wait(); // for a compaction to be published, rethrowing its failure
+		bool compacting() const;
+	private:
+		constexpr static const std::size_t chunk_size = 256;
+		typedef std::array<std::shared_ptr<std::vector<arc_type> const>,chunk_size> chunk_type;
+		typedef std::vector<std::shared_ptr<chunk_type const> > buffers_type; // the buffers of each run of chunk_size vertices, shared between versions unless changed, so that publishing copies one chunk rather than every buffer
+		struct version {
+			std::shared_ptr<graph_type const> base;
+			buffers_type out; // arcs from each vertex; for d=0 every changed edge is in the buffers of both endpoints
+			buffers_type in; // arcs into each vertex, for d=1
+			std::size_t arcs; // in the out buffers
+			std::uint64_t epoch;
+		};
+		std::shared_ptr<version const> published; // swapped atomically
+		mutable std::mutex writer; // serializes publication
+		std::thread compactor;
+		bool compacting_;
+		std::exception_ptr failure;
+		std::vector<edge_update> pending; // applied since the compaction in progress started
+		static void initialize( version & next, std::shared_ptr<graph_type const> base );
+		static void change( version & next, edge_update const & update );
+		static std::size_t change( buffers_type & buffers, vertex_id_t v, arc_type const & arc ); // the number of arcs added to the buffer
+		void publish( std::shared_ptr<version> next );
+};
+
+// the arcs of a vertex in ascending order of neighbor, merged from the base and the changed arcs
+template <std::size_t r,bool d>
+class mutable_graph<r,d>::arc_iterator : public std::iterator<std::forward_iterator_tag,arc_type const> {
+	public:
+		arc_iterator( graph_type const & g, const_edge_iterator base, const_edge_iterator base_end, typename std::vector<arc_type>::const_iterator changed, typename std::vector<arc_type>::const_iterator changed_end );
+		arc_type const & operator*() const;
+		arc_type const * operator->() const;
+		arc_iterator & operator++();
+		bool operator==( arc_iterator const & other ) const;
+		bool operator!=( arc_iterator const & other ) const;
+	private:
+		graph_type const * g;
+		const_edge_iterator base;
+		const_edge_iterator base_end;
+		typename std::vector<arc_type>::const_iterator changed;
+		typename std::vector<arc_type>::const_iterator changed_end;
+		arc_type arc;
+		bool done;
+		void next(); // consumes the arcs up to and including the next present one
+};
+
+// one published version of the graph, kept alive for as long as the view is held
+template <std::size_t r,bool d>
+class mutable_graph<r,d>::view {
+	public:
+		std::size_t vertex_count() const;
+		std::uint64_t epoch() const; // increases with every published version
+		std::shared_ptr<graph_type const> base() const; // the graph as of the last compaction, over which the VCP classes can be constructed
+		std::size_t changed_arcs() const; // since the last compaction
+		connectivity_address_type value( vertex_id_t source, vertex_id_t target ) const;
+		arc_iterator out_arcs_begin( vertex_id_t v ) const; // all arcs of v for d=0
+		arc_iterator out_arcs_end( vertex_id_t v ) const;
+		arc_iterator in_arcs_begin( vertex_id_t v ) const; // d=1 only
+		arc_iterator in_arcs_end( vertex_id_t v ) const;
+		void write( std::ostream & os ) const; // in the adjacency format read by the graph classes
+	private:
+		friend class mutable_graph<r,d>;
+		explicit view( std::shared_ptr<version const> state );
+		std::shared_ptr<version const> state;
+		static std::vector<arc_type> const none;
+		std::vector<arc_type> const & changed( buffers_type const & buffers, vertex_id_t v ) const;
+		const_edge_iterator base_begin( vertex_id_t v, bool out, std::false_type ) const;
+		const_edge_iterator base_end( vertex_id_t v, bool out, std::false_type ) const;
+		const_edge_iterator base_begin( vertex_id_t v, bool out, std::true_type ) const;
+		const_edge_iterator base_end( vertex_id_t v, bool out, std::true_type ) const;
+		static void write_arc( std::ostream & os, arc_type const & arc, std::true_type ); // a bare neighbor id for r=1
+		static void write_arc( std::ostream & os, arc_type const & arc, std::false_type );
+};
+
+template <std::size_t r,bool d>
+constexpr const std::size_t mutable_graph<r,d>::chunk_size;
+
+template <std::size_t r,bool d>
+std::vector<typename mutable_graph<r,d>::arc_type> const mutable_graph<r,d>::view::none;
+
+template <std::size_t r,bool d>
+mutable_graph<r,d>::mutable_graph( std::shared_ptr<graph_type const> base ) : compacting_( false ) {
+	std::shared_ptr<version> initial( new version() );
+	initialize( *initial, base );
+	initial->epoch = 0;
+	published = initial;
+}
+
+template <std::size_t r,bool d>
+mutable_graph<r,d>::~mutable_graph() {
+	if( compactor.joinable() ) {
+		compactor.join();
+	}
+}
+
+template <std::size_t r,bool d>
+typename mutable_graph<r,d>::view mutable_graph<r,d>::current() const {
+	return view( std::atomic_load( &published ) );
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::apply( edge_update const & update ) {
+	apply( std::vector<edge_update>( 1, update ) );
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::apply( std::vector<edge_update> const & updates ) {
+	std::lock_guard<std::mutex> lock( writer );
+	std::shared_ptr<version> next( new version( *published ) ); // buffers are shared with the previous version until changed
+	for( std::vector<edge_update>::const_iterator it( updates.begin() ); it != updates.end(); ++it ) {
+		if( it->source >= next->base->vertex_count() || it->target >= next->base->vertex_count() ) {
+			throw std::out_of_range( "vertex id " + std::to_string( std::max( it->source, it->target ) ) + " is not in the graph" );
+		}
+		if( it->source == it->target || it->relation >= r ) {
+			throw std::invalid_argument( "an update joins two distinct vertices by one of the " + std::to_string( r ) + " relations" );
+		}
+		change( *next, *it );
+	}
+	if( compacting_ ) {
+		pending.insert( pending.end(), updates.begin(), updates.end() );
+	}
+	publish( next );
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::compact() {
+	std::lock_guard<std::mutex> lock( writer );
+	if( compacting_ ) {
+		return;
+	}
+	if( compactor.joinable() ) { // the last compaction has been published
+		compactor.join();
+	}
+	compacting_ = true;
+	pending.clear();
+	std::shared_ptr<version const> source( published );
+	compactor = std::thread( [this,source]() {
+		try {
+			std::stringstream text; // the graph classes are built by their own readers, so a compacted base is laid out exactly as if it were loaded
+			view( source ).write( text );
+			std::shared_ptr<graph_type> base( new graph_type() );
+			text >> *base;
+			std::lock_guard<std::mutex> lock( writer );
+			std::shared_ptr<version> next( new version() );
+			initialize( *next, base );
+			for( std::vector<edge_update>::const_iterator it( pending.begin() ); it != pending.end(); ++it ) {
+				change( *next, *it );
+			}
+			pending.clear();
+			publish( next );
+			compacting_ = false;
+		} catch( ... ) {
+			std::lock_guard<std::mutex> lock( writer );
+			failure = std::current_exception();
+			compacting_ = false;
+		}
+	} );
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::wait() {
+	if( compactor.joinable() ) {
+		compactor.join();
+	}
+	std::lock_guard<std::mutex> lock( writer );
+	if( failure ) {
+		std::exception_ptr thrown( failure );
+		failure = nullptr;
+		std::rethrow_exception( thrown );
+	}
+}
+
+template <std::size_t r,bool d>
+bool mutable_graph<r,d>::compacting() const {
+	std::lock_guard<std::mutex> lock( writer );
+	return compacting_;
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::initialize( version & next, std::shared_ptr<graph_type const> base ) {
+	next.base = base;
+	next.out.assign( (base->vertex_count() + chunk_size - 1) / chunk_size, std::shared_ptr<chunk_type const>() );
+	next.in.assign( d ? next.out.size() : 0, std::shared_ptr<chunk_type const>() );
+	next.arcs = 0;
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::change( version & next, edge_update const & update ) {
+	connectivity_address_type const value( updated_value( view( std::shared_ptr<version const>( std::shared_ptr<version const>(), &next ) ).value( update.source, update.target ), update ) ); // through a view that does not own the version
+	next.arcs += change( next.out, update.source, arc_type( update.target, value ) );
+	if( d ) {
+		change( next.in, update.target, arc_type( update.source, value ) );
+	} else {
+		next.arcs += change( next.out, update.target, arc_type( update.source, value ) );
+	}
+}
+
+template <std::size_t r,bool d>
+std::size_t mutable_graph<r,d>::change( buffers_type & buffers, vertex_id_t v, arc_type const & arc ) { // copies the chunk and the buffer, which other versions may hold
+	std::shared_ptr<chunk_type const> const & old_chunk( buffers[ v / chunk_size ] );
+	std::shared_ptr<chunk_type> chunk( old_chunk ? new chunk_type( *old_chunk ) : new chunk_type() );
+	std::shared_ptr<std::vector<arc_type> const> const & old_arcs( (*chunk)[ v % chunk_size ] );
+	std::shared_ptr<std::vector<arc_type> > arcs( old_arcs ? new std::vector<arc_type>( *old_arcs ) : new std::vector<arc_type>() );
+	typename std::vector<arc_type>::iterator position( std::lower_bound( arcs->begin(), arcs->end(), arc, []( arc_type const & a, arc_type const & b ) { return a.first < b.first; } ) );
+	std::size_t added( 0 );
+	if( position != arcs->end() && position->first == arc.first ) {
+		position->second = arc.second;
+	} else {
+		arcs->insert( position, arc );
+		added = 1;
+	}
+	(*chunk)[ v % chunk_size ] = arcs;
+	buffers[ v / chunk_size ] = chunk;
+	return added;
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::publish( std::shared_ptr<version> next ) {
+	next->epoch = published->epoch + 1;
+	std::atomic_store( &published, std::shared_ptr<version const>( next ) );
+}
+
+template <std::size_t r,bool d>
+mutable_graph<r,d>::arc_iterator::arc_iterator( graph_type const & g, const_edge_iterator base, const_edge_iterator base_end, typename std::vector<arc_type>::const_iterator changed, typename std::vector<arc_type>::const_iterator changed_end ) : g( &g ), base( base ), base_end( base_end ), changed( changed ), changed_end( changed_end ), arc( 0, 0 ), done( false ) {
+	next();
+}
+
+template <std::size_t r,bool d>
+typename mutable_graph<r,d>::arc_type const & mutable_graph<r,d>::arc_iterator::operator*() const {
+	return arc;
+}
+
+template <std::size_t r,bool d>
+typename mutable_graph<r,d>::arc_type const * mutable_graph<r,d>::arc_iterator::operator->() const {
+	return &arc;
+}
+
+template <std::size_t r,bool d>
+typename mutable_graph<r,d>::arc_iterator & mutable_graph<r,d>::arc_iterator::operator++() {
+	next();
+	return *this;
+}
+
+template <std::size_t r,bool d>
+bool mutable_graph<r,d>::arc_iterator::operator==( arc_iterator const & other ) const {
+	return done == other.done && (done || (base == other.base && changed == other.changed));
+}
+
+template <std::size_t r,bool d>
+bool mutable_graph<r,d>::arc_iterator::operator!=( arc_iterator const & other ) const {
+	return !(*this == other);
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::arc_iterator::next() {
+	while( base != base_end || changed != changed_end ) {
+		if( changed != changed_end && (base == base_end || changed->first <= g->vertex_id( g->target_of( base ) )) ) {
+			if( base != base_end && changed->first == g->vertex_id( g->target_of( base ) ) ) { // a changed arc overrides the arc of the base
+				++base;
+			}
+			arc = *changed++;
+		} else {
+			arc = arc_type( g->vertex_id( g->target_of( base ) ), edge_value( *g, base ) );
+			++base;
+		}
+		if( arc.second != 0 ) {
+			return;
+		}
+	}
+	done = true;
+}
+
+template <std::size_t r,bool d>
+mutable_graph<r,d>::view::view( std::shared_ptr<version const> state ) : state( state ) {
+}
+
+template <std::size_t r,bool d>
+std::size_t mutable_graph<r,d>::view::vertex_count() const {
+	return state->base->vertex_count();
+}
+
+template <std::size_t r,bool d>
+std::uint64_t mutable_graph<r,d>::view::epoch() const {
+	return state->epoch;
+}
+
+template <std::size_t r,bool d>
+std::shared_ptr<typename mutable_graph<r,d>::graph_type const> mutable_graph<r,d>::view::base() const {
+	return state->base;
+}
+
+template <std::size_t r,bool d>
+std::size_t mutable_graph<r,d>::view::changed_arcs() const {
+	return state->arcs;
+}
+
+template <std::size_t r,bool d>
+typename mutable_graph<r,d>::connectivity_address_type mutable_graph<r,d>::view::value( vertex_id_t source, vertex_id_t target ) const {
+	std::vector<arc_type> const & arcs( changed( state->out, source ) );
+	typename std::vector<arc_type>::const_iterator it( std::lower_bound( arcs.begin(), arcs.end(), arc_type( target, 0 ), []( arc_type const & a, arc_type const & b ) { return a.first < b.first; } ) );
+	if( it != arcs.end() && it->first == target ) {
+		return it->second;
+	}
+	graph_type const & g( *state->base );
+	const_vertex_iterator const target_vertex( g.vertices_begin() + target );
+	const_edge_iterator const end( base_end( source, true, std::integral_constant<bool,d>() ) );
+	const_edge_iterator const edge( std::lower_bound( base_begin( source, true, std::integral_constant<bool,d>() ), end, target_vertex, [&g]( void * const & edge, const_vertex_iterator vertex ) { return g.target_of( &edge ) < vertex; } ) ); // neighbors are sorted
+	return edge != end && g.target_of( edge ) == target_vertex ? connectivity_address_type( edge_value( g, edge ) ) : connectivity_address_type( 0 );
+}
+
+template <std::size_t r,bool d>
+typename mutable_graph<r,d>::arc_iterator mutable_graph<r,d>::view::out_arcs_begin( vertex_id_t v ) const {
+	std::vector<arc_type> const & arcs( changed( state->out, v ) );
+	return arc_iterator( *state->base, base_begin( v, true, std::integral_constant<bool,d>() ), base_end( v, true, std::integral_constant<bool,d>() ), arcs.begin(), arcs.end() );
+}
+
+template <std::size_t r,bool d>
+typename mutable_graph<r,d>::arc_iterator mutable_graph<r,d>::view::out_arcs_end( vertex_id_t v ) const {
+	std::vector<arc_type> const & arcs( changed( state->out, v ) );
+	return arc_iterator( *state->base, base_end( v, true, std::integral_constant<bool,d>() ), base_end( v, true, std::integral_constant<bool,d>() ), arcs.end(), arcs.end() );
+}
+
+template <std::size_t r,bool d>
+typename mutable_graph<r,d>::arc_iterator mutable_graph<r,d>::view::in_arcs_begin( vertex_id_t v ) const {
+	static_assert( d, "undirected graphs have out arcs only" );
+	std::vector<arc_type> const & arcs( changed( state->in, v ) );
+	return arc_iterator( *state->base, base_begin( v, false, std::integral_constant<bool,d>() ), base_end( v, false, std::integral_constant<bool,d>() ), arcs.begin(), arcs.end() );
+}
+
+template <std::size_t r,bool d>
+typename mutable_graph<r,d>::arc_iterator mutable_graph<r,d>::view::in_arcs_end( vertex_id_t v ) const {
+	static_assert( d, "undirected graphs have out arcs only" );
+	std::vector<arc_type> const & arcs( changed( state->in, v ) );
+	return arc_iterator( *state->base, base_end( v, false, std::integral_constant<bool,d>() ), base_end( v, false, std::integral_constant<bool,d>() ), arcs.end(), arcs.end() );
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::view::write( std::ostream & os ) const {
+	for( vertex_id_t v( 0 ); v < vertex_count(); ++v ) {
+		for( arc_iterator it( out_arcs_begin( v ) ); it != out_arcs_end( v ); ++it ) {
+			os << (it == out_arcs_begin( v ) ? "" : " ");
+			write_arc( os, *it, std::integral_constant<bool,r == 1>() );
+		}
+		os << '\n';
+	}
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::view::write_arc( std::ostream & os, arc_type const & arc, std::true_type ) {
+	os << arc.first;
+}
+
+template <std::size_t r,bool d>
+void mutable_graph<r,d>::view::write_arc( std::ostream & os, arc_type const & arc, std::false_type ) {
+	os << arc.first << ',' << arc.second;
+}
+
+template <std::size_t r,bool d>
+std::vector<typename mutable_graph<r,d>::arc_type> const & mutable_graph<r,d>::view::changed( buffers_type const & buffers, vertex_id_t v ) const {
+	std::shared_ptr<chunk_type const> const & chunk( buffers[ v / chunk_size ] );
+	return chunk && (*chunk)[ v % chunk_size ] ? *(*chunk)[ v % chunk_size ] : none;
+}
+
+template <std::size_t r,bool d>
+const_edge_iterator mutable_graph<r,d>::view::base_begin( vertex_id_t v, bool, std::false_type ) const {
+	return state->base->neighbors_begin( state->base->vertices_begin() + v );
+}
+
+template <std::size_t r,bool d>
+const_edge_iterator mutable_graph<r,d>::view::base_end( vertex_id_t v, bool, std::false_type ) const {
+	return state->base->neighbors_end( state->base->vertices_begin() + v );
+}
+
+template <std::size_t r,bool d>
+const_edge_iterator mutable_graph<r,d>::view::base_begin( vertex_id_t v, bool out, std::true_type ) const {
+	return out ? state->base->out_neighbors_begin( state->base->vertices_begin() + v ) : state->base->in_neighbors_begin( state->base->vertices_begin() + v );
+}
+
+template <std::size_t r,bool d>
+const_edge_iterator mutable_graph<r,d>::view::base_end( vertex_id_t v, bool out, std::true_type ) const {
+	return out ? state->base->out_neighbors_end( state->base->vertices_begin() + v ) : state->base->in_neighbors_end( state->base->vertices_begin() + v );
+}
+
+}
+
+#endif
@@ -0,0 +1,296 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VCP_PAIR_COST_H
+#define VCP_PAIR_COST_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <vcp/graph.hpp>
+
+// engines report their work for the pair being profiled through VCP_PAIR_COST, which compiles to nothing unless VCP_INSTRUMENT is defined
+#ifdef VCP_INSTRUMENT
+#define VCP_PAIR_COST( metric, amount ) (::vcp::pair_cost::current().metric += (amount))
+#else
+#define VCP_PAIR_COST( metric, amount ) ((void)0)
+#endif
+
+namespace vcp {
+
+struct pair_cost {
+	constexpr static const std::size_t metric_count = 7;
+	vertex_id_t v1;
+	vertex_id_t v2;
+	std::uint64_t degree_v1;
+	std::uint64_t degree_v2;
+	std::uint64_t v3_candidates; // vertices adjacent to v1 or v2
+	std::uint64_t v4_candidates; // vertices adjacent only to v3 vertices
+	std::uint64_t merge_steps; // neighbor list entries visited while merging
+	std::uint64_t canonicalizations;
+	std::uint64_t nanoseconds;
+	std::uint64_t metric( std::size_t i ) const;
+	static char const * metric_name( std::size_t i );
+	static pair_cost & current(); // the pair being profiled on the calling thread
+};
+
+constexpr const std::size_t pair_cost::metric_count;
+
+std::uint64_t pair_cost::metric( std::size_t i ) const {
+	std::uint64_t const metrics[metric_count] = { degree_v1, degree_v2, v3_candidates, v4_candidates, merge_steps, canonicalizations, nanoseconds };
+	return metrics[i];
+}
+
+char const * pair_cost::metric_name( std::size_t i ) {
+	static char const * const names[metric_count] = { "degree_v1", "degree_v2", "v3_candidates", "v4_candidates", "merge_steps", "canonicalizations", "nanoseconds" };
+	return names[i];
+}
+
+pair_cost & pair_cost::current() {
+	thread_local pair_cost cost;
+	return cost;
+}
+
+// per-thread totals, log2 histograms, and the most expensive pairs; each recorder is written only by its own thread, so recording takes no lock except when a pair enters the top list
+class pair_cost_recorder {
+	public:
+		constexpr static const std::size_t bucket_count = 65; // bucket 0 counts zeros and bucket b counts values in [2^(b-1),2^b)
+		static pair_cost_recorder & local();
+		static void retain_top( std::size_t count );
+		static void write_summary( std::ostream & os, bool final );
+		void record( pair_cost const & cost );
+	private:
+		std::atomic<std::uint64_t> pairs;
+		std::atomic<std::uint64_t> sums[pair_cost::metric_count];
+		std::atomic<std::uint64_t> maxima[pair_cost::metric_count];
+		std::atomic<std::uint64_t> histograms[pair_cost::metric_count][bucket_count];
+		std::mutex top_mutex;
+		std::vector<pair_cost> top; // min-heap on nanoseconds
+		std::uint64_t top_floor; // the time a pair must exceed to enter a full top list
+		pair_cost_recorder();
+		static std::vector<std::unique_ptr<pair_cost_recorder> > & recorders();
+		static std::mutex & recorders_mutex();
+		static std::atomic<std::size_t> & top_count();
+		static bool more_expensive( pair_cost const & a, pair_cost const & b );
+		static void add( std::atomic<std::uint64_t> & total, std::uint64_t value );
+		static std::size_t bucket( std::uint64_t value );
+};
+
+constexpr const std::size_t pair_cost_recorder::bucket_count;
+
+pair_cost_recorder::pair_cost_recorder() : pairs( 0 ), top_floor( 0 ) {
+	for( std::size_t i( 0 ); i < pair_cost::metric_count; ++i ) {
+		sums[i] = 0;
+		maxima[i] = 0;
+		for( std::size_t b( 0 ); b < bucket_count; ++b ) {
+			histograms[i][b] = 0;
+		}
+	}
+}
+
+std::vector<std::unique_ptr<pair_cost_recorder> > & pair_cost_recorder::recorders() { // recorders outlive their threads so that the final summary includes them
+	static std::vector<std::unique_ptr<pair_cost_recorder> > instances;
+	return instances;
+}
+
+std::mutex & pair_cost_recorder::recorders_mutex() {
+	static std::mutex instance;
+	return instance;
+}
+
+std::atomic<std::size_t> & pair_cost_recorder::top_count() {
+	static std::atomic<std::size_t> instance( 20 );
+	return instance;
+}
+
+pair_cost_recorder & pair_cost_recorder::local() {
+	thread_local pair_cost_recorder * recorder( nullptr );
+	if( recorder == nullptr ) {
+		std::lock_guard<std::mutex> lock( recorders_mutex() );
+		recorders().push_back( std::unique_ptr<pair_cost_recorder>( new pair_cost_recorder() ) );
+		recorder = recorders().back().get();
+	}
+	return *recorder;
+}
+
+void pair_cost_recorder::retain_top( std::size_t count ) {
+	top_count() = count;
+}
+
+bool pair_cost_recorder::more_expensive( pair_cost const & a, pair_cost const & b ) {
+	return a.nanoseconds > b.nanoseconds;
+}
+
+void pair_cost_recorder::add( std::atomic<std::uint64_t> & total, std::uint64_t value ) { // a single writer needs no read-modify-write instruction; atomicity only keeps concurrent summaries well defined
+	total.store( total.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+}
+
+std::size_t pair_cost_recorder::bucket( std::uint64_t value ) {
+	std::size_t b( 0 );
+	while( value != 0 ) {
+		value >>= 1;
+		++b;
+	}
+	return b;
+}
+
+void pair_cost_recorder::record( pair_cost const & cost ) {
+	add( pairs, 1 );
+	for( std::size_t i( 0 ); i < pair_cost::metric_count; ++i ) {
+		std::uint64_t value( cost.metric( i ) );
+		add( sums[i], value );
+		add( histograms[i][bucket( value )], 1 );
+		if( value > maxima[i].load( std::memory_order_relaxed ) ) {
+			maxima[i].store( value, std::memory_order_relaxed );
+		}
+	}
+	std::size_t capacity( top_count().load( std::memory_order_relaxed ) );
+	if( capacity != 0 && (top.size() < capacity || cost.nanoseconds > top_floor) ) {
+		std::lock_guard<std::mutex> lock( top_mutex );
+		top.push_back( cost );
+		std::push_heap( top.begin(), top.end(), more_expensive );
+		if( top.size() > capacity ) {
+			std::pop_heap( top.begin(), top.end(), more_expensive );
+			top.pop_back();
+		}
+		top_floor = top.front().nanoseconds;
+	}
+}
+
+void pair_cost_recorder::write_summary( std::ostream & os, bool final ) {
+	std::uint64_t pair_count( 0 );
+	std::uint64_t sum[pair_cost::metric_count] = {};
+	std::uint64_t maximum[pair_cost::metric_count] = {};
+	std::uint64_t histogram[pair_cost::metric_count][bucket_count] = {};
+	std::vector<pair_cost> expensive;
+	{
+		std::lock_guard<std::mutex> lock( recorders_mutex() );
+		for( std::size_t t( 0 ); t < recorders().size(); ++t ) {
+			pair_cost_recorder & recorder( *recorders()[t] );
+			pair_count += recorder.pairs.load( std::memory_order_relaxed );
+			for( std::size_t i( 0 ); i < pair_cost::metric_count; ++i ) {
+				sum[i] += recorder.sums[i].load( std::memory_order_relaxed );
+				maximum[i] = std::max( maximum[i], recorder.maxima[i].load( std::memory_order_relaxed ) );
+				for( std::size_t b( 0 ); b < bucket_count; ++b ) {
+					histogram[i][b] += recorder.histograms[i][b].load( std::memory_order_relaxed );
+				}
+			}
+			std::lock_guard<std::mutex> top_lock( recorder.top_mutex );
+			expensive.insert( expensive.end(), recorder.top.begin(), recorder.top.end() );
+		}
+	}
+	std::sort( expensive.begin(), expensive.end(), more_expensive );
+	expensive.resize( std::min( expensive.size(), top_count().load() ) );
+	std::uint64_t expensive_nanoseconds( 0 );
+	for( std::size_t p( 0 ); p < expensive.size(); ++p ) {
+		expensive_nanoseconds += expensive[p].nanoseconds;
+	}
+	std::size_t const time( pair_cost::metric_count - 1 );
+	os << "{\"final\":" << (final ? "true" : "false") << ",\"pairs\":" << pair_count << ",\"metrics\":{";
+	for( std::size_t i( 0 ); i < pair_cost::metric_count; ++i ) {
+		std::size_t used( bucket_count );
+		while( used > 1 && histogram[i][used - 1] == 0 ) {
+			--used;
+		}
+		os << (i == 0 ? "" : ",") << '"' << pair_cost::metric_name( i ) << "\":{\"sum\":" << sum[i] << ",\"max\":" << maximum[i] << ",\"mean\":" << (pair_count == 0 ? 0.0 : static_cast<double>( sum[i] ) / pair_count) << ",\"log2_histogram\":[";
+		for( std::size_t b( 0 ); b < used; ++b ) {
+			os << (b == 0 ? "" : ",") << histogram[i][b];
+		}
+		os << "]}";
+	}
+	os << "},\"top_pairs\":[";
+	for( std::size_t p( 0 ); p < expensive.size(); ++p ) {
+		os << (p == 0 ? "" : ",") << "{\"v1\":" << expensive[p].v1 << ",\"v2\":" << expensive[p].v2;
+		for( std::size_t i( 0 ); i < pair_cost::metric_count; ++i ) {
+			os << ",\"" << pair_cost::metric_name( i ) << "\":" << expensive[p].metric( i );
+		}
+		os << '}';
+	}
+	os << "],\"top_pairs_time_share\":" << (sum[time] == 0 ? 0.0 : static_cast<double>( expensive_nanoseconds ) / sum[time]) << '}' << std::endl;
+}
+
+// times one pair on the calling thread and records it, with whatever the engine reported through VCP_PAIR_COST, when the scope closes
+class pair_cost_scope {
+	public:
+		pair_cost_scope( vertex_id_t v1, vertex_id_t v2, std::size_t degree_v1, std::size_t degree_v2 );
+		~pair_cost_scope();
+	private:
+		std::chrono::steady_clock::time_point start;
+};
+
+pair_cost_scope::pair_cost_scope( vertex_id_t v1, vertex_id_t v2, std::size_t degree_v1, std::size_t degree_v2 ) {
+	pair_cost & cost( pair_cost::current() );
+	cost = pair_cost();
+	cost.v1 = v1;
+	cost.v2 = v2;
+	cost.degree_v1 = degree_v1;
+	cost.degree_v2 = degree_v2;
+	start = std::chrono::steady_clock::now();
+}
+
+pair_cost_scope::~pair_cost_scope() {
+	pair_cost & cost( pair_cost::current() );
+	cost.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+	pair_cost_recorder::local().record( cost );
+}
+
+// writes a summary to os whenever the process receives SIGUSR1, and a final one on destruction; construct it before starting other threads so that they inherit SIGUSR1 blocked and the signal is only ever taken here
+class pair_cost_reporter {
+	public:
+		pair_cost_reporter( std::ostream & os );
+		~pair_cost_reporter();
+	private:
+		std::ostream & os;
+		sigset_t signals;
+		std::atomic<bool> done;
+		std::thread reporter;
+		void run();
+};
+
+pair_cost_reporter::pair_cost_reporter( std::ostream & os ) : os( os ), done( false ) {
+	sigemptyset( &signals );
+	sigaddset( &signals, SIGUSR1 );
+	pthread_sigmask( SIG_BLOCK, &signals, nullptr );
+	reporter = std::thread( std::bind( &pair_cost_reporter::run, this ) );
+}
+
+pair_cost_reporter::~pair_cost_reporter() {
+	done = true;
+	pthread_kill( reporter.native_handle(), SIGUSR1 );
+	reporter.join();
+}
+
+void pair_cost_reporter::run() {
+	int signal;
+	bool final;
+	do {
+		sigwait( &signals, &signal );
+		final = done; // read once, so that a request racing with destruction is followed by the final summary
+		pair_cost_recorder::write_summary( os, final );
+	} while( !final );
+}
+
+}
+
+#endif
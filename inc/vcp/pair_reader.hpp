@@ -0,0 +1,232 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_PAIR_READER
+#define VCP_PAIR_READER
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vcp/graph.hpp>
+
+namespace vcp {
+
+enum class pair_encoding {
+	text,  // whitespace-separated decimal vertex ids
+	u32,   // packed little-endian uint32 v1, v2
+	u64    // packed little-endian uint64 v1, v2
+};
+
+pair_encoding parse_pair_encoding( std::string const & name );
+
+class pair_reader {
+	public:
+		pair_reader( int fd, pair_encoding encoding, std::size_t capacity = default_capacity );
+		pair_reader( pair_reader const & ) = delete;
+		pair_reader & operator=( pair_reader const & ) = delete;
+		~pair_reader();
+		bool next( vertex_id_t & v1, vertex_id_t & v2 );
+		bool mapped() const;
+		std::size_t size() const;
+		void get( std::size_t index, vertex_id_t & v1, vertex_id_t & v2 ) const;
+	private:
+		constexpr static const std::size_t default_capacity = 1 << 20;
+		int fd;
+		pair_encoding encoding;
+		std::size_t record_size;
+		unsigned char const * map;
+		std::size_t map_size;
+		std::size_t position;
+		std::size_t capacity;
+		std::unique_ptr<unsigned char[]> buffer;
+		std::size_t begin;
+		std::size_t end;
+		bool exhausted;
+		bool fill();
+		bool next_text( vertex_id_t & value );
+		std::string overflowed_token( vertex_id_t prefix );
+		bool next_binary( vertex_id_t & v1, vertex_id_t & v2 );
+		vertex_id_t decode( unsigned char const * bytes ) const;
+};
+
+pair_encoding parse_pair_encoding( std::string const & name ) {
+	if( name == "text" ) {
+		return pair_encoding::text;
+	} else if( name == "u32" ) {
+		return pair_encoding::u32;
+	} else if( name == "u64" ) {
+		return pair_encoding::u64;
+	}
+	throw std::invalid_argument( "unknown pair encoding: " + name );
+}
+
+pair_reader::pair_reader( int fd, pair_encoding encoding, std::size_t capacity ) : fd( fd ), encoding( encoding ), record_size( encoding == pair_encoding::u32 ? 8 : 16 ), map( nullptr ), map_size( 0 ), position( 0 ), capacity( capacity ), begin( 0 ), end( 0 ), exhausted( false ) {
+	struct stat status;
+	if( encoding != pair_encoding::text && fstat( fd, &status ) == 0 && S_ISREG( status.st_mode ) && status.st_size > 0 ) {
+		if( status.st_size % record_size != 0 ) {
+			throw std::runtime_error( "binary pair file size is not a multiple of the record size" );
+		}
+		void * address( mmap( nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0 ) );
+		if( address != MAP_FAILED ) {
+			map = static_cast<unsigned char const *>( address );
+			map_size = status.st_size;
+			madvise( address, map_size, MADV_SEQUENTIAL );
+			return;
+		}
+	}
+	buffer.reset( new unsigned char[capacity] );
+}
+
+pair_reader::~pair_reader() {
+	if( map != nullptr ) {
+		munmap( const_cast<unsigned char *>( map ), map_size );
+	}
+}
+
+bool pair_reader::mapped() const {
+	return map != nullptr;
+}
+
+std::size_t pair_reader::size() const {
+	return map_size / record_size;
+}
+
+void pair_reader::get( std::size_t index, vertex_id_t & v1, vertex_id_t & v2 ) const {
+	unsigned char const * record( map + index * record_size );
+	v1 = decode( record );
+	v2 = decode( record + record_size / 2 );
+}
+
+bool pair_reader::next( vertex_id_t & v1, vertex_id_t & v2 ) {
+	if( map != nullptr ) {
+		if( position == size() ) {
+			return false;
+		}
+		get( position++, v1, v2 );
+		return true;
+	} else if( encoding == pair_encoding::text ) {
+		return next_text( v1 ) && next_text( v2 );
+	}
+	return next_binary( v1, v2 );
+}
+
+bool pair_reader::fill() {
+	// moves unconsumed bytes to the front and appends whatever the descriptor yields
+	if( exhausted ) {
+		return false;
+	}
+	std::size_t remaining( end - begin );
+	for( std::size_t i( 0 ); i < remaining; ++i ) {
+		buffer[i] = buffer[begin + i];
+	}
+	begin = 0;
+	end = remaining;
+	for( ;; ) {
+		ssize_t count( ::read( fd, buffer.get() + end, capacity - end ) );
+		if( count < 0 ) {
+			if( errno == EINTR ) {
+				continue;
+			}
+			throw std::system_error( errno, std::system_category(), "read" );
+		}
+		if( count == 0 ) {
+			exhausted = true;
+		}
+		end += count;
+		return count > 0;
+	}
+}
+
+bool pair_reader::next_text( vertex_id_t & value ) {
+	for( ;; ) {
+		while( begin != end && (buffer[begin] == ' ' || buffer[begin] == '\n' || buffer[begin] == '\t' || buffer[begin] == '\r') ) {
+			++begin;
+		}
+		if( begin != end || !fill() ) {
+			break;
+		}
+	}
+	if( begin == end || static_cast<unsigned char>( buffer[begin] - '0' ) > 9 ) { // end of input or malformed input ends the stream, as with formatted extraction; an id too large for vertex_id_t is an error
+		return false;
+	}
+	value = 0;
+	for( ;; ) {
+		while( begin != end ) {
+			unsigned char digit( buffer[begin] - '0' );
+			if( digit > 9 ) {
+				return true;
+			}
+			if( value > (std::numeric_limits<vertex_id_t>::max() - digit) / 10 ) {
+				throw std::runtime_error( "vertex id " + overflowed_token( value ) + " is out of range" );
+			}
+			value = 10 * value + digit;
+			++begin;
+		}
+		if( !fill() ) {
+			return true;
+		}
+	}
+}
+
+std::string pair_reader::overflowed_token( vertex_id_t prefix ) { // the digits read so far followed by the rest of the token
+	std::string token( std::to_string( prefix ) );
+	for( ;; ) {
+		while( begin != end ) {
+			unsigned char digit( buffer[begin] - '0' );
+			if( digit > 9 ) {
+				return token;
+			}
+			token += static_cast<char>( '0' + digit );
+			++begin;
+		}
+		if( !fill() ) {
+			return token;
+		}
+	}
+}
+
+bool pair_reader::next_binary( vertex_id_t & v1, vertex_id_t & v2 ) {
+	while( end - begin < record_size ) {
+		if( !fill() ) {
+			if( end != begin ) {
+				throw std::runtime_error( "binary pair stream ends with a partial record" );
+			}
+			return false;
+		}
+	}
+	v1 = decode( buffer.get() + begin );
+	v2 = decode( buffer.get() + begin + record_size / 2 );
+	begin += record_size;
+	return true;
+}
+
+vertex_id_t pair_reader::decode( unsigned char const * bytes ) const {
+	std::uint64_t value( 0 );
+	for( std::size_t i( record_size / 2 ); i > 0; --i ) {
+		value = (value << 8) | bytes[i - 1];
+	}
+	return value;
+}
+
+}
+
+#endif
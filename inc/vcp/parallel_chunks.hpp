@@ -0,0 +1,83 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_PARALLEL_CHUNKS
+#define VCP_PARALLEL_CHUNKS
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <vcp/buffered_writer.hpp>
+
+namespace vcp {
+
+// calls worker( chunk, chunk_out ) for each chunk on one thread per worker and appends each chunk's output to out, in chunk order if ordered is set
+template <typename worker_type>
+void run_chunks( std::vector<worker_type> & workers, std::size_t chunk_count, buffered_writer & out, bool ordered ) {
+	if( workers.size() == 1 ) {
+		for( std::size_t chunk( 0 ); chunk < chunk_count; ++chunk ) {
+			workers[0]( chunk, out );
+		}
+		return;
+	}
+	std::atomic<std::size_t> next_chunk( 0 );
+	std::size_t next_commit( 0 );
+	bool failed( false );
+	std::exception_ptr failure;
+	std::mutex mutex;
+	std::condition_variable committed;
+	std::vector<std::thread> threads;
+	for( std::size_t i( 0 ); i < workers.size(); ++i ) {
+		threads.push_back( std::thread( [&,i]() {
+			buffered_writer chunk_out( -1, 1 << 16 );
+			try {
+				for( std::size_t chunk( next_chunk++ ); chunk < chunk_count; chunk = next_chunk++ ) {
+					workers[i]( chunk, chunk_out );
+					std::unique_lock<std::mutex> lock( mutex );
+					if( ordered ) {
+						committed.wait( lock, [&]() { return failed || next_commit == chunk; } );
+					}
+					if( failed ) {
+						return;
+					}
+					out.write( chunk_out.data(), chunk_out.size() );
+					chunk_out.clear();
+					++next_commit;
+					committed.notify_all();
+				}
+			} catch( ... ) {
+				std::lock_guard<std::mutex> lock( mutex );
+				if( !failed ) {
+					failed = true;
+					failure = std::current_exception();
+				}
+				next_chunk = chunk_count;
+				committed.notify_all();
+			}
+		} ) );
+	}
+	for( std::size_t i( 0 ); i < threads.size(); ++i ) {
+		threads[i].join();
+	}
+	if( failure ) {
+		std::rethrow_exception( failure );
+	}
+}
+
+}
+
+#endif
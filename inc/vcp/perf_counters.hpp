@@ -0,0 +1,255 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VCP_PERF_COUNTERS
+#define VCP_PERF_COUNTERS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace vcp {
+
+enum class perf_phase { load, precomputation, pairs, staging, classification, canonicalization, output }; // pairs covers reading or enumerating the pairs to profile
+
+// per-thread hardware counters, read with one system call per phase change and attributed to the phase being left; phases are entered by the engines whether or not counting is enabled, at the cost of a thread-local test when it is not
+class perf_counters {
+	public:
+		constexpr static const std::size_t phase_count = 7;
+		constexpr static const std::size_t event_count = 7;
+		static bool enable( std::vector<std::string> & unavailable ); // counts the calling thread and every thread that later enters a phase
+		static perf_phase enter( perf_phase phase ); // returns the phase left
+		static void reset();
+		static void write_summary( std::ostream & os ); // threads that entered phases must have finished or be idle
+		~perf_counters();
+	private:
+		std::vector<int> fds; // the first is the group leader
+		std::size_t slots[event_count]; // position of each event in a group read, or event_count if it could not be opened
+		perf_phase phase;
+		std::uint64_t last[event_count + 2]; // the group's enabled and running times, then its values
+		std::uint64_t totals[phase_count][event_count];
+		explicit perf_counters( perf_phase phase );
+		void sample( perf_phase next );
+		static perf_counters *& local();
+		static std::atomic<bool> & enabled();
+		static std::vector<std::unique_ptr<perf_counters> > & instances();
+		static std::mutex & instances_mutex();
+		static perf_counters * attach( perf_phase phase );
+		static int open( std::uint32_t type, std::uint64_t config, int group );
+		static char const * event_name( std::size_t event );
+		static char const * phase_name( std::size_t phase );
+};
+
+// enters a phase for the lifetime of the scope, then returns to the enclosing one
+class perf_phase_scope {
+	public:
+		explicit perf_phase_scope( perf_phase phase );
+		~perf_phase_scope();
+	private:
+		perf_phase previous;
+};
+
+constexpr const std::size_t perf_counters::phase_count;
+constexpr const std::size_t perf_counters::event_count;
+
+perf_counters::perf_counters( perf_phase phase ) : phase( phase ) {
+	static std::uint32_t const types[event_count] = { PERF_TYPE_SOFTWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE };
+	static std::uint64_t const configs[event_count] = {
+		PERF_COUNT_SW_TASK_CLOCK, // leads the group because it can be opened wherever the system call is permitted at all
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_CACHE_MISSES, // last level
+		PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+	std::memset( last, 0, sizeof( last ) );
+	std::memset( totals, 0, sizeof( totals ) );
+	for( std::size_t event( 0 ); event < event_count; ++event ) {
+		int fd( event == 0 || !fds.empty() ? open( types[event], configs[event], fds.empty() ? -1 : fds.front() ) : -1 );
+		slots[event] = fd < 0 ? event_count : fds.size();
+		if( fd >= 0 ) {
+			fds.push_back( fd );
+		}
+	}
+	if( !fds.empty() ) {
+		sample( phase );
+	}
+}
+
+perf_counters::~perf_counters() {
+	for( std::size_t i( fds.size() ); i-- > 0; ) {
+		close( fds[i] );
+	}
+}
+
+int perf_counters::open( std::uint32_t type, std::uint64_t config, int group ) {
+	perf_event_attr attributes;
+	std::memset( &attributes, 0, sizeof( attributes ) );
+	attributes.size = sizeof( attributes );
+	attributes.type = type;
+	attributes.config = config;
+	attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attributes.exclude_kernel = 1; // the reads themselves are not attributed to phases
+	attributes.exclude_hv = 1;
+	return syscall( SYS_perf_event_open, &attributes, 0, -1, group, 0 );
+}
+
+void perf_counters::sample( perf_phase next ) {
+	std::uint64_t values[event_count + 3]; // nr, then the layout of last
+	if( read( fds.front(), values, sizeof( values ) ) < static_cast<ssize_t>( (fds.size() + 3) * sizeof( std::uint64_t ) ) ) {
+		phase = next;
+		return;
+	}
+	std::uint64_t const enabled_time( values[1] - last[0] );
+	std::uint64_t const running_time( values[2] - last[1] );
+	for( std::size_t event( 0 ); event < event_count; ++event ) {
+		if( slots[event] != event_count ) {
+			std::uint64_t delta( values[3 + slots[event]] - last[2 + slots[event]] );
+			if( running_time != 0 && running_time < enabled_time ) { // the group was multiplexed with others for part of the interval
+				delta = static_cast<std::uint64_t>( static_cast<double>( delta ) * enabled_time / running_time );
+			}
+			totals[static_cast<std::size_t>( phase )][event] += delta;
+		}
+	}
+	std::memcpy( last, values + 1, (fds.size() + 2) * sizeof( std::uint64_t ) );
+	phase = next;
+}
+
+perf_counters *& perf_counters::local() {
+	thread_local perf_counters * counters( nullptr );
+	return counters;
+}
+
+std::atomic<bool> & perf_counters::enabled() {
+	static std::atomic<bool> instance( false );
+	return instance;
+}
+
+std::vector<std::unique_ptr<perf_counters> > & perf_counters::instances() { // counters outlive their threads so that the summary includes them
+	static std::vector<std::unique_ptr<perf_counters> > instance;
+	return instance;
+}
+
+std::mutex & perf_counters::instances_mutex() {
+	static std::mutex instance;
+	return instance;
+}
+
+perf_counters * perf_counters::attach( perf_phase phase ) {
+	std::unique_ptr<perf_counters> counters( new perf_counters( phase ) );
+	if( counters->fds.empty() ) {
+		return nullptr;
+	}
+	std::lock_guard<std::mutex> lock( instances_mutex() );
+	instances().push_back( std::move( counters ) );
+	return local() = instances().back().get();
+}
+
+bool perf_counters::enable( std::vector<std::string> & unavailable ) {
+	perf_counters * counters( attach( perf_phase::load ) );
+	unavailable.clear();
+	for( std::size_t event( 0 ); event < event_count; ++event ) {
+		if( counters == nullptr || counters->slots[event] == event_count ) {
+			unavailable.push_back( event_name( event ) );
+		}
+	}
+	enabled() = counters != nullptr;
+	return counters != nullptr;
+}
+
+perf_phase perf_counters::enter( perf_phase phase ) {
+	perf_counters * counters( local() );
+	if( counters == nullptr ) {
+		if( !enabled().load( std::memory_order_relaxed ) || (counters = attach( phase )) == nullptr ) {
+			return phase;
+		}
+	}
+	perf_phase const left( counters->phase );
+	if( left != phase ) {
+		counters->sample( phase );
+	}
+	return left;
+}
+
+void perf_counters::reset() {
+	std::lock_guard<std::mutex> lock( instances_mutex() );
+	for( std::size_t i( 0 ); i < instances().size(); ++i ) {
+		perf_counters & counters( *instances()[i] );
+		counters.sample( counters.phase );
+		std::memset( counters.totals, 0, sizeof( counters.totals ) );
+	}
+}
+
+void perf_counters::write_summary( std::ostream & os ) {
+	std::uint64_t totals[phase_count][event_count] = {};
+	bool counted[event_count] = {};
+	{
+		std::lock_guard<std::mutex> lock( instances_mutex() );
+		for( std::size_t i( 0 ); i < instances().size(); ++i ) {
+			perf_counters & counters( *instances()[i] );
+			counters.sample( counters.phase ); // attributes the remainder of each thread's last phase
+			for( std::size_t event( 0 ); event < event_count; ++event ) {
+				counted[event] = counted[event] || counters.slots[event] != event_count;
+				for( std::size_t phase( 0 ); phase < phase_count; ++phase ) {
+					totals[phase][event] += counters.totals[phase][event];
+				}
+			}
+		}
+	}
+	os << '{';
+	for( std::size_t phase( 0 ); phase < phase_count; ++phase ) {
+		os << (phase == 0 ? "" : ", ") << '"' << phase_name( phase ) << "\": {";
+		for( std::size_t event( 0 ); event < event_count; ++event ) {
+			os << (event == 0 ? "" : ", ") << '"' << event_name( event ) << "\": ";
+			if( counted[event] ) {
+				os << totals[phase][event];
+			} else {
+				os << "null";
+			}
+		}
+		os << '}';
+	}
+	os << '}';
+}
+
+char const * perf_counters::event_name( std::size_t event ) {
+	static char const * const names[event_count] = { "task_clock_ns", "cycles", "instructions", "l1d_read_misses", "llc_misses", "dtlb_read_misses", "branch_misses" };
+	return names[event];
+}
+
+char const * perf_counters::phase_name( std::size_t phase ) {
+	static char const * const names[phase_count] = { "load", "precomputation", "pairs", "staging", "classification", "canonicalization", "output" };
+	return names[phase];
+}
+
+perf_phase_scope::perf_phase_scope( perf_phase phase ) : previous( perf_counters::enter( phase ) ) {
+}
+
+perf_phase_scope::~perf_phase_scope() {
+	perf_counters::enter( previous );
+}
+
+}
+
+#endif
@@ -0,0 +1,779 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VCP_PROFILE_CACHE
+#define VCP_PROFILE_CACHE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <vcp/directed_graph.hpp>
+#include <vcp/graph.hpp>
+#include <vcp/graph_statistics.hpp>
+#include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/multirelational_graph.hpp>
+#include <vcp/vcp.hpp>
+#include <vcp/vcp_canonical_mapper.hpp>
+#include <vcp/vcp_dynamic_mapper.hpp>
+
+namespace vcp {
+
+// identifies a graph snapshot by its adjacency and edge values, so that profiles cached for one graph are never served for another
+std::uint64_t graph_fingerprint( graph const & g );
+std::uint64_t graph_fingerprint( directed_graph const & g );
+template <std::size_t r> std::uint64_t graph_fingerprint( multirelational_graph<r> const & g );
+template <std::size_t r> std::uint64_t graph_fingerprint( multirelational_directed_graph<r> const & g );
+
+struct profile_key {
+	std::uint64_t graph;
+	std::uint32_t n;
+	std::uint32_t r;
+	std::uint32_t d;
+	std::uint64_t v1;
+	std::uint64_t v2;
+	bool operator==( profile_key const & other ) const;
+	profile_key exchanged() const;
+};
+
+struct profile_key_hash {
+	std::size_t operator()( profile_key const & key ) const;
+};
+
+// serialized profiles keyed by graph, VCP class, and pair, held in a sharded LRU of bounded size whose evictions are appended to an optional on-disk store
+class profile_cache {
+	public:
+		enum class outcome { hit, swapped_hit, miss };
+		constexpr static const std::size_t shard_count = 16;
+		explicit profile_cache( std::size_t memory_bytes, std::string const & store_path = std::string() );
+		profile_cache( profile_cache const & ) = delete;
+		profile_cache & operator=( profile_cache const & ) = delete;
+		~profile_cache();
+		bool find( profile_key const & key, std::vector<unsigned char> & profile );
+		void insert( profile_key const & key, std::vector<unsigned char> const & profile );
+		void record( outcome result );
+		void flush(); // appends every profile not yet in the store
+		void write_summary( std::ostream & os ) const;
+	private:
+		struct entry {
+			profile_key key;
+			std::vector<unsigned char> profile;
+			bool stored;
+		};
+		struct shard {
+			std::mutex mutex;
+			std::list<entry> recency; // most recently used first
+			std::unordered_map<profile_key,std::list<entry>::iterator,profile_key_hash> entries;
+			std::size_t bytes = 0;
+		};
+		struct record_header { // precedes each profile in the store
+			std::uint64_t graph;
+			std::uint64_t v1;
+			std::uint64_t v2;
+			std::uint32_t n;
+			std::uint32_t r;
+			std::uint32_t d;
+			std::uint32_t length;
+			std::uint64_t checksum;
+		};
+		struct record_location {
+			std::uint64_t offset;
+			std::uint32_t length;
+			std::uint64_t checksum;
+		};
+		constexpr static const std::size_t entry_overhead = 128; // list node, hash bucket, and vector header
+		constexpr static const char magic[9] = "VCPCACH1";
+		std::size_t shard_bytes;
+		std::array<shard,shard_count> shards;
+		std::string store_path;
+		int fd; // -1 without a store
+		bool writable; // false when another process holds the store
+		unsigned char const * map; // records present when the store was opened; later ones are read with pread
+		std::size_t map_size;
+		std::uint64_t store_size;
+		mutable std::mutex store_mutex;
+		std::unordered_map<profile_key,record_location,profile_key_hash> store_index;
+		std::atomic<std::uint64_t> hits;
+		std::atomic<std::uint64_t> swapped_hits;
+		std::atomic<std::uint64_t> misses;
+		std::atomic<std::uint64_t> store_reads;
+		shard & shard_of( profile_key const & key );
+		void admit( shard & s, profile_key const & key, std::vector<unsigned char> const & profile, bool stored );
+		void open_store();
+		bool read_store( profile_key const & key, std::vector<unsigned char> & profile );
+		void append_store( profile_key const & key, std::vector<unsigned char> const & profile );
+		static std::uint64_t checksum( unsigned char const * data, std::size_t size );
+};
+
+// profiles of the pairs that a batch contains more than once, in either order, each kept from its first occurrence to its last
+class repeated_pairs {
+	public:
+		enum class share { unique, claimed, derived };
+		constexpr static const std::size_t shard_count = 16;
+		repeated_pairs();
+		repeated_pairs( repeated_pairs const & ) = delete;
+		repeated_pairs & operator=( repeated_pairs const & ) = delete;
+		void count( std::uint64_t v1, std::uint64_t v2 ); // once for every occurrence, before profiling begins
+		void seal(); // forgets the pairs that occur once
+		share acquire( std::uint64_t v1, std::uint64_t v2, std::vector<unsigned char> & profile, bool & reversed );
+		void publish( std::uint64_t v1, std::uint64_t v2, std::vector<unsigned char> const & profile );
+		std::uint64_t distinct() const;
+		std::uint64_t derived() const;
+	private:
+		typedef std::pair<std::uint64_t,std::uint64_t> pair_type; // (min, max)
+		struct pair_hash {
+			std::size_t operator()( pair_type const & pair ) const;
+		};
+		struct entry {
+			std::size_t remaining; // occurrences not yet served
+			bool claimed; // an occurrence is being profiled
+			bool ready;
+			bool reversed; // the profile is that of (max, min)
+			std::vector<unsigned char> profile;
+		};
+		struct shard { // entries are only inserted before profiling, so iterators stay valid while a thread waits
+			std::mutex mutex;
+			std::condition_variable published;
+			std::unordered_map<pair_type,entry,pair_hash> entries;
+		};
+		std::array<shard,shard_count> shards;
+		std::uint64_t repeated;
+		std::atomic<std::uint64_t> served;
+		shard & shard_of( pair_type const & pair );
+};
+
+// vcp<n,r,d> behind a profile_cache and repeated_pairs: a pair whose profile, or whose reversed pair's profile, is cached or was profiled earlier in the batch is served without profiling
+template <std::size_t n,std::size_t r,bool d>
+class cached_vcp {
+	public:
+		typedef vcp<n,r,d> engine_type;
+		typedef typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type subgraph_address_type;
+		constexpr static const std::size_t address_bytes = r == 1 ? 8 : (n*(n-1)*r*(d+1)/2 + 7) / 8; // element ids of dense vectors, otherwise canonical addresses
+		template <typename graph_type> cached_vcp( graph_type const & g, profile_cache * cache = nullptr, std::uint64_t fingerprint = 0, repeated_pairs * repeats = nullptr, graph_statistics<r,d> const * statistics = nullptr ); // statistics are taken by the n=4 engines
+		constexpr static std::size_t element_count();
+		template <typename output_type> void generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, output_type && output );
+	private:
+		engine_type profiler;
+		profile_cache * cache; // null to profile every pair
+		repeated_pairs * repeats; // null unless pairs of the batch are counted in advance
+		bool claimed; // this occurrence of a repeated pair is profiled for the others
+		const_vertex_iterator vertices;
+		profile_key key;
+		vcp_dynamic_mapper<n,r,d> mapper;
+		std::vector<std::size_t> exchanged_elements; // for r=1, the element each element becomes when the endpoints are exchanged
+		std::vector<unsigned char> profile;
+		std::vector<std::pair<subgraph_address_type,unsigned long> > entries;
+		template <typename graph_type> static engine_type engine( graph_type const & g, graph_statistics<r,d> const * statistics, std::true_type );
+		template <typename graph_type> static engine_type engine( graph_type const & g, graph_statistics<r,d> const * statistics, std::false_type );
+		void prepare( std::true_type );
+		void prepare( std::false_type );
+		template <typename iterator_type> void generate( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, std::true_type );
+		template <typename sink_type> void generate( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink, std::false_type );
+		bool lookup( const_vertex_iterator v1, const_vertex_iterator v2 );
+		void serialize();
+		void store();
+		void decode( bool exchanged );
+		subgraph_address_type exchange( subgraph_address_type const & address, std::true_type ) const;
+		subgraph_address_type exchange( subgraph_address_type const & address, std::false_type ) const;
+		static unsigned char address_byte( std::size_t address, std::size_t byte );
+		template <typename backend_type> static unsigned char address_byte( boost::multiprecision::number<backend_type> const & address, std::size_t byte );
+};
+
+std::uint64_t fingerprint_mix( std::uint64_t h, std::uint64_t value ) { // the splitmix64 finalizer over the running hash
+	h ^= value + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+	return h ^ (h >> 31);
+}
+
+template <typename backend_type>
+std::uint64_t fingerprint_mix( std::uint64_t h, boost::multiprecision::number<backend_type> value ) {
+	do {
+		h = fingerprint_mix( h, static_cast<boost::multiprecision::number<backend_type> >( value & std::numeric_limits<std::uint64_t>::max() ).template convert_to<std::uint64_t>() );
+		value >>= 64;
+	} while( value != 0 );
+	return h;
+}
+
+std::uint64_t graph_fingerprint( graph const & g ) {
+	std::uint64_t h( fingerprint_mix( 0, g.vertex_count() ) );
+	for( const_vertex_iterator v( g.vertices_begin() ); v != g.vertices_end(); ++v ) {
+		h = fingerprint_mix( h, g.neighbors_end( v ) - g.neighbors_begin( v ) );
+		for( const_edge_iterator it( g.neighbors_begin( v ) ); it != g.neighbors_end( v ); ++it ) {
+			h = fingerprint_mix( h, g.vertex_id( g.target_of( it ) ) );
+		}
+	}
+	return h;
+}
+
+std::uint64_t graph_fingerprint( directed_graph const & g ) { // in-edges mirror the out-edges
+	std::uint64_t h( fingerprint_mix( 0, g.vertex_count() ) );
+	for( const_vertex_iterator v( g.vertices_begin() ); v != g.vertices_end(); ++v ) {
+		h = fingerprint_mix( h, g.out_neighbors_end( v ) - g.out_neighbors_begin( v ) );
+		for( const_edge_iterator it( g.out_neighbors_begin( v ) ); it != g.out_neighbors_end( v ); ++it ) {
+			h = fingerprint_mix( h, g.vertex_id( g.target_of( it ) ) );
+		}
+	}
+	return h;
+}
+
+template <std::size_t r>
+std::uint64_t graph_fingerprint( multirelational_graph<r> const & g ) {
+	std::uint64_t h( fingerprint_mix( 0, g.vertex_count() ) );
+	for( const_vertex_iterator v( g.vertices_begin() ); v != g.vertices_end(); ++v ) {
+		h = fingerprint_mix( h, g.neighbors_end( v ) - g.neighbors_begin( v ) );
+		for( const_edge_iterator it( g.neighbors_begin( v ) ); it != g.neighbors_end( v ); ++it ) {
+			h = fingerprint_mix( fingerprint_mix( h, g.vertex_id( g.target_of( it ) ) ), g.edge_value( it ) );
+		}
+	}
+	return h;
+}
+
+template <std::size_t r>
+std::uint64_t graph_fingerprint( multirelational_directed_graph<r> const & g ) {
+	std::uint64_t h( fingerprint_mix( 0, g.vertex_count() ) );
+	for( const_vertex_iterator v( g.vertices_begin() ); v != g.vertices_end(); ++v ) {
+		h = fingerprint_mix( h, g.out_neighbors_end( v ) - g.out_neighbors_begin( v ) );
+		for( const_edge_iterator it( g.out_neighbors_begin( v ) ); it != g.out_neighbors_end( v ); ++it ) {
+			h = fingerprint_mix( fingerprint_mix( h, g.vertex_id( g.target_of( it ) ) ), g.edge_value( it ) );
+		}
+	}
+	return h;
+}
+
+bool profile_key::operator==( profile_key const & other ) const {
+	return graph == other.graph && n == other.n && r == other.r && d == other.d && v1 == other.v1 && v2 == other.v2;
+}
+
+profile_key profile_key::exchanged() const {
+	profile_key key( *this );
+	std::swap( key.v1, key.v2 );
+	return key;
+}
+
+std::size_t profile_key_hash::operator()( profile_key const & key ) const {
+	return fingerprint_mix( fingerprint_mix( fingerprint_mix( key.graph, (std::uint64_t( key.n ) << 32) | (key.r << 1) | key.d ), key.v1 ), key.v2 );
+}
+
+constexpr const std::size_t profile_cache::shard_count;
+constexpr const std::size_t profile_cache::entry_overhead;
+constexpr const char profile_cache::magic[9];
+
+profile_cache::profile_cache( std::size_t memory_bytes, std::string const & store_path ) : shard_bytes( memory_bytes / shard_count ), store_path( store_path ), fd( -1 ), writable( false ), map( nullptr ), map_size( 0 ), store_size( 0 ), hits( 0 ), swapped_hits( 0 ), misses( 0 ), store_reads( 0 ) {
+	static_assert( sizeof( record_header ) == 48, "store records have a fixed layout" );
+	if( !store_path.empty() ) {
+		open_store();
+	}
+}
+
+profile_cache::~profile_cache() {
+	if( map != nullptr ) {
+		munmap( const_cast<unsigned char *>( map ), map_size );
+	}
+	if( fd != -1 ) {
+		close( fd );
+	}
+}
+
+void profile_cache::open_store() { // a record cut short by an interrupted run is truncated away
+	fd = open( store_path.c_str(), O_RDWR | O_CREAT, 0644 );
+	if( fd == -1 ) {
+		throw std::system_error( errno, std::system_category(), "open " + store_path );
+	}
+	writable = flock( fd, LOCK_EX | LOCK_NB ) == 0;
+	struct stat status;
+	if( fstat( fd, &status ) == -1 ) {
+		throw std::system_error( errno, std::system_category(), "stat " + store_path );
+	}
+	std::size_t size( status.st_size );
+	if( size == 0 && writable ) {
+		if( pwrite( fd, magic, 8, 0 ) != 8 ) {
+			throw std::system_error( errno, std::system_category(), "write " + store_path );
+		}
+		size = 8;
+	}
+	if( size < 8 ) {
+		throw std::runtime_error( store_path + " is not a VCP profile cache" );
+	}
+	void * address( mmap( nullptr, size, PROT_READ, MAP_SHARED, fd, 0 ) );
+	if( address == MAP_FAILED ) {
+		throw std::system_error( errno, std::system_category(), "mmap " + store_path );
+	}
+	map = static_cast<unsigned char const *>( address );
+	map_size = size;
+	if( std::memcmp( map, magic, 8 ) != 0 ) {
+		throw std::runtime_error( store_path + " is not a VCP profile cache" );
+	}
+	std::uint64_t offset( 8 );
+	record_header header;
+	while( offset + sizeof( header ) <= size ) {
+		std::memcpy( &header, map + offset, sizeof( header ) );
+		if( offset + sizeof( header ) + header.length > size ) {
+			break;
+		}
+		profile_key key = { header.graph, header.n, header.r, header.d, header.v1, header.v2 };
+		record_location location = { offset + sizeof( header ), header.length, header.checksum };
+		store_index[key] = location;
+		offset += sizeof( header ) + header.length;
+	}
+	if( offset != size && writable && ftruncate( fd, offset ) == -1 ) {
+		throw std::system_error( errno, std::system_category(), "truncate " + store_path );
+	}
+	store_size = offset;
+}
+
+profile_cache::shard & profile_cache::shard_of( profile_key const & key ) {
+	return shards[profile_key_hash()( key ) % shard_count];
+}
+
+bool profile_cache::find( profile_key const & key, std::vector<unsigned char> & profile ) {
+	shard & s( shard_of( key ) );
+	{
+		std::lock_guard<std::mutex> lock( s.mutex );
+		std::unordered_map<profile_key,std::list<entry>::iterator,profile_key_hash>::iterator it( s.entries.find( key ) );
+		if( it != s.entries.end() ) {
+			s.recency.splice( s.recency.begin(), s.recency, it->second );
+			profile = it->second->profile;
+			return true;
+		}
+	}
+	if( !read_store( key, profile ) ) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock( s.mutex );
+	admit( s, key, profile, true );
+	return true;
+}
+
+void profile_cache::insert( profile_key const & key, std::vector<unsigned char> const & profile ) {
+	shard & s( shard_of( key ) );
+	std::lock_guard<std::mutex> lock( s.mutex );
+	admit( s, key, profile, false );
+}
+
+void profile_cache::admit( shard & s, profile_key const & key, std::vector<unsigned char> const & profile, bool stored ) { // the caller holds the shard's mutex
+	std::unordered_map<profile_key,std::list<entry>::iterator,profile_key_hash>::iterator it( s.entries.find( key ) );
+	if( it != s.entries.end() ) { // another thread profiled the same pair; profiles are deterministic
+		s.recency.splice( s.recency.begin(), s.recency, it->second );
+		return;
+	}
+	if( profile.size() + entry_overhead > shard_bytes ) { // larger than the shard itself
+		if( !stored ) {
+			append_store( key, profile );
+		}
+		return;
+	}
+	s.recency.push_front( entry{ key, profile, stored } );
+	s.entries[key] = s.recency.begin();
+	s.bytes += profile.size() + entry_overhead;
+	while( s.bytes > shard_bytes ) {
+		entry const & victim( s.recency.back() );
+		if( !victim.stored ) {
+			append_store( victim.key, victim.profile );
+		}
+		s.bytes -= victim.profile.size() + entry_overhead;
+		s.entries.erase( victim.key );
+		s.recency.pop_back();
+	}
+}
+
+bool profile_cache::read_store( profile_key const & key, std::vector<unsigned char> & profile ) {
+	std::lock_guard<std::mutex> lock( store_mutex );
+	std::unordered_map<profile_key,record_location,profile_key_hash>::const_iterator it( store_index.find( key ) );
+	if( it == store_index.end() ) {
+		return false;
+	}
+	record_location const location( it->second );
+	profile.resize( location.length );
+	if( location.offset + location.length <= map_size ) {
+		std::memcpy( profile.data(), map + location.offset, location.length );
+	} else {
+		for( std::size_t read( 0 ); read < location.length; ) {
+			ssize_t result( pread( fd, profile.data() + read, location.length - read, location.offset + read ) );
+			if( result == -1 && errno == EINTR ) {
+				continue;
+			}
+			if( result <= 0 ) {
+				throw std::system_error( result == 0 ? EIO : errno, std::system_category(), "read " + store_path );
+			}
+			read += result;
+		}
+	}
+	if( checksum( profile.data(), profile.size() ) != location.checksum ) { // a damaged record is profiled again
+		store_index.erase( it );
+		return false;
+	}
+	++store_reads;
+	return true;
+}
+
+void profile_cache::append_store( profile_key const & key, std::vector<unsigned char> const & profile ) {
+	if( !writable ) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock( store_mutex );
+	if( store_index.count( key ) != 0 ) {
+		return;
+	}
+	record_header header = { key.graph, key.v1, key.v2, key.n, key.r, key.d, static_cast<std::uint32_t>( profile.size() ), checksum( profile.data(), profile.size() ) };
+	std::vector<unsigned char> record( sizeof( header ) + profile.size() );
+	std::memcpy( record.data(), &header, sizeof( header ) );
+	std::copy( profile.begin(), profile.end(), record.begin() + sizeof( header ) );
+	for( std::size_t written( 0 ); written < record.size(); ) {
+		ssize_t result( pwrite( fd, record.data() + written, record.size() - written, store_size + written ) );
+		if( result == -1 ) {
+			if( errno == EINTR ) {
+				continue;
+			}
+			throw std::system_error( errno, std::system_category(), "write " + store_path );
+		}
+		written += result;
+	}
+	record_location location = { store_size + sizeof( header ), header.length, header.checksum };
+	store_index[key] = location;
+	store_size += record.size();
+}
+
+void profile_cache::flush() {
+	for( std::size_t i( 0 ); i < shard_count; ++i ) {
+		std::lock_guard<std::mutex> lock( shards[i].mutex );
+		for( std::list<entry>::iterator it( shards[i].recency.begin() ); it != shards[i].recency.end(); ++it ) {
+			if( !it->stored ) {
+				append_store( it->key, it->profile );
+				it->stored = true;
+			}
+		}
+	}
+	if( writable && fdatasync( fd ) == -1 ) {
+		throw std::system_error( errno, std::system_category(), "sync " + store_path );
+	}
+}
+
+void profile_cache::record( outcome result ) {
+	if( result == outcome::hit ) {
+		hits.fetch_add( 1, std::memory_order_relaxed );
+	} else if( result == outcome::swapped_hit ) {
+		swapped_hits.fetch_add( 1, std::memory_order_relaxed );
+	} else {
+		misses.fetch_add( 1, std::memory_order_relaxed );
+	}
+}
+
+void profile_cache::write_summary( std::ostream & os ) const {
+	std::size_t store_records( 0 );
+	{
+		std::lock_guard<std::mutex> lock( store_mutex );
+		store_records = store_index.size();
+	}
+	os << "{\"hits\": " << hits << ", \"swapped_hits\": " << swapped_hits << ", \"misses\": " << misses << ", \"store_reads\": " << store_reads << ", \"store_records\": " << store_records << '}';
+}
+
+std::uint64_t profile_cache::checksum( unsigned char const * data, std::size_t size ) { // FNV-1a
+	std::uint64_t h( 0xcbf29ce484222325ull );
+	for( std::size_t i( 0 ); i < size; ++i ) {
+		h = (h ^ data[i]) * 0x100000001b3ull;
+	}
+	return h;
+}
+
+constexpr const std::size_t repeated_pairs::shard_count;
+
+repeated_pairs::repeated_pairs() : repeated( 0 ), served( 0 ) {
+}
+
+std::size_t repeated_pairs::pair_hash::operator()( pair_type const & pair ) const {
+	return fingerprint_mix( fingerprint_mix( 0, pair.first ), pair.second );
+}
+
+repeated_pairs::shard & repeated_pairs::shard_of( pair_type const & pair ) {
+	return shards[pair_hash()( pair ) % shard_count];
+}
+
+void repeated_pairs::count( std::uint64_t v1, std::uint64_t v2 ) {
+	pair_type const pair( std::min( v1, v2 ), std::max( v1, v2 ) );
+	entry & e( shard_of( pair ).entries[pair] );
+	++e.remaining;
+}
+
+void repeated_pairs::seal() {
+	for( std::size_t i( 0 ); i < shard_count; ++i ) {
+		for( std::unordered_map<pair_type,entry,pair_hash>::iterator it( shards[i].entries.begin() ); it != shards[i].entries.end(); ) {
+			it = it->second.remaining < 2 ? shards[i].entries.erase( it ) : ++it;
+		}
+		repeated += shards[i].entries.size();
+	}
+}
+
+repeated_pairs::share repeated_pairs::acquire( std::uint64_t v1, std::uint64_t v2, std::vector<unsigned char> & profile, bool & reversed ) {
+	pair_type const pair( std::min( v1, v2 ), std::max( v1, v2 ) );
+	shard & s( shard_of( pair ) );
+	std::unique_lock<std::mutex> lock( s.mutex );
+	std::unordered_map<pair_type,entry,pair_hash>::iterator it( s.entries.find( pair ) );
+	if( it == s.entries.end() ) {
+		return share::unique;
+	}
+	if( !it->second.claimed ) {
+		it->second.claimed = true;
+		return share::claimed;
+	}
+	s.published.wait( lock, [&it]() { return it->second.ready; } );
+	profile = it->second.profile;
+	reversed = it->second.reversed != (v1 > v2);
+	if( --it->second.remaining == 0 ) {
+		s.entries.erase( it );
+	}
+	served.fetch_add( 1, std::memory_order_relaxed );
+	return share::derived;
+}
+
+void repeated_pairs::publish( std::uint64_t v1, std::uint64_t v2, std::vector<unsigned char> const & profile ) { // by the thread that claimed the pair
+	pair_type const pair( std::min( v1, v2 ), std::max( v1, v2 ) );
+	shard & s( shard_of( pair ) );
+	{
+		std::lock_guard<std::mutex> lock( s.mutex );
+		entry & e( s.entries.find( pair )->second );
+		e.profile = profile;
+		e.reversed = v1 > v2;
+		e.ready = true;
+		--e.remaining;
+	}
+	s.published.notify_all();
+}
+
+std::uint64_t repeated_pairs::distinct() const {
+	return repeated;
+}
+
+std::uint64_t repeated_pairs::derived() const {
+	return served;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+constexpr const std::size_t cached_vcp<n,r,d>::address_bytes;
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename graph_type>
+cached_vcp<n,r,d>::cached_vcp( graph_type const & g, profile_cache * cache, std::uint64_t fingerprint, repeated_pairs * repeats, graph_statistics<r,d> const * statistics ) : profiler( engine( g, statistics, std::integral_constant<bool,n == 4>() ) ), cache( cache ), repeats( repeats ), claimed( false ), vertices( g.vertices_begin() ) {
+	key.graph = fingerprint;
+	key.n = n;
+	key.r = r;
+	key.d = d;
+	if( cache != nullptr || repeats != nullptr ) {
+		prepare( std::integral_constant<bool,r == 1>() );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+constexpr std::size_t cached_vcp<n,r,d>::element_count() {
+	return engine_type::element_count();
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename graph_type>
+typename cached_vcp<n,r,d>::engine_type cached_vcp<n,r,d>::engine( graph_type const & g, graph_statistics<r,d> const * statistics, std::true_type ) {
+	return engine_type( g, statistics );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename graph_type>
+typename cached_vcp<n,r,d>::engine_type cached_vcp<n,r,d>::engine( graph_type const & g, graph_statistics<r,d> const *, std::false_type ) {
+	return engine_type( g );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void cached_vcp<n,r,d>::prepare( std::true_type ) { // element ids are those of vcp_canonical_mapper, which numbers the same classes as the r=1 engines
+	vcp_canonical_mapper const classes( n, 1, d );
+	exchanged_elements.resize( classes.element_count() );
+	for( std::size_t element( 0 ); element < exchanged_elements.size(); ++element ) {
+		exchanged_elements[element] = classes.element_address( mapper.exchange_endpoints( classes.subgraph_address( element ) ) );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void cached_vcp<n,r,d>::prepare( std::false_type ) {
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename output_type>
+void cached_vcp<n,r,d>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, output_type && output ) {
+	generate( v1, v2, output, std::integral_constant<bool,r == 1>() );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename iterator_type>
+void cached_vcp<n,r,d>::generate( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, std::true_type ) {
+	if( cache == nullptr && repeats == nullptr ) {
+		profiler.generate_vector( v1, v2, counts );
+		return;
+	}
+	if( lookup( v1, v2 ) ) {
+		std::fill( counts, counts + element_count(), 0 );
+		for( typename std::vector<std::pair<subgraph_address_type,unsigned long> >::const_iterator it( entries.begin() ); it != entries.end(); ++it ) {
+			counts[it->first] = it->second;
+		}
+		return;
+	}
+	profiler.generate_vector( v1, v2, counts );
+	entries.clear();
+	for( std::size_t element( 0 ); element < element_count(); ++element ) {
+		if( counts[element] != 0 ) {
+			entries.push_back( std::make_pair( element, counts[element] ) );
+		}
+	}
+	store();
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename sink_type>
+void cached_vcp<n,r,d>::generate( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink, std::false_type ) {
+	if( cache == nullptr && repeats == nullptr ) {
+		profiler.generate_vector( v1, v2, sink );
+		return;
+	}
+	if( !lookup( v1, v2 ) ) {
+		entries.clear();
+		auto capture = [this]( subgraph_address_type const & address, unsigned long count ) {
+			entries.push_back( std::make_pair( address, count ) );
+		};
+		profiler.generate_vector( v1, v2, capture );
+		store();
+	}
+	for( typename std::vector<std::pair<subgraph_address_type,unsigned long> >::const_iterator it( entries.begin() ); it != entries.end(); ++it ) {
+		sink( it->first, it->second );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+bool cached_vcp<n,r,d>::lookup( const_vertex_iterator v1, const_vertex_iterator v2 ) {
+	key.v1 = v1 - vertices;
+	key.v2 = v2 - vertices;
+	claimed = false;
+	if( repeats != nullptr ) {
+		bool reversed( false );
+		repeated_pairs::share const result( repeats->acquire( key.v1, key.v2, profile, reversed ) );
+		if( result == repeated_pairs::share::derived ) {
+			decode( reversed );
+			return true;
+		}
+		claimed = result == repeated_pairs::share::claimed;
+	}
+	if( cache == nullptr ) {
+		return false;
+	}
+	if( cache->find( key, profile ) ) {
+		decode( false );
+		cache->record( profile_cache::outcome::hit );
+	} else if( key.v1 != key.v2 && cache->find( key.exchanged(), profile ) ) {
+		decode( true );
+		cache->record( profile_cache::outcome::swapped_hit );
+		serialize(); // in the order of this pair for the other occurrences
+	} else {
+		cache->record( profile_cache::outcome::miss );
+		return false;
+	}
+	if( claimed ) {
+		repeats->publish( key.v1, key.v2, profile );
+	}
+	return true;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void cached_vcp<n,r,d>::serialize() { // entries as little-endian address bytes followed by a uint64 count
+	profile.resize( entries.size() * (address_bytes + 8) );
+	unsigned char * out( profile.data() );
+	for( typename std::vector<std::pair<subgraph_address_type,unsigned long> >::const_iterator it( entries.begin() ); it != entries.end(); ++it ) {
+		for( std::size_t byte( 0 ); byte < address_bytes; ++byte ) {
+			*out++ = address_byte( it->first, byte );
+		}
+		for( std::size_t byte( 0 ); byte < 8; ++byte ) {
+			*out++ = static_cast<unsigned char>( std::uint64_t( it->second ) >> (8 * byte) );
+		}
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void cached_vcp<n,r,d>::store() {
+	serialize();
+	if( claimed ) {
+		repeats->publish( key.v1, key.v2, profile );
+	}
+	if( cache != nullptr ) {
+		cache->insert( key, profile );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void cached_vcp<n,r,d>::decode( bool exchanged ) {
+	entries.clear();
+	for( unsigned char const * in( profile.data() ); in != profile.data() + profile.size(); ) {
+		subgraph_address_type address( 0 );
+		for( std::size_t byte( 0 ); byte < address_bytes; ++byte ) {
+			address |= subgraph_address_type( *in++ ) << (8 * byte);
+		}
+		std::uint64_t count( 0 );
+		for( std::size_t byte( 0 ); byte < 8; ++byte ) {
+			count |= std::uint64_t( *in++ ) << (8 * byte);
+		}
+		entries.push_back( std::make_pair( exchanged ? exchange( address, std::integral_constant<bool,r == 1>() ) : address, count ) );
+	}
+	if( exchanged ) { // sinks receive addresses in ascending order
+		std::sort( entries.begin(), entries.end() );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+typename cached_vcp<n,r,d>::subgraph_address_type cached_vcp<n,r,d>::exchange( subgraph_address_type const & element, std::true_type ) const {
+	return exchanged_elements[element];
+}
+
+template <std::size_t n,std::size_t r,bool d>
+typename cached_vcp<n,r,d>::subgraph_address_type cached_vcp<n,r,d>::exchange( subgraph_address_type const & address, std::false_type ) const {
+	return mapper.exchange_endpoints( address );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+unsigned char cached_vcp<n,r,d>::address_byte( std::size_t address, std::size_t byte ) {
+	return static_cast<unsigned char>( address >> (8 * byte) );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename backend_type>
+unsigned char cached_vcp<n,r,d>::address_byte( boost::multiprecision::number<backend_type> const & address, std::size_t byte ) {
+	return static_cast<boost::multiprecision::number<backend_type> >( (address >> (8 * byte)) & 0xff ).template convert_to<unsigned char>();
+}
+
+}
+
+#endif
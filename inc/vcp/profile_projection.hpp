@@ -0,0 +1,123 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_PROFILE_PROJECTION
+#define VCP_PROFILE_PROJECTION
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <vcp/vcp_canonical_mapper.hpp>
+
+namespace vcp {
+
+// derives the r=1 profile of a pair in a coarser view from its profile: the three-vertex profile as a marginal of the four-vertex profile, and the undirected profile of the reciprocated edges of a directed graph
+class profile_projection {
+	public:
+		profile_projection( std::size_t n, bool d, std::size_t view_n, bool view_d );
+		std::size_t view_n() const;
+		bool view_d() const;
+		std::size_t element_count() const;
+		template <typename count_iterator,typename view_iterator> void project( count_iterator counts, std::size_t vertex_count, view_iterator view ) const;
+	private:
+		std::size_t view_n_;
+		bool view_d_;
+		std::size_t source_count;
+		std::size_t view_count;
+		std::size_t images_per_element; // two when each four-vertex subgraph contributes the three-vertex subgraphs of its v3 and of its v4
+		std::vector<std::size_t> images; // the view elements of each element of the profile
+		static std::vector<std::size_t> cells( std::size_t n, bool d );
+};
+
+profile_projection::profile_projection( std::size_t n, bool d, std::size_t view_n, bool view_d ) : view_n_( view_n ), view_d_( view_d ), images_per_element( n - view_n + 1 ) {
+	if( view_n < 3 || view_n > n || view_n + 1 < n || (view_d && !d) ) {
+		throw std::invalid_argument( "a view may drop at most one vertex and cannot add directedness" );
+	}
+	vcp_canonical_mapper const source( n, 1, d );
+	vcp_canonical_mapper const view( view_n, 1, view_d );
+	source_count = source.element_count();
+	view_count = view.element_count();
+	std::vector<std::size_t> const source_cells( cells( n, d ) );
+	std::vector<std::size_t> const view_cells( cells( view_n, view_d ) );
+	images.reserve( source_count * images_per_element );
+	for( std::size_t element( 0 ); element < source_count; ++element ) {
+		std::size_t const address( source.subgraph_address( element ) );
+		for( std::size_t image( 0 ); image < images_per_element; ++image ) {
+			std::vector<std::size_t> vertex( view_n ); // the vertex of the subgraph that each vertex of the view is
+			for( std::size_t i( 0 ); i < view_n; ++i ) {
+				vertex[i] = i < 2 + image ? i : i + n - view_n;
+			}
+			std::size_t view_address( 0 );
+			for( std::size_t row( 0 ); row < view_n; ++row ) {
+				for( std::size_t column( view_d ? 0 : row + 1 ); column < view_n; ++column ) {
+					if( row == column ) {
+						continue;
+					}
+					std::size_t edge( (address >> source_cells[vertex[row] * n + vertex[column]]) & 1 );
+					if( d && !view_d ) { // only reciprocated edges are undirected edges of the view
+						edge &= (address >> source_cells[vertex[column] * n + vertex[row]]) & 1;
+					}
+					view_address |= edge << view_cells[row * view_n + column];
+				}
+			}
+			images.push_back( view.element_address( view_address ) );
+		}
+	}
+}
+
+std::size_t profile_projection::view_n() const {
+	return view_n_;
+}
+
+bool profile_projection::view_d() const {
+	return view_d_;
+}
+
+std::size_t profile_projection::element_count() const {
+	return view_count;
+}
+
+template <typename count_iterator,typename view_iterator>
+void profile_projection::project( count_iterator counts, std::size_t vertex_count, view_iterator view ) const { // a vertex outside the pair occurs in vertex_count - 3 four-vertex subgraphs, which must therefore number at least one
+	std::fill( view, view + view_count, 0 );
+	std::vector<std::size_t>::const_iterator image( images.begin() );
+	for( std::size_t element( 0 ); element < source_count; ++element, ++counts, image += images_per_element ) {
+		if( *counts != 0 ) { // most elements of a four-vertex profile are absent
+			for( std::size_t i( 0 ); i < images_per_element; ++i ) {
+				view[image[i]] += *counts;
+			}
+		}
+	}
+	if( images_per_element == 2 ) {
+		for( std::size_t element( 0 ); element < view_count; ++element ) {
+			view[element] /= vertex_count - 3;
+		}
+	}
+}
+
+std::vector<std::size_t> profile_projection::cells( std::size_t n, bool d ) { // the bit of each ordered vertex pair in a subgraph address, as laid out by vcp_canonical_mapper
+	std::vector<std::size_t> cell( n * n );
+	std::size_t index( 0 );
+	for( std::size_t row( 0 ); row < n; ++row ) {
+		for( std::size_t column( row + 1 ); column < n; ++column ) {
+			cell[row * n + column] = index++;
+			cell[column * n + row] = d ? index++ : cell[row * n + column];
+		}
+	}
+	return cell;
+}
+
+}
+
+#endif
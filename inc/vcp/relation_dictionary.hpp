@@ -0,0 +1,129 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_RELATION_DICTIONARY
+#define VCP_RELATION_DICTIONARY
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/multirelational_graph.hpp>
+#include <vcp/square_matrix.hpp>
+#include <vcp/vcp_dynamic_mapper.hpp>
+
+namespace vcp {
+
+// numbers the distinct relation bitsets that occur on the edges of a graph so that VCPs can be computed over the codes
+template <std::size_t r>
+class relation_dictionary {
+	public:
+		typedef typename multirelational_graph<r>::connectivity_address_type value_type;
+		explicit relation_dictionary( multirelational_graph<r> const & g );
+		explicit relation_dictionary( multirelational_directed_graph<r> const & g );
+		std::size_t size() const;
+		std::size_t code_bits() const;
+		std::size_t code( value_type const & value ) const;
+		value_type value( std::size_t code ) const;
+		template <std::size_t code_r,std::size_t n,bool d> typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type decode( typename vcp_dynamic_mapper<n,code_r,d>::subgraph_address_type const & address, vcp_dynamic_mapper<n,r,d> const & mapper ) const;
+	private:
+		std::vector<value_type> values; // distinct nonzero edge values in ascending order; code c denotes values[c-1] and code 0 an absent edge
+		void index();
+		static std::size_t cell( std::size_t address, std::size_t shift, std::size_t mask );
+		template <typename backend_type> static std::size_t cell( boost::multiprecision::number<backend_type> const & address, std::size_t shift, std::size_t mask );
+};
+
+template <std::size_t r>
+relation_dictionary<r>::relation_dictionary( multirelational_graph<r> const & g ) {
+	for( const_edge_iterator it( g.edges_begin() ); it != g.edges_end(); ++it ) {
+		values.push_back( g.edge_value( it ) );
+	}
+	index();
+}
+
+template <std::size_t r>
+relation_dictionary<r>::relation_dictionary( multirelational_directed_graph<r> const & g ) {
+	for( const_edge_iterator it( g.out_edges_begin() ); it != g.out_edges_end(); ++it ) { // in-edges repeat the same values
+		values.push_back( g.edge_value( it ) );
+	}
+	index();
+}
+
+template <std::size_t r>
+void relation_dictionary<r>::index() {
+	std::sort( values.begin(), values.end() );
+	values.erase( std::unique( values.begin(), values.end() ), values.end() );
+	if( !values.empty() && values.front() == 0 ) {
+		values.erase( values.begin() );
+	}
+}
+
+template <std::size_t r>
+std::size_t relation_dictionary<r>::size() const {
+	return values.size();
+}
+
+template <std::size_t r>
+std::size_t relation_dictionary<r>::code_bits() const {
+	std::size_t bits( 0 );
+	while( (std::size_t( 1 ) << bits) <= values.size() ) {
+		++bits;
+	}
+	return bits;
+}
+
+template <std::size_t r>
+std::size_t relation_dictionary<r>::code( value_type const & value ) const {
+	if( value == 0 ) {
+		return 0;
+	}
+	return std::lower_bound( values.begin(), values.end(), value ) - values.begin() + 1;
+}
+
+template <std::size_t r>
+typename relation_dictionary<r>::value_type relation_dictionary<r>::value( std::size_t code ) const {
+	return code == 0 ? value_type( 0 ) : values[code - 1];
+}
+
+template <std::size_t r>
+template <std::size_t code_r,std::size_t n,bool d>
+typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type relation_dictionary<r>::decode( typename vcp_dynamic_mapper<n,code_r,d>::subgraph_address_type const & address, vcp_dynamic_mapper<n,r,d> const & mapper ) const {
+	// codes occupy the cells of the address in the order used by vcp_dynamic_mapper; the decoded subgraph must be canonicalized again because relabeling edges does not preserve the order of addresses
+	square_matrix<value_type,n> connectivity;
+	std::size_t const mask( (std::size_t( 1 ) << code_r) - 1 );
+	std::size_t index( 0 );
+	for( std::size_t row( 0 ); row < n; ++row ) {
+		connectivity( row, row ) = 0;
+		for( std::size_t column( row + 1 ); column < n; ++column ) {
+			connectivity( row, column ) = value( cell( address, code_r * index++, mask ) );
+			connectivity( column, row ) = d ? value( cell( address, code_r * index++, mask ) ) : value_type( 0 );
+		}
+	}
+	return mapper.canonical_subgraph_address( connectivity );
+}
+
+template <std::size_t r>
+std::size_t relation_dictionary<r>::cell( std::size_t address, std::size_t shift, std::size_t mask ) {
+	return (address >> shift) & mask;
+}
+
+template <std::size_t r>
+template <typename backend_type>
+std::size_t relation_dictionary<r>::cell( boost::multiprecision::number<backend_type> const & address, std::size_t shift, std::size_t mask ) {
+	return static_cast<boost::multiprecision::number<backend_type> >( (address >> shift) & mask ).template convert_to<std::size_t>();
+}
+
+}
+
+#endif
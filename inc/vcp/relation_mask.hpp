@@ -0,0 +1,62 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_RELATION_MASK
+#define VCP_RELATION_MASK
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace vcp {
+
+// serves projections of one loaded multirelational graph onto subsets of its relations; each keeps only the edges that carry a relation of its mask, so that neighbor iteration stays dense, and is built on first request and shared by every later request for the same mask
+template <typename graph_type>
+class relation_mask {
+	public:
+		typedef typename graph_type::connectivity_address_type mask_type;
+		explicit relation_mask( graph_type const & g );
+		relation_mask( relation_mask const & ) = delete;
+		relation_mask & operator=( relation_mask const & ) = delete;
+		graph_type const & view( mask_type const & mask );
+		std::size_t size() const;
+	private:
+		graph_type const & g;
+		mutable std::mutex mutex;
+		std::map<mask_type,std::unique_ptr<graph_type const> > views;
+};
+
+template <typename graph_type>
+relation_mask<graph_type>::relation_mask( graph_type const & g ) : g( g ) {
+}
+
+template <typename graph_type>
+graph_type const & relation_mask<graph_type>::view( mask_type const & mask ) { // threads may request views concurrently
+	std::lock_guard<std::mutex> lock( mutex );
+	typename std::map<mask_type,std::unique_ptr<graph_type const> >::iterator it( views.lower_bound( mask ) );
+	if( it == views.end() || it->first != mask ) {
+		it = views.insert( it, std::make_pair( mask, std::unique_ptr<graph_type const>( new graph_type( g, mask ) ) ) );
+	}
+	return *it->second;
+}
+
+template <typename graph_type>
+std::size_t relation_mask<graph_type>::size() const {
+	std::lock_guard<std::mutex> lock( mutex );
+	return views.size();
+}
+
+}
+
+#endif
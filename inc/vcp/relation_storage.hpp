@@ -0,0 +1,47 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_RELATION_STORAGE
+#define VCP_RELATION_STORAGE
+
+#include <cstddef>
+#include <vcp/vcp_dynamic_mapper.hpp>
+
+namespace vcp {
+
+constexpr std::size_t max_relations( 64 ); // edge values of multirelational graphs are read into a std::size_t
+
+// the largest relation count whose subgraph addresses occupy as many 64-bit words as those of r relations; the VCP classes are instantiated for these storage widths, and every r of a width shares the instantiation for it
+template <std::size_t n,bool d>
+constexpr std::size_t storage_relations( std::size_t r ) {
+	return (n*(n-1)*(d+1)/2 * r + 63) / 64 * 64 / (n*(n-1)*(d+1)/2);
+}
+
+// moves each cell of r bits of a subgraph address into a cell of relations bits; cell values are below 2^relations, so canonical addresses remain canonical and keep their order
+template <std::size_t n,std::size_t r,bool d>
+typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type pack_relations( typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type const & address, std::size_t relations ) {
+	typedef typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type subgraph_address_type;
+	if( relations == r ) {
+		return address;
+	}
+	subgraph_address_type packed( 0 );
+	subgraph_address_type const mask( (subgraph_address_type( 1 ) << relations) - 1 );
+	for( std::size_t cell( 0 ); cell < n*(n-1)*(d+1)/2; ++cell ) {
+		packed |= ((address >> (r * cell)) & mask) << (relations * cell);
+	}
+	return packed;
+}
+
+}
+
+#endif
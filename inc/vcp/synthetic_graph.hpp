@@ -0,0 +1,284 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VCP_SYNTHETIC_GRAPH
+#define VCP_SYNTHETIC_GRAPH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vcp/graph.hpp>
+
+namespace vcp {
+
+enum class pair_sampler { uniform, distance2, hub };
+
+pair_sampler parse_pair_sampler( std::string const & name );
+
+// seeded random graphs for benchmarking, written in the adjacency format read by the graph classes; generation depends only on the seed, not on the standard library
+class synthetic_graph {
+	public:
+		explicit synthetic_graph( std::size_t vertex_count );
+		static synthetic_graph erdos_renyi( std::size_t vertex_count, double mean_degree, std::uint64_t seed );
+		static synthetic_graph barabasi_albert( std::size_t vertex_count, std::size_t attachments, std::uint64_t seed );
+		static synthetic_graph rmat( std::size_t scale, double mean_degree, double a, double b, double c, std::uint64_t seed );
+		std::size_t vertex_count() const;
+		std::size_t edge_count() const;
+		void add_edge( vertex_id_t v1, vertex_id_t v2 );
+		void orient( double reciprocity, std::uint64_t seed );
+		void label( std::size_t r, std::size_t combinations, std::uint64_t seed );
+		void write( std::ostream & os ) const;
+		std::vector<vertex_id_t> sample_pairs( pair_sampler sampler, std::size_t count, std::uint64_t seed ) const;
+	private:
+		struct edge {
+			vertex_id_t v1; // v1 < v2
+			vertex_id_t v2;
+			std::uint64_t forward; // value of the arc v1->v2, 0 if absent
+			std::uint64_t backward; // value of the arc v2->v1, 0 if absent
+		};
+		class random_source {
+			public:
+				explicit random_source( std::uint64_t seed );
+				std::uint64_t below( std::uint64_t bound );
+				double unit();
+			private:
+				std::mt19937_64 engine;
+		};
+		std::size_t num_vertices;
+		bool directed;
+		std::vector<edge> edges;
+		void deduplicate();
+		std::vector<std::vector<vertex_id_t> > adjacency() const;
+};
+
+pair_sampler parse_pair_sampler( std::string const & name ) {
+	if( name == "uniform" ) {
+		return pair_sampler::uniform;
+	} else if( name == "distance2" ) {
+		return pair_sampler::distance2;
+	} else if( name == "hub" ) {
+		return pair_sampler::hub;
+	}
+	throw std::invalid_argument( "unknown pair sampler: " + name );
+}
+
+synthetic_graph::random_source::random_source( std::uint64_t seed ) : engine( seed ) {
+}
+
+std::uint64_t synthetic_graph::random_source::below( std::uint64_t bound ) {
+	return engine() % bound;
+}
+
+double synthetic_graph::random_source::unit() {
+	return (engine() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+synthetic_graph::synthetic_graph( std::size_t vertex_count ) : num_vertices( vertex_count ), directed( false ) {
+}
+
+synthetic_graph synthetic_graph::erdos_renyi( std::size_t vertex_count, double mean_degree, std::uint64_t seed ) { // G(n,m) with m chosen for the mean degree
+	synthetic_graph g( vertex_count );
+	random_source random( seed );
+	std::size_t const edge_target( static_cast<std::size_t>( vertex_count * mean_degree / 2 ) );
+	if( vertex_count < 2 ) {
+		return g;
+	}
+	for( std::size_t i( 0 ); i < edge_target; ++i ) {
+		g.add_edge( random.below( vertex_count ), random.below( vertex_count ) );
+	}
+	g.deduplicate();
+	return g;
+}
+
+synthetic_graph synthetic_graph::barabasi_albert( std::size_t vertex_count, std::size_t attachments, std::uint64_t seed ) {
+	synthetic_graph g( vertex_count );
+	random_source random( seed );
+	std::vector<vertex_id_t> endpoints; // each vertex appears once per incident edge, so uniform draws are proportional to degree
+	std::size_t const core( std::min( vertex_count, attachments + 1 ) );
+	for( vertex_id_t v1( 0 ); v1 < core; ++v1 ) {
+		for( vertex_id_t v2( v1 + 1 ); v2 < core; ++v2 ) {
+			g.add_edge( v1, v2 );
+			endpoints.push_back( v1 );
+			endpoints.push_back( v2 );
+		}
+	}
+	std::vector<vertex_id_t> targets;
+	for( vertex_id_t v( core ); v < vertex_count; ++v ) {
+		targets.clear();
+		while( targets.size() < attachments ) {
+			vertex_id_t target( endpoints[ random.below( endpoints.size() ) ] );
+			if( std::find( targets.begin(), targets.end(), target ) == targets.end() ) {
+				targets.push_back( target );
+			}
+		}
+		for( std::vector<vertex_id_t>::const_iterator it( targets.begin() ); it != targets.end(); ++it ) {
+			g.add_edge( v, *it );
+			endpoints.push_back( v );
+			endpoints.push_back( *it );
+		}
+	}
+	g.deduplicate();
+	return g;
+}
+
+synthetic_graph synthetic_graph::rmat( std::size_t scale, double mean_degree, double a, double b, double c, std::uint64_t seed ) { // recursive quadrant descent with probabilities a, b, c, and 1-a-b-c
+	std::size_t const vertex_count( std::size_t( 1 ) << scale );
+	synthetic_graph g( vertex_count );
+	random_source random( seed );
+	std::size_t const edge_target( static_cast<std::size_t>( vertex_count * mean_degree / 2 ) );
+	for( std::size_t i( 0 ); i < edge_target; ++i ) {
+		vertex_id_t v1( 0 );
+		vertex_id_t v2( 0 );
+		for( std::size_t level( 0 ); level < scale; ++level ) {
+			double const p( random.unit() );
+			v1 = 2 * v1 + (p >= a + b);
+			v2 = 2 * v2 + ((p >= a && p < a + b) || p >= a + b + c);
+		}
+		g.add_edge( v1, v2 );
+	}
+	g.deduplicate();
+	return g;
+}
+
+std::size_t synthetic_graph::vertex_count() const {
+	return num_vertices;
+}
+
+std::size_t synthetic_graph::edge_count() const {
+	return edges.size();
+}
+
+void synthetic_graph::add_edge( vertex_id_t v1, vertex_id_t v2 ) { // self-loops are ignored and duplicates are removed by the generators
+	if( v1 == v2 ) {
+		return;
+	}
+	edge e = { std::min( v1, v2 ), std::max( v1, v2 ), 1, 1 };
+	edges.push_back( e );
+}
+
+void synthetic_graph::deduplicate() {
+	std::sort( edges.begin(), edges.end(), []( edge const & x, edge const & y ) { return x.v1 < y.v1 || (x.v1 == y.v1 && x.v2 < y.v2); } );
+	edges.erase( std::unique( edges.begin(), edges.end(), []( edge const & x, edge const & y ) { return x.v1 == y.v1 && x.v2 == y.v2; } ), edges.end() );
+}
+
+void synthetic_graph::orient( double reciprocity, std::uint64_t seed ) { // each edge becomes an arc in a random direction, or a pair of arcs with probability reciprocity
+	random_source random( seed );
+	for( std::vector<edge>::iterator it( edges.begin() ); it != edges.end(); ++it ) {
+		if( random.unit() >= reciprocity ) {
+			(random.below( 2 ) ? it->forward : it->backward) = 0;
+		}
+	}
+	directed = true;
+}
+
+void synthetic_graph::label( std::size_t r, std::size_t combinations, std::uint64_t seed ) { // gives each arc a nonzero set of r relations, drawn from a pool of this many combinations or from all 2^r-1 when zero; undirected edges carry one value
+	if( r == 0 || r > 64 ) {
+		throw std::invalid_argument( "relation count must be in [1,64]" );
+	}
+	random_source random( seed );
+	std::uint64_t const values( r == 64 ? ~std::uint64_t( 0 ) : (std::uint64_t( 1 ) << r) - 1 );
+	std::vector<std::uint64_t> pool;
+	for( std::size_t i( 0 ); i < combinations; ++i ) {
+		pool.push_back( random.below( values ) + 1 );
+	}
+	auto draw = [&]() { return pool.empty() ? random.below( values ) + 1 : pool[ random.below( pool.size() ) ]; };
+	for( std::vector<edge>::iterator it( edges.begin() ); it != edges.end(); ++it ) {
+		if( it->forward != 0 ) {
+			it->forward = draw();
+		}
+		if( it->backward != 0 ) {
+			it->backward = directed ? draw() : it->forward;
+		}
+	}
+}
+
+void synthetic_graph::write( std::ostream & os ) const {
+	std::vector<std::vector<std::pair<vertex_id_t,std::uint64_t> > > arcs( num_vertices );
+	for( std::vector<edge>::const_iterator it( edges.begin() ); it != edges.end(); ++it ) {
+		if( it->forward != 0 ) {
+			arcs[ it->v1 ].push_back( std::make_pair( it->v2, it->forward ) );
+		}
+		if( it->backward != 0 ) {
+			arcs[ it->v2 ].push_back( std::make_pair( it->v1, it->backward ) );
+		}
+	}
+	for( vertex_id_t v( 0 ); v < num_vertices; ++v ) {
+		std::sort( arcs[ v ].begin(), arcs[ v ].end() );
+		for( std::size_t i( 0 ); i < arcs[ v ].size(); ++i ) {
+			os << (i == 0 ? "" : " ") << arcs[ v ][ i ].first << ',' << arcs[ v ][ i ].second;
+		}
+		os << '\n';
+	}
+}
+
+std::vector<std::vector<vertex_id_t> > synthetic_graph::adjacency() const {
+	std::vector<std::vector<vertex_id_t> > result( num_vertices );
+	for( std::vector<edge>::const_iterator it( edges.begin() ); it != edges.end(); ++it ) {
+		result[ it->v1 ].push_back( it->v2 );
+		result[ it->v2 ].push_back( it->v1 );
+	}
+	for( vertex_id_t v( 0 ); v < num_vertices; ++v ) {
+		std::sort( result[ v ].begin(), result[ v ].end() );
+	}
+	return result;
+}
+
+std::vector<vertex_id_t> synthetic_graph::sample_pairs( pair_sampler sampler, std::size_t count, std::uint64_t seed ) const { // returns count pairs as consecutive vertex ids; distance2 pairs are non-adjacent with a common neighbor, and hub pairs draw each endpoint with probability proportional to degree
+	std::vector<vertex_id_t> pairs;
+	if( num_vertices < 2 || (sampler != pair_sampler::uniform && edges.empty()) ) {
+		return pairs;
+	}
+	random_source random( seed );
+	std::vector<std::vector<vertex_id_t> > const adjacent( adjacency() );
+	std::size_t attempts( 0 );
+	while( pairs.size() < 2 * count && attempts++ < 64 * count ) { // distance-2 pairs may not exist, so give up eventually
+		vertex_id_t v1( 0 );
+		vertex_id_t v2( 0 );
+		if( sampler == pair_sampler::uniform ) {
+			v1 = random.below( num_vertices );
+			v2 = random.below( num_vertices );
+		} else if( sampler == pair_sampler::hub ) {
+			edge const & e1( edges[ random.below( edges.size() ) ] );
+			edge const & e2( edges[ random.below( edges.size() ) ] );
+			v1 = random.below( 2 ) ? e1.v1 : e1.v2;
+			v2 = random.below( 2 ) ? e2.v1 : e2.v2;
+		} else {
+			edge const & e( edges[ random.below( edges.size() ) ] );
+			vertex_id_t middle( e.v2 );
+			v1 = e.v1;
+			if( random.below( 2 ) ) {
+				std::swap( v1, middle );
+			}
+			v2 = adjacent[ middle ][ random.below( adjacent[ middle ].size() ) ];
+			if( std::binary_search( adjacent[ v1 ].begin(), adjacent[ v1 ].end(), v2 ) ) {
+				continue;
+			}
+		}
+		if( v1 != v2 ) {
+			pairs.push_back( v1 );
+			pairs.push_back( v2 );
+		}
+	}
+	return pairs;
+}
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VCP_V3_SAMPLE
+#define VCP_V3_SAMPLE
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vcp/graph.hpp>
+
+namespace vcp {
+
+// the policy of exact profiling: the four-vertex VCP classes expand every v3 candidate and count into the vector directly
+struct v3_census {
+	constexpr static const bool sampled = false;
+	void begin( vertex_id_t v1, vertex_id_t v2, std::size_t v3_count );
+	bool expand( vertex_id_t v3 ) const;
+	template <typename iterator_type> iterator_type target( iterator_type counts );
+	void fold();
+	template <typename iterator_type> void finish( iterator_type counts );
+};
+
+// expands each v3 candidate of a pair independently with probability budget / v3 count and scales the counts it contributes by the inverse, forming the Horvitz-Thompson estimate of every count; terms that need no expansion, such as the closed-form gap counts, stay exact
+// a candidate may contribute negatively, so an estimate can fall below zero; the unsigned counts clamp it to zero, which biases small counts upward, and estimates() keeps the unbiased values
+class v3_sample {
+	public:
+		constexpr static const bool sampled = true;
+		v3_sample( std::size_t element_count, std::size_t budget, std::size_t degree_threshold, std::uint64_t salt = 0 ); // each salt draws an independent sample of every pair
+		bool sampling( std::size_t degree_sum ); // false, with zero variances, when the pair is small enough to profile exactly
+		void begin( vertex_id_t v1, vertex_id_t v2, std::size_t v3_count );
+		bool expand( vertex_id_t v3 ) const;
+		template <typename iterator_type> std::vector<unsigned long>::iterator target( iterator_type counts );
+		void fold(); // after each expanded candidate, whose contributions are in target
+		template <typename iterator_type> void finish( iterator_type counts );
+		std::vector<double> const & variances() const; // of the estimates of the last pair
+		std::vector<double> const & estimates() const; // of the last sampled pair, before rounding and clamping
+	private:
+		std::size_t budget;
+		std::size_t degree_threshold;
+		double probability;
+		std::uint64_t salt;
+		std::uint64_t seed;
+		std::uint64_t cutoff;
+		std::vector<unsigned long> local; // contributions of the current candidate, possibly negative in two's complement
+		std::vector<double> sums;
+		std::vector<double> squares;
+		std::vector<double> variance;
+		std::vector<double> estimate;
+		static std::uint64_t mix( std::uint64_t value );
+};
+
+void v3_census::begin( vertex_id_t, vertex_id_t, std::size_t ) {
+}
+
+bool v3_census::expand( vertex_id_t ) const {
+	return true;
+}
+
+template <typename iterator_type>
+iterator_type v3_census::target( iterator_type counts ) {
+	return counts;
+}
+
+void v3_census::fold() {
+}
+
+template <typename iterator_type>
+void v3_census::finish( iterator_type ) {
+}
+
+v3_sample::v3_sample( std::size_t element_count, std::size_t budget, std::size_t degree_threshold, std::uint64_t salt ) : budget( std::max<std::size_t>( 1, budget ) ), degree_threshold( degree_threshold ), probability( 1 ), salt( mix( salt ) ), seed( 0 ), cutoff( 0 ), local( element_count, 0 ), sums( element_count, 0 ), squares( element_count, 0 ), variance( element_count, 0 ), estimate( element_count, 0 ) {
+}
+
+bool v3_sample::sampling( std::size_t degree_sum ) {
+	if( degree_sum > degree_threshold ) {
+		return true;
+	}
+	std::fill( variance.begin(), variance.end(), 0 );
+	return false;
+}
+
+void v3_sample::begin( vertex_id_t v1, vertex_id_t v2, std::size_t v3_count ) { // candidates are chosen by hashing, so a pair always gets the same estimate
+	probability = std::min( 1.0, static_cast<double>( budget ) / std::max<std::size_t>( 1, v3_count ) );
+	cutoff = probability < 1 ? static_cast<std::uint64_t>( std::ldexp( probability, 64 ) ) : 0;
+	seed = mix( mix( v1 + 0x9e3779b97f4a7c15ull ) ^ v2 ) ^ salt; // a zero salt mixes to zero
+}
+
+bool v3_sample::expand( vertex_id_t v3 ) const {
+	return probability >= 1 || mix( seed ^ v3 ) < cutoff;
+}
+
+template <typename iterator_type>
+std::vector<unsigned long>::iterator v3_sample::target( iterator_type ) {
+	return local.begin();
+}
+
+void v3_sample::fold() {
+	for( std::size_t element( 0 ); element < local.size(); ++element ) {
+		if( local[element] != 0 ) {
+			double const contribution( static_cast<long>( local[element] ) );
+			sums[element] += contribution;
+			squares[element] += contribution * contribution;
+			local[element] = 0;
+		}
+	}
+}
+
+template <typename iterator_type>
+void v3_sample::finish( iterator_type counts ) { // the Horvitz-Thompson estimate and its unbiased variance estimate under independent sampling
+	double const scale( (1 - probability) / (probability * probability) );
+	for( std::size_t element( 0 ); element < sums.size(); ++element ) {
+		estimate[element] = static_cast<long>( counts[element] ) + sums[element] / probability;
+		counts[element] = estimate[element] > 0 ? static_cast<unsigned long>( std::llround( estimate[element] ) ) : 0;
+		variance[element] = scale * squares[element];
+		sums[element] = 0;
+		squares[element] = 0;
+	}
+}
+
+std::vector<double> const & v3_sample::variances() const {
+	return variance;
+}
+
+std::vector<double> const & v3_sample::estimates() const {
+	return estimate;
+}
+
+std::uint64_t v3_sample::mix( std::uint64_t value ) { // the splitmix64 finalizer
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+	return value ^ (value >> 31);
+}
+
+}
+
+#endif
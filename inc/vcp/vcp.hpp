@@ -19,6 +19,7 @@ You should have received a copy of the GNU General Public License along with the
 #include <map>
 #include <type_traits>
 #include <utility>
+#include <vcp/count_accumulator.hpp>
 #include <vcp/directed_graph.hpp>
 #include <vcp/graph.hpp>
 #include <vcp/multirelational_directed_graph.hpp>
@@ -37,7 +38,7 @@ You should have received a copy of the GNU General Public License along with the
 namespace vcp {
 	
 template <std::size_t n,std::size_t r,bool d>
-class vcp {
+class vcp_reference { // exhaustive engine: every n-vertex subgraph containing v1 and v2 is canonicalized with vcp_dynamic_mapper
 	public:
 		typedef typename std::conditional< d,
 				typename std::conditional< (r>1), multirelational_directed_graph<r>, directed_graph >::type,
@@ -45,12 +46,20 @@ class vcp {
 				>::type graph_type;
 		typedef typename multirelational_graph<r>::connectivity_address_type connectivity_address_type;
 		typedef typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type subgraph_address_type;
-		vcp( graph_type const & g );
+		explicit vcp_reference( graph_type const & g );
 		std::map<subgraph_address_type,unsigned long> const generate_vector( const_vertex_iterator, const_vertex_iterator );
+		template <typename sink_type> void generate_vector( const_vertex_iterator, const_vertex_iterator, sink_type & );
 	private:
 		graph_type const & g;
 		vcp_dynamic_mapper<n,r,d> mapper;
-		void helper( std::array<const_vertex_iterator,n> & vertices, std::size_t current_index, square_matrix<connectivity_address_type,n> & connectivity, std::map<subgraph_address_type,unsigned long> & counts );
+		count_accumulator<subgraph_address_type> counts;
+		void helper( std::array<const_vertex_iterator,n> & vertices, std::size_t current_index, square_matrix<connectivity_address_type,n> & connectivity );
+};
+
+template <std::size_t n,std::size_t r,bool d>
+class vcp : public vcp_reference<n,r,d> { // parameters without a specialization use the exhaustive engine
+	public:
+		explicit vcp( typename vcp_reference<n,r,d>::graph_type const & g );
 };
 
 const_edge_iterator edge( graph const & g, const_vertex_iterator v1, const_vertex_iterator v2 );
@@ -98,11 +107,11 @@ typename multirelational_graph<r>::connectivity_address_type edge_value( multire
 }
 
 template <std::size_t n,std::size_t r,bool d>
-vcp<n,r,d>::vcp( graph_type const & g ) : g( g ) {
+vcp_reference<n,r,d>::vcp_reference( graph_type const & g ) : g( g ) {
 }
 
 template <std::size_t n,std::size_t r,bool d>
-void vcp<n,r,d>::helper( std::array<const_vertex_iterator,n> & vertices, std::size_t current_index, square_matrix<connectivity_address_type,n> & connectivity, std::map<subgraph_address_type,unsigned long> & counts ) {
+void vcp_reference<n,r,d>::helper( std::array<const_vertex_iterator,n> & vertices, std::size_t current_index, square_matrix<connectivity_address_type,n> & connectivity ) {
 	if( vertices[ current_index ] == vertices[ 0 ] || vertices[ current_index ] == vertices[ 1 ] ) {
 		return;
 	}
@@ -113,19 +122,27 @@ void vcp<n,r,d>::helper( std::array<const_vertex_iterator,n> & vertices, std::si
 		}
 	}
 	if( n == current_index + 1 ) {
-		++counts.insert( std::make_pair( mapper.canonical_subgraph_address( connectivity ), 0 ) ).first->second;
+		counts.add( mapper.canonical_subgraph_address( connectivity ) );
 	} else {
 		for( const_vertex_iterator v( vertices[ current_index ] + 1 ); v != g.vertices_end(); ++v ) {
 			vertices[ current_index + 1 ] = v;
-			helper( vertices, current_index + 1, connectivity, counts );
+			helper( vertices, current_index + 1, connectivity );
 		}
 	}
 	return;
 }
 
 template <std::size_t n,std::size_t r,bool d>
-std::map<typename vcp<n,r,d>::subgraph_address_type,unsigned long> const vcp<n,r,d>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
+std::map<typename vcp_reference<n,r,d>::subgraph_address_type,unsigned long> const vcp_reference<n,r,d>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
 	std::map<subgraph_address_type,unsigned long> counts;
+	auto sink = [&counts]( subgraph_address_type const & address, unsigned long count ) { counts.insert( counts.end(), std::make_pair( address, count ) ); };
+	generate_vector( v1, v2, sink );
+	return counts;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename sink_type>
+void vcp_reference<n,r,d>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink ) {
 	std::array<const_vertex_iterator,n> vertices;
 	square_matrix<connectivity_address_type,n> connectivity;
 	connectivity( 0, 1 ) = edge_value( g, edge( g, v1, v2 ) );
@@ -136,9 +153,13 @@ std::map<typename vcp<n,r,d>::subgraph_address_type,unsigned long> const vcp<n,r
 	vertices[ 1 ] = v2;
 	for( const_vertex_iterator v3( g.vertices_begin() ); v3 != g.vertices_end(); ++v3 ) {
 		vertices[ 2 ] = v3;
-		helper( vertices, 2, connectivity, counts );
+		helper( vertices, 2, connectivity );
 	}
-	return counts;
+	counts.flush( sink );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+vcp<n,r,d>::vcp( typename vcp_reference<n,r,d>::graph_type const & g ) : vcp_reference<n,r,d>( g ) {
 }
 
 }
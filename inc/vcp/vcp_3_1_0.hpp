@@ -14,9 +14,12 @@ You should have received a copy of the GNU General Public License along with the
 #ifndef VCP_VCP_3_1_0
 #define VCP_VCP_3_1_0
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <vector>
 #include <vcp/graph.hpp>
+#include <vcp/perf_counters.hpp>
 
 namespace vcp {
 	
@@ -30,6 +33,7 @@ class vcp<3,1,0> {
 		vcp( graph const & );
 		constexpr static std::size_t element_count();
 		std::array<unsigned long,num_elements> const generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 );
+		template <typename iterator_type> void generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts );
 	private:
 		enum connectivity_value {
 			V1V2 = 1,
@@ -37,9 +41,14 @@ class vcp<3,1,0> {
 			V2V3 = 4
 		};
 		graph const & g;
+		const_vertex_iterator staged;
+		std::size_t staged_degree;
+		std::size_t epoch;
+		std::vector<std::size_t> neighbor_epochs;
+		void stage( const_vertex_iterator v1 );
 };
 
-vcp<3,1,0>::vcp( graph const & g ) : g(g) {
+vcp<3,1,0>::vcp( graph const & g ) : g(g), staged( nullptr ), staged_degree( 0 ), epoch( 0 ), neighbor_epochs( g.vertex_count(), 0 ) {
 }
 
 constexpr std::size_t vcp<3,1,0>::element_count() {
@@ -47,51 +56,48 @@ constexpr std::size_t vcp<3,1,0>::element_count() {
 }
 
 std::array<unsigned long,vcp<3,1,0>::element_count()> const vcp<3,1,0>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
-	std::array<unsigned long,element_count()> counts = {{0}};
+	std::array<unsigned long,element_count()> counts;
+	generate_vector( v1, v2, counts.begin() );
+	return counts;
+}
 
-	size_t v1v2( V1V2 * g.edge_exists( v1, v2 ) );
+template <typename iterator_type>
+void vcp<3,1,0>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts ) {
+	perf_counters::enter( perf_phase::staging );
+	std::fill( counts, counts + element_count(), 0 );
+	if( v1 != staged ) {
+		stage( v1 );
+	}
 
-	counts[ v1v2 ] = g.vertex_count() - 2;
-	const_edge_iterator v1_it( g.neighbors_begin( v1 ) );
-	const_edge_iterator v1_end( g.neighbors_end( v1 ) );
-	const_edge_iterator v2_it( g.neighbors_begin( v2 ) );
-	const_edge_iterator v2_end( g.neighbors_end( v2 ) );
-	
-	while( v1_it != v1_end && v2_it != v2_end ) {
-		if( g.target_of( v1_it ) == v2 ) {
-			++v1_it;
-		} else if( g.target_of( v2_it ) == v1 ) {
-			++v2_it;
-		} else {
-			--counts[ v1v2 ];
-			if( g.target_of( v1_it ) < g.target_of( v2_it ) ) {
-				++counts[ v1v2 + V1V3 ];
-				++v1_it;
-			} else if( g.target_of( v1_it ) > g.target_of( v2_it ) ) {
-				++counts[ v1v2 + V2V3 ];
-				++v2_it;
+	bool adjacent( neighbor_epochs[g.vertex_id( v2 )] == epoch );
+	size_t v1v2( V1V2 * adjacent );
+
+	unsigned long v1_only( staged_degree - adjacent );
+	unsigned long v2_only( 0 );
+	unsigned long both( 0 );
+	for( const_edge_iterator v2_it( g.neighbors_begin( v2 ) ); v2_it != g.neighbors_end( v2 ); ++v2_it ) {
+		if( g.target_of( v2_it ) != v1 ) {
+			if( neighbor_epochs[g.vertex_id( g.target_of( v2_it ) )] == epoch ) {
+				++both;
 			} else {
-				++counts[ v1v2 + V1V3 + V2V3 ];
-				++v1_it;
-				++v2_it;
+				++v2_only;
 			}
 		}
 	}
-	while( v1_it != v1_end ) {
-		if( g.target_of( v1_it ) != v2 ) {
-			--counts[ v1v2 ];
-			++counts[ v1v2 + V1V3 ];
-		}
-		++v1_it;
-	} while( v2_it != v2_end ) {
-		if( g.target_of( v2_it ) != v1 ) {
-			--counts[ v1v2 ];
-			++counts[ v1v2 + V2V3 ];
-		}
-		++v2_it;
-	}
+	v1_only -= both;
+	counts[ v1v2 + V1V3 ] = v1_only;
+	counts[ v1v2 + V2V3 ] = v2_only;
+	counts[ v1v2 + V1V3 + V2V3 ] = both;
+	counts[ v1v2 ] = g.vertex_count() - 2 - v1_only - v2_only - both;
+}
 
-	return counts;
+void vcp<3,1,0>::stage( const_vertex_iterator v1 ) { // marks the neighbors of v1 so that consecutive pairs sharing v1 only scan the neighbors of v2
+	++epoch;
+	for( const_edge_iterator v1_it( g.neighbors_begin( v1 ) ); v1_it != g.neighbors_end( v1 ); ++v1_it ) {
+		neighbor_epochs[g.vertex_id( g.target_of( v1_it ) )] = epoch;
+	}
+	staged = v1;
+	staged_degree = g.neighbors_end( v1 ) - g.neighbors_begin( v1 );
 }
 
 }
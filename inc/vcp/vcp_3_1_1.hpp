@@ -14,9 +14,12 @@ You should have received a copy of the GNU General Public License along with the
 #ifndef VCP_VCP_3_1_1
 #define VCP_VCP_3_1_1
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <vector>
 #include <vcp/directed_graph.hpp>
+#include <vcp/perf_counters.hpp>
 
 namespace vcp {
 
@@ -30,6 +33,7 @@ class vcp<3,1,1> {
 		vcp( directed_graph const & g );
 		constexpr static std::size_t element_count();
 		std::array<unsigned long,num_elements> const generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 );
+		template <typename iterator_type> void generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts );
 	private:
 		enum directedness_value {
 			OUT = 1,
@@ -42,6 +46,12 @@ class vcp<3,1,1> {
 			V2V3 = 16
 		};
 		directed_graph const & g;
+		const_vertex_iterator staged;
+		std::array<unsigned long,4> staged_tallies;
+		std::size_t epoch;
+		std::vector<std::size_t> neighbor_epochs;
+		std::vector<unsigned char> neighbor_directedness;
+		void stage( const_vertex_iterator v1 );
 		std::pair<const_edge_iterator,directedness_value> next_union_element( const_edge_iterator & it1, const_edge_iterator end1, const_edge_iterator & it2, const_edge_iterator end2 ) const;
 };
 
@@ -49,7 +59,7 @@ constexpr std::size_t vcp<3,1,1>::element_count() {
 	return num_elements;
 }
 
-vcp<3,1,1>::vcp( directed_graph const & g ) : g(g) {
+vcp<3,1,1>::vcp( directed_graph const & g ) : g(g), staged( nullptr ), epoch( 0 ), neighbor_epochs( g.vertex_count(), 0 ), neighbor_directedness( g.vertex_count(), 0 ) {
 }
 
 std::pair<const_edge_iterator,vcp<3,1,1>::directedness_value> vcp<3,1,1>::next_union_element( const_edge_iterator & it1, const_edge_iterator end1, const_edge_iterator & it2, const_edge_iterator end2 ) const { // out-neighbor iterators should always come first
@@ -72,59 +82,60 @@ std::pair<const_edge_iterator,vcp<3,1,1>::directedness_value> vcp<3,1,1>::next_u
 }
 
 std::array<unsigned long,vcp<3,1,1>::element_count()> const vcp<3,1,1>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
-	std::array<unsigned long,element_count()> counts = {{0}};
+	std::array<unsigned long,element_count()> counts;
+	generate_vector( v1, v2, counts.begin() );
+	return counts;
+}
+
+template <typename iterator_type>
+void vcp<3,1,1>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts ) {
+	perf_counters::enter( perf_phase::staging );
+	std::fill( counts, counts + element_count(), 0 );
+	if( v1 != staged ) {
+		stage( v1 );
+	}
 	
-	std::size_t v1v2( g.out_edge_exists( v1, v2 ) * OUT + g.in_edge_exists( v1, v2 ) * IN );
+	std::size_t v2_id( g.vertex_id( v2 ) );
+	std::size_t v1v2( neighbor_epochs[v2_id] == epoch ? neighbor_directedness[v2_id] : 0 );
+	std::array<unsigned long,4> v1_only( staged_tallies );
+	v1_only[v1v2] -= v1v2 != 0;
 	
-	const_edge_iterator v1_out_neighbors_it( g.out_neighbors_begin( v1 ) );
-	const_edge_iterator v1_out_neighbors_end( g.out_neighbors_end( v1 ) );
-	const_edge_iterator v1_in_neighbors_it( g.in_neighbors_begin( v1 ) );
-	const_edge_iterator v1_in_neighbors_end( g.in_neighbors_end( v1 ) );
 	const_edge_iterator v2_out_neighbors_it( g.out_neighbors_begin( v2 ) );
 	const_edge_iterator v2_out_neighbors_end( g.out_neighbors_end( v2 ) );
 	const_edge_iterator v2_in_neighbors_it( g.in_neighbors_begin( v2 ) );
 	const_edge_iterator v2_in_neighbors_end( g.in_neighbors_end( v2 ) );
-	std::pair<const_edge_iterator,directedness_value> min1( next_union_element( v1_out_neighbors_it, v1_out_neighbors_end, v1_in_neighbors_it, v1_in_neighbors_end ) );
-	std::pair<const_edge_iterator,directedness_value> min2( next_union_element( v2_out_neighbors_it, v2_out_neighbors_end, v2_in_neighbors_it, v2_in_neighbors_end ) );
 	unsigned long union_cardinality( 0 );
-	while( min1.first != v1_in_neighbors_end && min2.first != v2_in_neighbors_end ) {
-		if( g.target_of( min1.first ) < g.target_of( min2.first ) ) {
-			if( g.target_of( min1.first ) != v2 ) {
-				++union_cardinality;
-				++counts[ v1v2 + min1.second * V1V3 ];
-			}
-			min1 = next_union_element( v1_out_neighbors_it, v1_out_neighbors_end, v1_in_neighbors_it, v1_in_neighbors_end );
-		} else if( g.target_of( min1.first ) > g.target_of( min2.first ) ) {
-			if( g.target_of( min2.first ) != v1 ) {
-				++union_cardinality;
-				++counts[ v1v2 + min2.second * V2V3 ];
-			}
-			min2 = next_union_element( v2_out_neighbors_it, v2_out_neighbors_end, v2_in_neighbors_it, v2_in_neighbors_end );
-		} else { // the next neighbor is shared by both v1 and v2, so it cannot be either and we do not need to check to exclude it
-			++union_cardinality;
-			++counts[ v1v2 + min1.second * V1V3 + min2.second * V2V3 ];
-			min1 = next_union_element( v1_out_neighbors_it, v1_out_neighbors_end, v1_in_neighbors_it, v1_in_neighbors_end );
-			min2 = next_union_element( v2_out_neighbors_it, v2_out_neighbors_end, v2_in_neighbors_it, v2_in_neighbors_end );
-		}
-	}
-	while( min1.first != v1_in_neighbors_end ) {
-		if( g.target_of( min1.first ) != v2 ) {
-			++union_cardinality;
-			++counts[ v1v2 + min1.second * V1V3 ];
-		}
-		min1 = next_union_element( v1_out_neighbors_it, v1_out_neighbors_end, v1_in_neighbors_it, v1_in_neighbors_end );
-	}
-	while( min2.first != v2_in_neighbors_end ) {
+	for( std::pair<const_edge_iterator,directedness_value> min2( next_union_element( v2_out_neighbors_it, v2_out_neighbors_end, v2_in_neighbors_it, v2_in_neighbors_end ) ); min2.first != v2_in_neighbors_end; min2 = next_union_element( v2_out_neighbors_it, v2_out_neighbors_end, v2_in_neighbors_it, v2_in_neighbors_end ) ) {
 		if( g.target_of( min2.first ) != v1 ) {
+			std::size_t v3_id( g.vertex_id( g.target_of( min2.first ) ) );
+			std::size_t v1v3( neighbor_epochs[v3_id] == epoch ? neighbor_directedness[v3_id] : 0 );
 			++union_cardinality;
-			++counts[ v1v2 + min2.second * V2V3 ];
+			--v1_only[v1v3];
+			++counts[ v1v2 + v1v3 * V1V3 + min2.second * V2V3 ];
 		}
-		min2 = next_union_element( v2_out_neighbors_it, v2_out_neighbors_end, v2_in_neighbors_it, v2_in_neighbors_end );
+	}
+	for( std::size_t v1v3( OUT ); v1v3 <= BOTH; ++v1v3 ) {
+		union_cardinality += v1_only[v1v3];
+		counts[ v1v2 + v1v3 * V1V3 ] += v1_only[v1v3];
 	}
 	
 	counts[ v1v2 ] = g.vertex_count() - 2 - union_cardinality;
+}
 
-	return counts;
+void vcp<3,1,1>::stage( const_vertex_iterator v1 ) { // records the directedness of each neighbor of v1 so that consecutive pairs sharing v1 only scan the neighbors of v2
+	++epoch;
+	staged_tallies.fill( 0 );
+	const_edge_iterator v1_out_neighbors_it( g.out_neighbors_begin( v1 ) );
+	const_edge_iterator v1_out_neighbors_end( g.out_neighbors_end( v1 ) );
+	const_edge_iterator v1_in_neighbors_it( g.in_neighbors_begin( v1 ) );
+	const_edge_iterator v1_in_neighbors_end( g.in_neighbors_end( v1 ) );
+	for( std::pair<const_edge_iterator,directedness_value> min1( next_union_element( v1_out_neighbors_it, v1_out_neighbors_end, v1_in_neighbors_it, v1_in_neighbors_end ) ); min1.first != v1_in_neighbors_end; min1 = next_union_element( v1_out_neighbors_it, v1_out_neighbors_end, v1_in_neighbors_it, v1_in_neighbors_end ) ) {
+		std::size_t v3_id( g.vertex_id( g.target_of( min1.first ) ) );
+		neighbor_epochs[v3_id] = epoch;
+		neighbor_directedness[v3_id] = min1.second;
+		++staged_tallies[min1.second];
+	}
+	staged = v1;
 }
 
 }
@@ -17,8 +17,10 @@ You should have received a copy of the GNU General Public License along with the
 #include <cstddef>
 #include <map>
 #include <utility>
+#include <vcp/count_accumulator.hpp>
 #include <vcp/graph.hpp>
 #include <vcp/multirelational_graph.hpp>
+#include <vcp/perf_counters.hpp>
 #include <vcp/vcp_dynamic_mapper.hpp>
 
 namespace vcp {
@@ -33,6 +35,7 @@ class vcp<3,r,0> {
 		typedef typename vcp_dynamic_mapper<3,r,0>::subgraph_address_type subgraph_address_type;
 		vcp( graph_type const & g );
 		std::map<subgraph_address_type,unsigned long> const generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 );
+		template <typename sink_type> void generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink );
 	private:
 		enum connectivity_value : std::size_t { // in bit shifting terms
 			V1V2 = 0 * r,
@@ -40,6 +43,7 @@ class vcp<3,r,0> {
 			V2V3 = 2 * r
 		};
 		graph_type const & g;
+		count_accumulator<subgraph_address_type> counts;
 };
 
 template <std::size_t r>
@@ -49,7 +53,15 @@ vcp<3,r,0>::vcp( graph_type const & g ) : g( g ) {
 template <std::size_t r>
 std::map<typename vcp<3,r,0>::subgraph_address_type,unsigned long> const vcp<3,r,0>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
 	std::map<subgraph_address_type,unsigned long> counts;
+	auto sink = [&counts]( subgraph_address_type const & address, unsigned long count ) { counts.insert( counts.end(), std::make_pair( address, count ) ); };
+	generate_vector( v1, v2, sink );
+	return counts;
+}
 
+template <std::size_t r>
+template <typename sink_type>
+void vcp<3,r,0>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink ) {
+	perf_counters::enter( perf_phase::staging );
 	subgraph_address_type v1v2( subgraph_address_type( g.edge_value( g.edge( v1, v2 ) ) ) << static_cast<std::size_t>( V1V2 ) );
 
 	const_edge_iterator v1_it( g.neighbors_begin( v1 ) );
@@ -66,13 +78,13 @@ std::map<typename vcp<3,r,0>::subgraph_address_type,unsigned long> const vcp<3,r
 		} else {
 			++union_cardinality;
 			if( g.target_of( v1_it ) < g.target_of( v2_it ) ) {
-				++counts.insert( std::make_pair( v1v2 + (subgraph_address_type(g.edge_value( v1_it )) << static_cast<std::size_t>(V1V3)), 0 ) ).first->second;
+				counts.add( v1v2 + (subgraph_address_type(g.edge_value( v1_it )) << static_cast<std::size_t>(V1V3)) );
 				++v1_it;
 			} else if( g.target_of( v1_it ) > g.target_of( v2_it ) ) {
-				++counts.insert( std::make_pair( v1v2 + (subgraph_address_type(g.edge_value( v1_it )) << static_cast<std::size_t>(V2V3)), 0 ) ).first->second;
+				counts.add( v1v2 + (subgraph_address_type(g.edge_value( v2_it )) << static_cast<std::size_t>(V2V3)) );
 				++v2_it;
 			} else {
-				++counts.insert( std::make_pair( v1v2 + (subgraph_address_type(g.edge_value( v1_it )) << static_cast<std::size_t>(V1V3)) + (subgraph_address_type(g.edge_value( v2_it )) <<  static_cast<std::size_t>(V2V3)), 0 ) ).first->second;
+				counts.add( v1v2 + (subgraph_address_type(g.edge_value( v1_it )) << static_cast<std::size_t>(V1V3)) + (subgraph_address_type(g.edge_value( v2_it )) <<  static_cast<std::size_t>(V2V3)) );
 				++v1_it;
 				++v2_it;
 			}
@@ -81,19 +93,20 @@ std::map<typename vcp<3,r,0>::subgraph_address_type,unsigned long> const vcp<3,r
 	while( v1_it != v1_end ) {
 		if( g.target_of( v1_it ) != v2 ) {
 			++union_cardinality;
-			++counts.insert( std::make_pair( v1v2 + (subgraph_address_type(g.edge_value( v1_it )) << static_cast<std::size_t>(V1V3)), 0 ) ).first->second;
+			counts.add( v1v2 + (subgraph_address_type(g.edge_value( v1_it )) << static_cast<std::size_t>(V1V3)) );
 		}
 		++v1_it;
 	} while( v2_it != v2_end ) {
 		if( g.target_of( v2_it ) != v1 ) {
 			++union_cardinality;
-			++counts.insert( std::make_pair( v1v2 + (subgraph_address_type(g.edge_value( v2_it )) << static_cast<std::size_t>(V2V3)), 0 ) ).first->second;
+			counts.add( v1v2 + (subgraph_address_type(g.edge_value( v2_it )) << static_cast<std::size_t>(V2V3)) );
 		}
 		++v2_it;
 	}
-	counts.insert( std::make_pair( v1v2, g.vertex_count() - 2 - union_cardinality ) );
+	counts.add( v1v2, g.vertex_count() - 2 - union_cardinality );
 		
-	return counts;
+	perf_counters::enter( perf_phase::output );
+	counts.flush( sink );
 }
 
 }
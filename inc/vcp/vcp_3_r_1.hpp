@@ -17,8 +17,10 @@ You should have received a copy of the GNU General Public License along with the
 #include <cstddef>
 #include <map>
 #include <utility>
+#include <vcp/count_accumulator.hpp>
 #include <vcp/directed_graph.hpp>
 #include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/perf_counters.hpp>
 #include <vcp/vcp_dynamic_mapper.hpp>
 
 namespace vcp {
@@ -33,6 +35,7 @@ class vcp<3,r,1> {
 		typedef typename vcp_dynamic_mapper<3,r,1>::subgraph_address_type subgraph_address_type;
 		vcp( graph_type const & g );
 		std::map<subgraph_address_type,unsigned long> const generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 );
+		template <typename sink_type> void generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink );
 	private:
 		enum connectivity_value : std::size_t { // in bit shifting terms
 			V1V2 = 0 * r,
@@ -44,6 +47,7 @@ class vcp<3,r,1> {
 			IN = 1 * r
 		};
 		graph_type const & g;
+		count_accumulator<subgraph_address_type> counts;
 		std::pair<const_edge_iterator,std::pair<connectivity_address_type,connectivity_address_type> > next_union_element( const_edge_iterator & it1, const_edge_iterator end1, const_edge_iterator & it2, const_edge_iterator end2 ) const;
 };
 
@@ -81,7 +85,15 @@ std::pair<const_edge_iterator,std::pair<typename vcp<3,r,1>::connectivity_addres
 template <std::size_t r>
 std::map<typename vcp<3,r,1>::subgraph_address_type,unsigned long> const vcp<3,r,1>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
 	std::map<subgraph_address_type,unsigned long> counts;
-	
+	auto sink = [&counts]( subgraph_address_type const & address, unsigned long count ) { counts.insert( counts.end(), std::make_pair( address, count ) ); };
+	generate_vector( v1, v2, sink );
+	return counts;
+}
+
+template <std::size_t r>
+template <typename sink_type>
+void vcp<3,r,1>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink ) {
+	perf_counters::enter( perf_phase::staging );
 	subgraph_address_type v1v2( (subgraph_address_type( g.edge_value( g.out_edge( v1, v2 ) ) ) << (V1V2 + OUT)) + (subgraph_address_type( g.edge_value( g.in_edge( v1, v2 ) ) ) << (V1V2 + IN )) );
 	
 	const_edge_iterator v1_out_neighbors_it( g.out_neighbors_begin( v1 ) );
@@ -99,18 +111,18 @@ std::map<typename vcp<3,r,1>::subgraph_address_type,unsigned long> const vcp<3,r
 		if( g.target_of( min1.first ) < g.target_of( min2.first ) ) {
 			if( g.target_of( min1.first ) != v2 ) {
 				++union_cardinality;
-				++counts.insert( std::make_pair( v1v2 + (subgraph_address_type( min1.second.first ) << (V1V3 + OUT)) + (subgraph_address_type( min1.second.second ) << (V1V3 + IN)), 0 ) ).first->second;
+				counts.add( v1v2 + (subgraph_address_type( min1.second.first ) << (V1V3 + OUT)) + (subgraph_address_type( min1.second.second ) << (V1V3 + IN)) );
 			}
 			min1 = next_union_element( v1_out_neighbors_it, v1_out_neighbors_end, v1_in_neighbors_it, v1_in_neighbors_end );
 		} else if( g.target_of( min1.first ) > g.target_of( min2.first ) ) {
 			if( g.target_of( min2.first ) != v1 ) {
 				++union_cardinality;
-				++counts.insert( std::make_pair( v1v2 + (subgraph_address_type( min2.second.first ) << (V2V3 + OUT)) + (subgraph_address_type( min2.second.second ) << (V2V3 + IN)), 0 ) ).first->second;
+				counts.add( v1v2 + (subgraph_address_type( min2.second.first ) << (V2V3 + OUT)) + (subgraph_address_type( min2.second.second ) << (V2V3 + IN)) );
 			}
 			min2 = next_union_element( v2_out_neighbors_it, v2_out_neighbors_end, v2_in_neighbors_it, v2_in_neighbors_end );
 		} else { // the next neighbor is shared by both v1 and v2, so it cannot be either and we do not need to check to exclude it
 			++union_cardinality;
-			++counts.insert( std::make_pair( v1v2 + ((subgraph_address_type( min1.second.first )) << (V1V3 + OUT)) + (subgraph_address_type( min1.second.second ) << (V1V3 + IN)) + (subgraph_address_type( min2.second.first ) << (V2V3 + OUT)) + (subgraph_address_type( min2.second.second ) << (V2V3 + IN)), 0 ) ).first->second;
+			counts.add( v1v2 + ((subgraph_address_type( min1.second.first )) << (V1V3 + OUT)) + (subgraph_address_type( min1.second.second ) << (V1V3 + IN)) + (subgraph_address_type( min2.second.first ) << (V2V3 + OUT)) + (subgraph_address_type( min2.second.second ) << (V2V3 + IN)) );
 			min1 = next_union_element( v1_out_neighbors_it, v1_out_neighbors_end, v1_in_neighbors_it, v1_in_neighbors_end );
 			min2 = next_union_element( v2_out_neighbors_it, v2_out_neighbors_end, v2_in_neighbors_it, v2_in_neighbors_end );
 		}
@@ -118,21 +130,22 @@ std::map<typename vcp<3,r,1>::subgraph_address_type,unsigned long> const vcp<3,r
 	while( min1.first != v1_in_neighbors_end ) {
 		if( g.target_of( min1.first ) != v2 ) {
 			++union_cardinality;
-			++counts.insert( std::make_pair( v1v2 + (subgraph_address_type( min1.second.first ) << (V1V3 + OUT)) + (subgraph_address_type( min1.second.second ) << (V1V3 + IN)), 0 ) ).first->second;
+			counts.add( v1v2 + (subgraph_address_type( min1.second.first ) << (V1V3 + OUT)) + (subgraph_address_type( min1.second.second ) << (V1V3 + IN)) );
 		}
 		min1 = next_union_element( v1_out_neighbors_it, v1_out_neighbors_end, v1_in_neighbors_it, v1_in_neighbors_end );
 	}
 	while( min2.first != v2_in_neighbors_end ) {
 		if( g.target_of( min2.first ) != v1 ) {
 			++union_cardinality;
-			++counts.insert( std::make_pair( v1v2 + (subgraph_address_type( min2.second.first ) << (V2V3 + OUT)) + (subgraph_address_type( min2.second.second ) << (V2V3 + IN)), 0 ) ).first->second;
+			counts.add( v1v2 + (subgraph_address_type( min2.second.first ) << (V2V3 + OUT)) + (subgraph_address_type( min2.second.second ) << (V2V3 + IN)) );
 		}
 		min2 = next_union_element( v2_out_neighbors_it, v2_out_neighbors_end, v2_in_neighbors_it, v2_in_neighbors_end );
 	}
 	
-	counts.insert( std::make_pair( v1v2, g.vertex_count() - 2 - union_cardinality ) );
+	counts.add( v1v2, g.vertex_count() - 2 - union_cardinality );
 
-	return counts;
+	perf_counters::enter( perf_phase::output );
+	counts.flush( sink );
 }
 
 }
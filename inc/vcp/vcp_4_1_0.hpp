@@ -14,12 +14,17 @@ You should have received a copy of the GNU General Public License along with the
 #ifndef VCP_VCP_4_1_0
 #define VCP_VCP_4_1_0
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
 #include <memory>
 #include <utility>
 #include <vcp/graph.hpp>
+#include <vcp/graph_statistics.hpp>
+#include <vcp/pair_cost.hpp>
+#include <vcp/perf_counters.hpp>
+#include <vcp/v3_sample.hpp>
 
 namespace vcp {
 
@@ -30,9 +35,11 @@ class vcp<4,1,0> {
 	private:
 		constexpr static const std::size_t num_elements = 40;
 	public:
-		vcp( graph const & g );
+		vcp( graph const & g, graph_statistics<1,0> const * statistics = nullptr );
 		constexpr static std::size_t element_count();
 		std::array<unsigned long,num_elements> const generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 );
+		template <typename iterator_type> void generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts );
+		template <typename iterator_type> void estimate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, v3_sample & sample );
 	private:
 		enum connectivity_value {
 			V1V2 = 1,
@@ -47,6 +54,7 @@ class vcp<4,1,0> {
 		static std::size_t element_address( std::size_t subgraph_address );
 		unsigned long unconnected_pairs;
 		std::unique_ptr<std::pair<const_vertex_iterator,unsigned char>[]> v3Vertices;
+		template <typename iterator_type,typename sample_type> void profile( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, sample_type & sample );
 };
 
 std::size_t vcp<4,1,0>::element_address( std::size_t subgraph_address ) {
@@ -58,15 +66,38 @@ constexpr std::size_t vcp<4,1,0>::element_count() {
 	return num_elements;
 }
 
-vcp<4,1,0>::vcp( graph const & g ) :
+vcp<4,1,0>::vcp( graph const & g, graph_statistics<1,0> const * statistics ) :
 		g( g ),
-		unconnected_pairs( (g.vertex_count() * (g.vertex_count() - 1) / 2) - g.edge_count() ),
+		unconnected_pairs( statistics != nullptr ? statistics->count( graph_statistics<1,0>::pair_type( 0, 0 ) ) : (g.vertex_count() * (g.vertex_count() - 1) / 2) - g.edge_count() ),
 		v3Vertices( std::unique_ptr<std::pair<const_vertex_iterator,unsigned char>[]>(new std::pair<const_vertex_iterator,unsigned char>[ MAX_NEIGHBORS ] )) {
 }
 
 
 std::array<unsigned long,vcp<4,1,0>::element_count()> const vcp<4,1,0>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
-	std::array<unsigned long,element_count()> counts = {{0}};
+	std::array<unsigned long,element_count()> counts;
+	generate_vector( v1, v2, counts.begin() );
+	return counts;
+}
+
+template <typename iterator_type>
+void vcp<4,1,0>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts ) {
+	v3_census census;
+	profile( v1, v2, counts, census );
+}
+
+template <typename iterator_type>
+void vcp<4,1,0>::estimate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, v3_sample & sample ) {
+	if( sample.sampling( (g.neighbors_end( v1 ) - g.neighbors_begin( v1 )) + (g.neighbors_end( v2 ) - g.neighbors_begin( v2 )) ) ) {
+		profile( v1, v2, counts, sample );
+	} else {
+		generate_vector( v1, v2, counts );
+	}
+}
+
+template <typename iterator_type,typename sample_type>
+void vcp<4,1,0>::profile( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, sample_type & sample ) {
+	perf_counters::enter( perf_phase::staging );
+	std::fill( counts, counts + element_count(), 0 );
 	
 	std::size_t v1v2( V1V2 * g.edge_exists( v1, v2 ) );
 	
@@ -77,6 +108,7 @@ std::array<unsigned long,vcp<4,1,0>::element_count()> const vcp<4,1,0>::generate
 	const_edge_iterator v1_neighbors_end( g.neighbors_end( v1 ) );
 	const_edge_iterator v2_neighbors_it( g.neighbors_begin( v2 ) );
 	const_edge_iterator v2_neighbors_end( g.neighbors_end( v2 ) );
+	VCP_PAIR_COST( merge_steps, (v1_neighbors_end - v1_neighbors_it) + (v2_neighbors_end - v2_neighbors_it) );
 	assert( MAX_NEIGHBORS > (v1_neighbors_end - v1_neighbors_it) + (v2_neighbors_end - v2_neighbors_it ) ); // this should always be contiguous storage; we can only over-allocate by a factor of 2, which is of much lower cost than maintaining a doubly-linked list; there exists a strict upper bound on the final size of v3Vertices
 	std::pair<const_vertex_iterator,unsigned char>* v3Vertices_begin( &v3Vertices[0] );
 	std::pair<const_vertex_iterator,unsigned char>* v3Vertices_end( &v3Vertices[0] );
@@ -130,10 +162,22 @@ std::array<unsigned long,vcp<4,1,0>::element_count()> const vcp<4,1,0>::generate
 	}
 	
 	unsigned long v3_count( v3Vertices_end - v3Vertices_begin );
+	VCP_PAIR_COST( v3_candidates, v3_count );
+	perf_counters::enter( perf_phase::classification );
 	unsigned long v4_count( 0 );
+	unsigned long const staged_connections( connections );
+	unsigned long const staged_gaps( gaps );
+	auto target( sample.target( counts ) ); // the counts themselves unless sampled candidates are counted apart
+	sample.begin( g.vertex_id( v1 ), g.vertex_id( v2 ), v3_count );
 	for( std::pair<const_vertex_iterator,unsigned char>* it1( v3Vertices_begin ); it1 != v3Vertices_end; ++it1 ) { // for each v3 vertex computed above
+		if( !sample.expand( g.vertex_id( it1->first ) ) ) {
+			continue;
+		}
+		unsigned long const connections_before( connections );
+		unsigned long const gaps_before( gaps );
 		const_edge_iterator v3_neighbors_it( g.neighbors_begin( it1->first ) );
 		const_edge_iterator v3_neighbors_end( g.neighbors_end( it1->first ) );
+		VCP_PAIR_COST( merge_steps, (v3_neighbors_end - v3_neighbors_it) + v3_count );
 		unsigned long v4_local_count( 0 ); // keep track of how many v4 vertices are only the result of the neighbors of this v3
 		for( std::pair<const_vertex_iterator,unsigned char>* it2( v3Vertices_begin ); it2 != v3Vertices_end; ++it2 ) { // consider other v3 vertices as candidate v4 vertices
 			while( v3_neighbors_it != v3_neighbors_end && g.target_of( v3_neighbors_it ) < it2->first ) { // the v3 neighbor is exclusively a v4 vertex
@@ -145,12 +189,12 @@ std::array<unsigned long,vcp<4,1,0>::element_count()> const vcp<4,1,0>::generate
 			if( v3_neighbors_it == v3_neighbors_end || g.target_of( v3_neighbors_it ) > it2->first ) { // there is no edge between the v3 vertex and the other v3 vertex serving as a v4 vertex
 				if( it1->first < it2->first ) { // to be a candidate vertex, the other v3 vertex must be greater to avoid double counting
 					++gaps;
-					++counts[ element_address( it1->second + (it2->second == v1v2 + V1V3 ? V1V4 : (it2->second == v1v2 + V2V3 ? V2V4 : V1V4 + V2V4)) ) ];
+					++target[ element_address( it1->second + (it2->second == v1v2 + V1V3 ? V1V4 : (it2->second == v1v2 + V2V3 ? V2V4 : V1V4 + V2V4)) ) ];
 				}
 			} else { // there is an edge between the v3 vertex and the other v3 vertex serving as a v4 vertex
 				if( it1->first < it2->first ) { // to be a candidate vertex, the other v3 vertex must be greater to avoid double counting
 					++connections;
-					++counts[ element_address( it1->second + (it2->second == v1v2 + V1V3 ? V1V4 : (it2->second == v1v2 + V2V3 ? V2V4 : V1V4 + V2V4)) + V3V4 ) ];
+					++target[ element_address( it1->second + (it2->second == v1v2 + V1V3 ? V1V4 : (it2->second == v1v2 + V2V3 ? V2V4 : V1V4 + V2V4)) + V3V4 ) ];
 				}
 				++v3_neighbors_it;
 			}
@@ -164,8 +208,19 @@ std::array<unsigned long,vcp<4,1,0>::element_count()> const vcp<4,1,0>::generate
 		v4_count += v4_local_count;
 		connections += v4_local_count;
 		gaps += 2*v4_local_count;
-		counts[ element_address( it1->second + V3V4 ) ] += v4_local_count;
-		counts[ element_address( it1->second ) ] += g.vertex_count() - 2 - v3_count - v4_local_count;
+		target[ element_address( it1->second + V3V4 ) ] += v4_local_count;
+		target[ element_address( it1->second ) ] += g.vertex_count() - 2 - v3_count - v4_local_count;
+		if( sample_type::sampled ) { // this candidate's share of the closed-form counts below
+			target[ element_address( v1v2+V3V4 ) ] -= connections - connections_before;
+			target[ element_address( v1v2 ) ] += 3 * v4_local_count - (gaps - gaps_before);
+			sample.fold();
+		}
+	}
+	VCP_PAIR_COST( v4_candidates, v4_count );
+	if( sample_type::sampled ) { // the closed forms below then count what needs no expansion, and finish adds the scaled shares of the candidates
+		connections = staged_connections;
+		gaps = staged_gaps;
+		v4_count = 0;
 	}
 
 	// account for the least connected substructures
@@ -182,8 +237,7 @@ std::array<unsigned long,vcp<4,1,0>::element_count()> const vcp<4,1,0>::generate
 	// unconnected_pairs - (gaps + !static_cast<bool>(v1v2)) - 2*(g.vertex_count() - 2 - v3_count - v4_count) - v3_count*(g.vertex_count() - 2 - v3_count) + v4_count
 	// we can simplify this expression as below
 	counts[ element_address(v1v2) ] = unconnected_pairs - (gaps + !static_cast<bool>(v1v2)) - (2 + v3_count) * (g.vertex_count() - 2 - v3_count) + 3 * v4_count;
-	
-	return counts;
+	sample.finish( counts );
 }
 
 }
@@ -14,11 +14,16 @@ You should have received a copy of the GNU General Public License along with the
 #ifndef VCP_VCP_4_1_1
 #define VCP_VCP_4_1_1
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
 #include <utility>
 #include <vcp/directed_graph.hpp>
+#include <vcp/graph_statistics.hpp>
+#include <vcp/pair_cost.hpp>
+#include <vcp/perf_counters.hpp>
+#include <vcp/v3_sample.hpp>
 
 namespace vcp {
 
@@ -29,9 +34,11 @@ class vcp<4,1,1> {
 	private:
 		constexpr static const std::size_t num_elements = 2112;
 	public:
-		vcp( directed_graph const & );
+		vcp( directed_graph const &, graph_statistics<1,1> const * statistics = nullptr );
 		constexpr static std::size_t element_count();
 		std::array<unsigned long,num_elements> const generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 );
+		template <typename iterator_type> void generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts );
+		template <typename iterator_type> void estimate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, v3_sample & sample );
 	private:
 		enum directedness_value {
 			OUT = 1,
@@ -55,6 +62,7 @@ class vcp<4,1,1> {
 		unsigned long unconnected_pairs;
 		std::unique_ptr<std::pair<const_vertex_iterator,unsigned short>[]> v3Vertices;
 		std::pair<const_edge_iterator,directedness_value> next_union_element( const_edge_iterator &, const_edge_iterator, const_edge_iterator &, const_edge_iterator ) const;
+		template <typename iterator_type,typename sample_type> void profile( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, sample_type & sample );
 };
 
 std::size_t vcp<4,1,1>::element_address( std::size_t subgraph_address ) {
@@ -66,33 +74,38 @@ constexpr std::size_t vcp<4,1,1>::element_count() {
 	return num_elements;
 }
 
-vcp<4,1,1>::vcp( directed_graph const & g ) : g(g), connectedPairs( 0 ), amutualPairs( 0 ), mutualPairs( 0 ), unconnected_pairs( 0 ), v3Vertices( std::unique_ptr<std::pair<const_vertex_iterator,unsigned short>[]>( new std::pair<const_vertex_iterator,unsigned short>[ MAX_NEIGHBORS ] )) {
-	// compute the total number of somehow-connected pairs in the graph
-	for( const_vertex_iterator it( g.vertices_begin() ); it != g.vertices_end(); ++it ) {
-		const_edge_iterator outIt = g.out_neighbors_begin( it );
-		const_edge_iterator outEnd = g.out_neighbors_end( it );
-		const_edge_iterator inIt = g.in_neighbors_begin( it );
-		const_edge_iterator inEnd = g.in_neighbors_end( it );
-		while( outIt != outEnd && g.target_of( outIt ) <= it ) {
-			++outIt;
-		}
-		while( inIt != inEnd && g.target_of( inIt ) <= it ) {
-			++inIt;
-		}
-		while( outIt != outEnd && inIt != inEnd ) {
-			if( g.target_of( outIt ) < g.target_of( inIt ) ) {
-				++amutualPairs;
-				++outIt;
-			} else if( g.target_of( outIt ) > g.target_of( inIt ) ) {
-				++amutualPairs;
-				++inIt;
-			} else {
-				++mutualPairs;
+vcp<4,1,1>::vcp( directed_graph const & g, graph_statistics<1,1> const * statistics ) : g(g), connectedPairs( 0 ), amutualPairs( 0 ), mutualPairs( 0 ), unconnected_pairs( 0 ), v3Vertices( std::unique_ptr<std::pair<const_vertex_iterator,unsigned short>[]>( new std::pair<const_vertex_iterator,unsigned short>[ MAX_NEIGHBORS ] )) {
+	if( statistics != nullptr ) {
+		amutualPairs = statistics->count( graph_statistics<1,1>::pair_type( 0, 1 ) );
+		mutualPairs = statistics->count( graph_statistics<1,1>::pair_type( 1, 1 ) );
+	} else {
+		// compute the total number of somehow-connected pairs in the graph
+		for( const_vertex_iterator it( g.vertices_begin() ); it != g.vertices_end(); ++it ) {
+			const_edge_iterator outIt = g.out_neighbors_begin( it );
+			const_edge_iterator outEnd = g.out_neighbors_end( it );
+			const_edge_iterator inIt = g.in_neighbors_begin( it );
+			const_edge_iterator inEnd = g.in_neighbors_end( it );
+			while( outIt != outEnd && g.target_of( outIt ) <= it ) {
 				++outIt;
+			}
+			while( inIt != inEnd && g.target_of( inIt ) <= it ) {
 				++inIt;
 			}
+			while( outIt != outEnd && inIt != inEnd ) {
+				if( g.target_of( outIt ) < g.target_of( inIt ) ) {
+					++amutualPairs;
+					++outIt;
+				} else if( g.target_of( outIt ) > g.target_of( inIt ) ) {
+					++amutualPairs;
+					++inIt;
+				} else {
+					++mutualPairs;
+					++outIt;
+					++inIt;
+				}
+			}
+			amutualPairs += (outEnd-outIt) + (inEnd-inIt);
 		}
-		amutualPairs += (outEnd-outIt) + (inEnd-inIt);
 	}
 	connectedPairs = amutualPairs + mutualPairs;
 	unsigned long potentialConnections = (unsigned long)g.vertex_count() * (unsigned long)(g.vertex_count() - 1) / 2;
@@ -119,7 +132,30 @@ std::pair<const_edge_iterator,typename vcp<4,1,1>::directedness_value> vcp<4,1,1
 }
 
 std::array<unsigned long,vcp<4,1,1>::element_count()> const vcp<4,1,1>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
-	std::array<unsigned long,element_count()> counts = {{0}};
+	std::array<unsigned long,element_count()> counts;
+	generate_vector( v1, v2, counts.begin() );
+	return counts;
+}
+
+template <typename iterator_type>
+void vcp<4,1,1>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts ) {
+	v3_census census;
+	profile( v1, v2, counts, census );
+}
+
+template <typename iterator_type>
+void vcp<4,1,1>::estimate_vector( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, v3_sample & sample ) {
+	if( sample.sampling( (g.out_neighbors_end( v1 ) - g.out_neighbors_begin( v1 )) + (g.in_neighbors_end( v1 ) - g.in_neighbors_begin( v1 )) + (g.out_neighbors_end( v2 ) - g.out_neighbors_begin( v2 )) + (g.in_neighbors_end( v2 ) - g.in_neighbors_begin( v2 )) ) ) {
+		profile( v1, v2, counts, sample );
+	} else {
+		generate_vector( v1, v2, counts );
+	}
+}
+
+template <typename iterator_type,typename sample_type>
+void vcp<4,1,1>::profile( const_vertex_iterator v1, const_vertex_iterator v2, iterator_type counts, sample_type & sample ) {
+	perf_counters::enter( perf_phase::staging );
+	std::fill( counts, counts + element_count(), 0 );
 	
 	std::size_t v1v2( V1V2 * OUT * g.out_edge_exists( v1, v2 ) + V1V2 * IN * g.in_edge_exists( v1, v2 ) );
 	
@@ -136,6 +172,7 @@ std::array<unsigned long,vcp<4,1,1>::element_count()> const vcp<4,1,1>::generate
 	const_edge_iterator v2_out_neighbors_end( g.out_neighbors_end( v2 ) );
 	const_edge_iterator v2_in_neighbors_it( g.in_neighbors_begin( v2 ) );
 	const_edge_iterator v2_in_neighbors_end( g.in_neighbors_end( v2 ) );
+	VCP_PAIR_COST( merge_steps, (v1_out_neighbors_end - v1_out_neighbors_it) + (v1_in_neighbors_end - v1_in_neighbors_it) + (v2_out_neighbors_end - v2_out_neighbors_it) + (v2_in_neighbors_end - v2_in_neighbors_it) );
 	assert( MAX_NEIGHBORS > (v1_out_neighbors_end-v1_out_neighbors_it)+(v1_in_neighbors_end-v1_in_neighbors_it)+(v2_out_neighbors_end-v2_out_neighbors_it)+(v2_in_neighbors_end-v2_in_neighbors_it) );
 	std::pair<const_vertex_iterator,unsigned short>* v3Vertices_begin( &v3Vertices[0] );
 	std::pair<const_vertex_iterator,unsigned short>* v3Vertices_end( &v3Vertices[0] );
@@ -209,12 +246,26 @@ std::array<unsigned long,vcp<4,1,1>::element_count()> const vcp<4,1,1>::generate
 	}
 
 	unsigned long v3_count( v3Vertices_end-v3Vertices_begin );
+	VCP_PAIR_COST( v3_candidates, v3_count );
+	perf_counters::enter( perf_phase::classification );
 	unsigned long v4_count( 0 );
+	unsigned long const staged_connections( connections );
+	unsigned long const staged_amutuals( amutuals );
+	unsigned long const staged_gaps( gaps );
+	auto target( sample.target( counts ) ); // the counts themselves unless sampled candidates are counted apart
+	sample.begin( g.vertex_id( v1 ), g.vertex_id( v2 ), v3_count );
 	for( std::pair<const_vertex_iterator,unsigned short>* it1( v3Vertices_begin ); it1 != v3Vertices_end; ++it1 ) { // for each v3 vertex computed above
+		if( !sample.expand( g.vertex_id( it1->first ) ) ) {
+			continue;
+		}
+		unsigned long const connections_before( connections );
+		unsigned long const amutuals_before( amutuals );
+		unsigned long const gaps_before( gaps );
 		const_edge_iterator v3_out_neighbors_it( g.out_neighbors_begin( it1->first ) );
 		const_edge_iterator v3_out_neighbors_end( g.out_neighbors_end( it1->first ) );
 		const_edge_iterator v3_in_neighbors_it( g.in_neighbors_begin( it1->first ) );
 		const_edge_iterator v3_in_neighbors_end( g.in_neighbors_end( it1->first ) );
+		VCP_PAIR_COST( merge_steps, (v3_out_neighbors_end - v3_out_neighbors_it) + (v3_in_neighbors_end - v3_in_neighbors_it) + v3_count );
 		unsigned long v4_local_count( 0 ); // keep track of how many v4 vertices are only the result of the neighbors of this v3
 		std::pair<const_edge_iterator,directedness_value> min( next_union_element( v3_out_neighbors_it, v3_out_neighbors_end, v3_in_neighbors_it, v3_in_neighbors_end ) );
 		for( std::pair<const_vertex_iterator,unsigned short>* it2( v3Vertices_begin ); it2 != v3Vertices_end; ++it2 ) {	
@@ -224,7 +275,7 @@ std::array<unsigned long,vcp<4,1,1>::element_count()> const vcp<4,1,1>::generate
 					if( min.second < 3 ) {
 						++amutuals;
 					}
-					++counts[ element_address( it1->second + V3V4 * min.second ) ];
+					++target[ element_address( it1->second + V3V4 * min.second ) ];
 				}
 				min = next_union_element( v3_out_neighbors_it, v3_out_neighbors_end, v3_in_neighbors_it, v3_in_neighbors_end );
 			}
@@ -232,22 +283,22 @@ std::array<unsigned long,vcp<4,1,1>::element_count()> const vcp<4,1,1>::generate
 				if( it1->first < it2->first ) {
 					unsigned short temp( it2->second - v1v2 );
 					std::size_t contrib( 0 );
-					contrib += V1V4 * (temp % V2V3);
+					contrib += V1V4 * ((temp % V2V3) / V1V3);
 					contrib += V2V4 * (temp / V2V3);
 					++gaps;
-					++counts[ element_address( it1->second + contrib ) ];
+					++target[ element_address( it1->second + contrib ) ];
 				}
 			} else {
 				if( it1->first < it2->first ) {
 					unsigned short temp( it2->second - v1v2 );
 					std::size_t contrib( 0 );
-					contrib += V1V4 * (temp % V2V3);
+					contrib += V1V4 * ((temp % V2V3) / V1V3);
 					contrib += V2V4 * (temp / V2V3);
 					++connections;
 					if( min.second < 3 ) {
 						++amutuals;
 					}
-					++counts[ element_address( it1->second + contrib + V3V4 * min.second  ) ];
+					++target[ element_address( it1->second + contrib + V3V4 * min.second  ) ];
 				}
 				min = next_union_element( v3_out_neighbors_it, v3_out_neighbors_end, v3_in_neighbors_it, v3_in_neighbors_end );
 			}
@@ -258,22 +309,35 @@ std::array<unsigned long,vcp<4,1,1>::element_count()> const vcp<4,1,1>::generate
 				if( min.second < 3 ) {
 					++amutuals;
 				}
-				++counts[ element_address( it1->second + V3V4 * min.second ) ];
+				++target[ element_address( it1->second + V3V4 * min.second ) ];
 			}
 			min = next_union_element( v3_out_neighbors_it, v3_out_neighbors_end, v3_in_neighbors_it, v3_in_neighbors_end );
 		}
 		v4_count += v4_local_count;
 		connections += v4_local_count;
 		gaps += 2*v4_local_count;
-		counts[ element_address( it1->second ) ] += g.vertex_count() - 2 - v3_count - v4_local_count;
+		target[ element_address( it1->second ) ] += g.vertex_count() - 2 - v3_count - v4_local_count;
+		if( sample_type::sampled ) { // this candidate's share of the closed-form counts below
+			target[ element_address( v1v2+OUT*V3V4 ) ] -= amutuals - amutuals_before;
+			target[ element_address( v1v2+BOTH*V3V4 ) ] -= (connections - connections_before) - (amutuals - amutuals_before);
+			target[ element_address( v1v2 ) ] += 3 * v4_local_count - (gaps - gaps_before);
+			sample.fold();
+		}
+	}
+	VCP_PAIR_COST( v4_candidates, v4_count );
+	if( sample_type::sampled ) { // the closed forms below then count what needs no expansion, and finish adds the scaled shares of the candidates
+		connections = staged_connections;
+		amutuals = staged_amutuals;
+		gaps = staged_gaps;
+		v4_count = 0;
 	}
 		
 	// account for the least connected substructures
-	counts[ element_address( v1v2+OUT*V3V4) ] = this->amutualPairs - (amutuals + static_cast<bool>(v1v2)); // out and in versions are isomorphically equivalent and do not need to be counted separately
-	counts[ element_address( v1v2+BOTH*V3V4 ) ] = this->mutualPairs - (connections - amutuals);
+	bool const v1v2_mutual( v1v2 == V1V2 * BOTH ); // the connection between v1 and v2 is excluded from the pairs of its own kind
+	counts[ element_address( v1v2+OUT*V3V4) ] = this->amutualPairs - (amutuals + (static_cast<bool>(v1v2) && !v1v2_mutual)); // out and in versions are isomorphically equivalent and do not need to be counted separately
+	counts[ element_address( v1v2+BOTH*V3V4 ) ] = this->mutualPairs - (connections - amutuals + v1v2_mutual);
 	counts[ element_address( v1v2 ) ] = unconnected_pairs - (gaps + !static_cast<bool>(v1v2)) - (2 + v3_count) * (g.vertex_count() - 2 - v3_count) + 3 * v4_count;
-	
-	return counts;
+	sample.finish( counts );
 }
 
 
@@ -18,7 +18,11 @@ You should have received a copy of the GNU General Public License along with the
 #include <cassert>
 #include <map>
 #include <utility>
+#include <vcp/count_accumulator.hpp>
+#include <vcp/graph_statistics.hpp>
 #include <vcp/multirelational_graph.hpp>
+#include <vcp/pair_cost.hpp>
+#include <vcp/perf_counters.hpp>
 #include <vcp/square_matrix.hpp>
 #include <vcp/vcp_dynamic_mapper.hpp>
 
@@ -31,18 +35,27 @@ class vcp<4,r,0> {
 	public:
 		typedef typename multirelational_graph<r>::connectivity_address_type connectivity_address_type;
 		typedef typename vcp_dynamic_mapper<4,r,0>::subgraph_address_type subgraph_address_type;
-		vcp( multirelational_graph<r> const & g );
+		vcp( multirelational_graph<r> const & g, graph_statistics<r,0> const * statistics = nullptr );
 		std::map<subgraph_address_type,unsigned long> const generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 );
+		template <typename sink_type> void generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink );
 	private:
 		typedef square_matrix<connectivity_address_type,4> connectivity_matrix;
 		multirelational_graph<r> const & g;
 		vcp_dynamic_mapper<4,r,0> mapper;
 		std::map<connectivity_address_type,unsigned long> edge_types;
+		std::map<connectivity_address_type,unsigned long> temp_edge_types;
+		count_accumulator<subgraph_address_type> counts;
 		std::unique_ptr<std::pair<const_vertex_iterator,connectivity_matrix>[]> v3Vertices;
 };
 
 template <std::size_t r>
-vcp<4,r,0>::vcp( multirelational_graph<r> const & g ) : g( g ), mapper(), v3Vertices( std::unique_ptr<std::pair<const_vertex_iterator,connectivity_matrix>[]>(new std::pair<const_vertex_iterator,connectivity_matrix>[ MAX_NEIGHBORS ] )) {
+vcp<4,r,0>::vcp( multirelational_graph<r> const & g, graph_statistics<r,0> const * statistics ) : g( g ), mapper(), v3Vertices( std::unique_ptr<std::pair<const_vertex_iterator,connectivity_matrix>[]>(new std::pair<const_vertex_iterator,connectivity_matrix>[ MAX_NEIGHBORS ] )) {
+	if( statistics != nullptr ) {
+		for( typename std::map<typename graph_statistics<r,0>::pair_type,unsigned long>::const_iterator it( statistics->pair_types().begin() ); it != statistics->pair_types().end(); ++it ) {
+			edge_types.insert( edge_types.end(), std::make_pair( it->first.second, it->second ) ); // undirected types are (0, value)
+		}
+		return;
+	}
 	unsigned long & gaps( edge_types.insert( std::make_pair( 0, g.vertex_count() * (g.vertex_count() - 1) / 2 ) ).first->second );
 	for( const_vertex_iterator it( g.vertices_begin() ); it != g.vertices_end(); ++it ) {
 		for( const_edge_iterator eIt( g.neighbors_begin( it ) ); eIt != g.neighbors_end( it ); ++eIt ) {
@@ -57,7 +70,18 @@ vcp<4,r,0>::vcp( multirelational_graph<r> const & g ) : g( g ), mapper(), v3Vert
 template <std::size_t r>
 std::map<typename vcp<4,r,0>::subgraph_address_type,unsigned long> const vcp<4,r,0>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
 	std::map<subgraph_address_type,unsigned long> counts;
-	std::map<connectivity_address_type,unsigned long> temp_edge_types;
+	auto sink = [&counts]( subgraph_address_type const & address, unsigned long count ) { counts.insert( counts.end(), std::make_pair( address, count ) ); };
+	generate_vector( v1, v2, sink );
+	return counts;
+}
+
+template <std::size_t r>
+template <typename sink_type>
+void vcp<4,r,0>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink ) {
+	perf_counters::enter( perf_phase::staging );
+	for( typename std::map<connectivity_address_type,unsigned long>::iterator it( temp_edge_types.begin() ); it != temp_edge_types.end(); ++it ) { // reset rather than clear so that observed edge types do not reallocate per pair
+		it->second = 0;
+	}
 
 	connectivity_matrix connectivity;
 	connectivity( 0, 1 ) = g.edge_value( g.edge( v1, v2 ) );
@@ -68,6 +92,7 @@ std::map<typename vcp<4,r,0>::subgraph_address_type,unsigned long> const vcp<4,r
 	const_edge_iterator v1_neighbors_end( g.neighbors_end( v1 ) );
 	const_edge_iterator v2_neighbors_it( g.neighbors_begin( v2 ) );
 	const_edge_iterator v2_neighbors_end( g.neighbors_end( v2 ) );
+	VCP_PAIR_COST( merge_steps, (v1_neighbors_end - v1_neighbors_it) + (v2_neighbors_end - v2_neighbors_it) );
 	assert( MAX_NEIGHBORS > (v1_neighbors_end - v1_neighbors_it) + (v2_neighbors_end - v2_neighbors_it ) ); // this should always be contiguous storage; we can only over-allocate by a factor of 2, which is of much lower cost than maintaining a doubly-linked list; there exists a strict upper bound on the final size of v3Vertices
 	std::pair<const_vertex_iterator,connectivity_matrix>* v3Vertices_begin( &v3Vertices[0] );
 	std::pair<const_vertex_iterator,connectivity_matrix>* v3Vertices_end( &v3Vertices[0] );
@@ -88,7 +113,7 @@ std::map<typename vcp<4,r,0>::subgraph_address_type,unsigned long> const vcp<4,r
 				++gaps;
 				v3Vertices_end->first = g.target_of( v2_neighbors_it );
 				v3Vertices_end->second = connectivity;
-				v3Vertices_end->second( 1, 2 ) = g.edge_value( v1_neighbors_it );
+				v3Vertices_end->second( 1, 2 ) = g.edge_value( v2_neighbors_it );
 				++v3Vertices_end;
 			}
 			++v2_neighbors_it;
@@ -121,17 +146,20 @@ std::map<typename vcp<4,r,0>::subgraph_address_type,unsigned long> const vcp<4,r
 			++gaps;
 			v3Vertices_end->first = g.target_of( v2_neighbors_it );
 			v3Vertices_end->second = connectivity;
-			v3Vertices_end->second( 1, 2 ) = g.edge_value( v1_neighbors_it );
+			v3Vertices_end->second( 1, 2 ) = g.edge_value( v2_neighbors_it );
 			++v3Vertices_end;
 		}
 		++v2_neighbors_it;
 	}
 	
 	std::size_t v3_count( v3Vertices_end-v3Vertices_begin );
+	VCP_PAIR_COST( v3_candidates, v3_count );
+	perf_counters::enter( perf_phase::classification );
 	std::size_t v4_count( 0 );
 	for( std::pair<const_vertex_iterator,connectivity_matrix>* it1( v3Vertices_begin ); it1 != v3Vertices_end; ++it1 ) { // for each v3 vertex computed above
 		const_edge_iterator v3_neighbors_it( g.neighbors_begin( it1->first ) );
 		const_edge_iterator v3_neighbors_end( g.neighbors_end( it1->first ) );
+		VCP_PAIR_COST( merge_steps, (v3_neighbors_end - v3_neighbors_it) + v3_count );
 		unsigned long v4_local_count( 0 ); // keep track of how many v4 vertices are only the result of the neighbors of this v3
 		for( std::pair<const_vertex_iterator,connectivity_matrix>* it2( v3Vertices_begin ); it2 != v3Vertices_end; ++it2 ) { // consider other v3 vertices as candidate v4 vertices
 			while( v3_neighbors_it != v3_neighbors_end && g.target_of( v3_neighbors_it ) < it2->first ) { // the v3 neighbor is exclusively a v4 vertex
@@ -141,7 +169,7 @@ std::map<typename vcp<4,r,0>::subgraph_address_type,unsigned long> const vcp<4,r
 					it1->second( 0, 3 ) = 0;
 					it1->second( 1, 3 ) = 0;
 					it1->second( 2, 3 ) = g.edge_value( v3_neighbors_it );
-					++counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second;
+					counts.add( mapper.canonical_subgraph_address( it1->second ) );
 				}
 				++v3_neighbors_it;
 			}
@@ -151,7 +179,7 @@ std::map<typename vcp<4,r,0>::subgraph_address_type,unsigned long> const vcp<4,r
 					it1->second( 0, 3 ) = it2->second( 0, 2 );
 					it1->second( 1, 3 ) = it2->second( 1, 2 );
 					it1->second( 2, 3 ) = 0;
-					++counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second;
+					counts.add( mapper.canonical_subgraph_address( it1->second ) );
 				}
 			} else { // there is an edge between the v3 vertex and the other v3 vertex serving as a v4 vertex
 				if( it1->first < it2->first ) { // to be a candidate vertex, the other v3 vertex must be greater to avoid double counting
@@ -159,7 +187,7 @@ std::map<typename vcp<4,r,0>::subgraph_address_type,unsigned long> const vcp<4,r
 					it1->second( 0, 3 ) = it2->second( 0, 2 );
 					it1->second( 1, 3 ) = it2->second( 1, 2 );
 					it1->second( 2, 3 ) = g.edge_value( v3_neighbors_it );
-					++counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second;
+					counts.add( mapper.canonical_subgraph_address( it1->second ) );
 				}
 				++v3_neighbors_it;
 			}
@@ -171,7 +199,7 @@ std::map<typename vcp<4,r,0>::subgraph_address_type,unsigned long> const vcp<4,r
 				it1->second( 0, 3 ) = 0;
 				it1->second( 1, 3 ) = 0;
 				it1->second( 2, 3 ) = g.edge_value( v3_neighbors_it );
-				++counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second;
+				counts.add( mapper.canonical_subgraph_address( it1->second ) );
 			}
 			++v3_neighbors_it;
 		}
@@ -180,24 +208,29 @@ std::map<typename vcp<4,r,0>::subgraph_address_type,unsigned long> const vcp<4,r
 		it1->second( 0, 3 ) = 0;
 		it1->second( 1, 3 ) = 0;
 		it1->second( 2, 3 ) = 0;
-		counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second += g.vertex_count() - 2 - v3_count - v4_local_count;
+		counts.add( mapper.canonical_subgraph_address( it1->second ), g.vertex_count() - 2 - v3_count - v4_local_count );
 	}
+	VCP_PAIR_COST( v4_candidates, v4_count );
 
 	// account for the least connected substructures
 	for( typename std::map<connectivity_address_type,unsigned long>::const_iterator it( edge_types.begin() ); it != edge_types.end(); ++it ) {
 		connectivity( 2, 3 ) = it->first;
 		unsigned long count = it->second;
+		if( it->first == connectivity( 0, 1 ) ) { // the edge or gap between v1 and v2 is not one between v3 and v4
+			--count;
+		}
 		typename std::map<connectivity_address_type,unsigned long>::const_iterator temp_it( temp_edge_types.find( it->first ) );
 		if( temp_it != temp_edge_types.end() ) {
 			count -= temp_it->second;
 			if( it->first == 0 ) {
-				count -= !static_cast<bool>( connectivity( 0, 1 ) ) + (2 + v3_count) * (g.vertex_count() - 2 - v3_count) - 3 * v4_count;
+				count -= (2 + v3_count) * (g.vertex_count() - 2 - v3_count) - 3 * v4_count;
 			}
 		}
-		counts.insert( std::make_pair( mapper.canonical_subgraph_address( connectivity ), 0 ) ).first->second += count;
+		counts.add( mapper.canonical_subgraph_address( connectivity ), count );
 	}
 	
-	return counts;
+	perf_counters::enter( perf_phase::output );
+	counts.flush( sink );
 }
 
 }
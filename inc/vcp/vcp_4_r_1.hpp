@@ -18,7 +18,11 @@ You should have received a copy of the GNU General Public License along with the
 #include <cstddef>
 #include <map>
 #include <utility>
+#include <vcp/count_accumulator.hpp>
+#include <vcp/graph_statistics.hpp>
 #include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/pair_cost.hpp>
+#include <vcp/perf_counters.hpp>
 #include <vcp/square_matrix.hpp>
 #include <vcp/vcp_dynamic_mapper.hpp>
 
@@ -31,20 +35,27 @@ class vcp<4,r,1> {
 	public:
 		typedef typename multirelational_directed_graph<r>::connectivity_address_type connectivity_address_type;
 		typedef typename vcp_dynamic_mapper<4,r,1>::subgraph_address_type subgraph_address_type;
-		vcp( multirelational_directed_graph<r> const & );
+		vcp( multirelational_directed_graph<r> const &, graph_statistics<r,1> const * statistics = nullptr );
 		std::map<subgraph_address_type,unsigned long> const generate_vector( const_vertex_iterator, const_vertex_iterator );
+		template <typename sink_type> void generate_vector( const_vertex_iterator, const_vertex_iterator, sink_type & );
 	private:
 		typedef square_matrix<connectivity_address_type,4> connectivity_matrix;
 		multirelational_directed_graph<r> const & g;
 		vcp_dynamic_mapper<4,r,1> mapper;
 		std::map<std::pair<connectivity_address_type,connectivity_address_type>,unsigned long> edge_types;
+		std::map<std::pair<connectivity_address_type,connectivity_address_type>,unsigned long> temp_edge_types;
+		count_accumulator<subgraph_address_type> counts;
 		std::unique_ptr<std::pair<const_vertex_iterator,connectivity_matrix >[]> v3Vertices;
 		std::pair<const_edge_iterator,std::pair<connectivity_address_type,connectivity_address_type> > next_union_element( const_edge_iterator &, const_edge_iterator, const_edge_iterator &, const_edge_iterator ) const;
 
 };
 
 template <std::size_t r>
-vcp<4,r,1>::vcp( multirelational_directed_graph<r> const & g ) : g(g), mapper(), v3Vertices( std::unique_ptr<std::pair<const_vertex_iterator,connectivity_matrix>[]>(new std::pair<const_vertex_iterator,connectivity_matrix>[ MAX_NEIGHBORS ] )) {
+vcp<4,r,1>::vcp( multirelational_directed_graph<r> const & g, graph_statistics<r,1> const * statistics ) : g(g), mapper(), v3Vertices( std::unique_ptr<std::pair<const_vertex_iterator,connectivity_matrix>[]>(new std::pair<const_vertex_iterator,connectivity_matrix>[ MAX_NEIGHBORS ] )) {
+	if( statistics != nullptr ) {
+		edge_types = statistics->pair_types();
+		return;
+	}
 	unsigned long & gaps( edge_types.insert( std::make_pair( std::make_pair( 0, 0 ), g.vertex_count() * (g.vertex_count() - 1) / 2 ) ).first->second );
 	for( const_vertex_iterator it( g.vertices_begin() ); it != g.vertices_end(); ++it ) {
 		const_edge_iterator outIt = g.out_neighbors_begin( it );
@@ -116,7 +127,18 @@ std::pair<const_edge_iterator,std::pair<typename vcp<4,r,1>::connectivity_addres
 template <std::size_t r>
 std::map<typename vcp<4,r,1>::subgraph_address_type,unsigned long> const vcp<4,r,1>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2 ) {
 	std::map<subgraph_address_type,unsigned long> counts;
-	std::map<std::pair<connectivity_address_type,connectivity_address_type>,unsigned long> temp_edge_types;
+	auto sink = [&counts]( subgraph_address_type const & address, unsigned long count ) { counts.insert( counts.end(), std::make_pair( address, count ) ); };
+	generate_vector( v1, v2, sink );
+	return counts;
+}
+
+template <std::size_t r>
+template <typename sink_type>
+void vcp<4,r,1>::generate_vector( const_vertex_iterator v1, const_vertex_iterator v2, sink_type & sink ) {
+	perf_counters::enter( perf_phase::staging );
+	for( typename std::map<std::pair<connectivity_address_type,connectivity_address_type>,unsigned long>::iterator it( temp_edge_types.begin() ); it != temp_edge_types.end(); ++it ) { // reset rather than clear so that observed edge types do not reallocate per pair
+		it->second = 0;
+	}
 	
 	connectivity_matrix connectivity;
 	connectivity( 0, 1 ) = g.edge_value( g.out_edge( v1, v2 ) );
@@ -133,6 +155,7 @@ std::map<typename vcp<4,r,1>::subgraph_address_type,unsigned long> const vcp<4,r
 	const_edge_iterator v2_out_neighbors_end( g.out_neighbors_end( v2 ) );
 	const_edge_iterator v2_in_neighbors_it( g.in_neighbors_begin( v2 ) );
 	const_edge_iterator v2_in_neighbors_end( g.in_neighbors_end( v2 ) );
+	VCP_PAIR_COST( merge_steps, (v1_out_neighbors_end - v1_out_neighbors_it) + (v1_in_neighbors_end - v1_in_neighbors_it) + (v2_out_neighbors_end - v2_out_neighbors_it) + (v2_in_neighbors_end - v2_in_neighbors_it) );
 	assert( MAX_NEIGHBORS > (v1_out_neighbors_end-v1_out_neighbors_it)+(v1_in_neighbors_end-v1_in_neighbors_it)+(v2_out_neighbors_end-v2_out_neighbors_it)+(v2_in_neighbors_end-v2_in_neighbors_it) );
 	std::pair<const_vertex_iterator,connectivity_matrix>* v3Vertices_begin( &v3Vertices[0] );
 	std::pair<const_vertex_iterator,connectivity_matrix>* v3Vertices_end( &v3Vertices[0] );
@@ -201,12 +224,15 @@ std::map<typename vcp<4,r,1>::subgraph_address_type,unsigned long> const vcp<4,r
 	}
 
 	std::size_t v3_count( v3Vertices_end-v3Vertices_begin );
+	VCP_PAIR_COST( v3_candidates, v3_count );
+	perf_counters::enter( perf_phase::classification );
 	std::size_t v4_count( 0 );
 	for( std::pair<const_vertex_iterator,connectivity_matrix >* it1( v3Vertices_begin ); it1 != v3Vertices_end; ++it1 ) { // for each v3 vertex computed above
 		const_edge_iterator v3_out_neighbors_it( g.out_neighbors_begin( it1->first ) );
 		const_edge_iterator v3_out_neighbors_end( g.out_neighbors_end( it1->first ) );
 		const_edge_iterator v3_in_neighbors_it( g.in_neighbors_begin( it1->first ) );
 		const_edge_iterator v3_in_neighbors_end( g.in_neighbors_end( it1->first ) );
+		VCP_PAIR_COST( merge_steps, (v3_out_neighbors_end - v3_out_neighbors_it) + (v3_in_neighbors_end - v3_in_neighbors_it) + v3_count );
 		unsigned long v4_local_count( 0 ); // keep track of how many v4 vertices are only the result of the neighbors of this v3
 		std::pair<const_edge_iterator,std::pair<connectivity_address_type,connectivity_address_type> > min( next_union_element( v3_out_neighbors_it, v3_out_neighbors_end, v3_in_neighbors_it, v3_in_neighbors_end ) );
 		for( std::pair<const_vertex_iterator,connectivity_matrix>* it2( v3Vertices_begin ); it2 != v3Vertices_end; ++it2 ) {	
@@ -220,7 +246,7 @@ std::map<typename vcp<4,r,1>::subgraph_address_type,unsigned long> const vcp<4,r
 					it1->second( 3, 1 ) = 0;
 					it1->second( 2, 3 ) = min.second.first;
 					it1->second( 3, 2 ) = min.second.second;
-					++counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second;
+					counts.add( mapper.canonical_subgraph_address( it1->second ) );
 				}
 				min = next_union_element( v3_out_neighbors_it, v3_out_neighbors_end, v3_in_neighbors_it, v3_in_neighbors_end );
 			}
@@ -233,7 +259,7 @@ std::map<typename vcp<4,r,1>::subgraph_address_type,unsigned long> const vcp<4,r
 					it1->second( 3, 1 ) = it2->second( 2, 1 );
 					it1->second( 2, 3 ) = 0;
 					it1->second( 3, 2 ) = 0;
-					++counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second;
+					counts.add( mapper.canonical_subgraph_address( it1->second ) );
 				}
 			} else {
 				if( it1->first < it2->first ) {
@@ -243,8 +269,8 @@ std::map<typename vcp<4,r,1>::subgraph_address_type,unsigned long> const vcp<4,r
 					it1->second( 1, 3 ) = it2->second( 1, 2 );
 					it1->second( 3, 1 ) = it2->second( 2, 1 );
 					it1->second( 2, 3 ) = min.second.first;
-					it1->second( 3, 3 ) = min.second.second;
-					++counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second;
+					it1->second( 3, 2 ) = min.second.second;
+					counts.add( mapper.canonical_subgraph_address( it1->second ) );
 				}
 				min = next_union_element( v3_out_neighbors_it, v3_out_neighbors_end, v3_in_neighbors_it, v3_in_neighbors_end );
 			}
@@ -259,7 +285,7 @@ std::map<typename vcp<4,r,1>::subgraph_address_type,unsigned long> const vcp<4,r
 				it1->second( 3, 1 ) = 0;
 				it1->second( 2, 3 ) = min.second.first;
 				it1->second( 3, 2 ) = min.second.second;
-				++counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second;
+				counts.add( mapper.canonical_subgraph_address( it1->second ) );
 			}
 			min = next_union_element( v3_out_neighbors_it, v3_out_neighbors_end, v3_in_neighbors_it, v3_in_neighbors_end );
 		}
@@ -271,25 +297,30 @@ std::map<typename vcp<4,r,1>::subgraph_address_type,unsigned long> const vcp<4,r
 		it1->second( 3, 1 ) = 0;
 		it1->second( 2, 3 ) = 0;
 		it1->second( 3, 2 ) = 0;
-		counts.insert( std::make_pair( mapper.canonical_subgraph_address( it1->second ), 0 ) ).first->second += g.vertex_count() - 2 - ((v3Vertices_end-v3Vertices_begin) + v4_local_count);
+		counts.add( mapper.canonical_subgraph_address( it1->second ), g.vertex_count() - 2 - ((v3Vertices_end-v3Vertices_begin) + v4_local_count) );
 	}
+	VCP_PAIR_COST( v4_candidates, v4_count );
 		
 	for( typename std::map<std::pair<connectivity_address_type,connectivity_address_type>,unsigned long>::const_iterator it( edge_types.begin() ); it != edge_types.end(); ++it ) {
 		connectivity( 2, 3 ) = it->first.first; // THESE ARE ALWAYS GOING TO BE COLLAPSED ISOMORPHICALLY EQUIVALENTLY HERE, SO WE CAN BENCHMARK AFTER GETTING RID OF THE UGLY MAKE_PAIRS
 		connectivity( 3, 2 ) = it->first.second;
 		typename std::map<std::pair<connectivity_address_type,connectivity_address_type>,unsigned long>::const_iterator temp_it( temp_edge_types.find( it->first ) );
 		unsigned long count( it->second );
+		if( it->first == (connectivity( 0, 1 ) < connectivity( 1, 0 ) ? std::make_pair( connectivity( 0, 1 ), connectivity( 1, 0 ) ) : std::make_pair( connectivity( 1, 0 ), connectivity( 0, 1 ) )) ) { // the edges or gap between v1 and v2 are not ones between v3 and v4
+			--count;
+		}
 		if( temp_it != temp_edge_types.end() ) {
 			count -= temp_it->second;
 			if( it->first.first == 0 && it->first.second == 0 ) {
-				count -= !static_cast<bool>( connectivity( 0, 1 ) + connectivity( 1, 0 ) ) + (2 + v3_count) * (g.vertex_count() - 2 - v3_count) - 3 * v4_count;
+				count -= (2 + v3_count) * (g.vertex_count() - 2 - v3_count) - 3 * v4_count;
 			}
 		}
-		counts.insert( std::make_pair( mapper.canonical_subgraph_address( connectivity ), 0 ) ).first->second += count;
+		counts.add( mapper.canonical_subgraph_address( connectivity ), count );
 	}
 
 	
-	return counts;
+	perf_counters::enter( perf_phase::output );
+	counts.flush( sink );
 }
 
 }
@@ -0,0 +1,171 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_VCP_CANONICAL_MAPPER
+#define VCP_VCP_CANONICAL_MAPPER
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace vcp {
+
+class vcp_canonical_mapper {
+	public:
+		static std::size_t subgraph_count( std::size_t n, std::size_t r, bool d );
+		vcp_canonical_mapper( std::size_t n, std::size_t r, bool d );
+		std::size_t n() const;
+		std::size_t r() const;
+		bool d() const;
+		std::size_t element_count() const;
+		std::size_t canonical_address( std::size_t subgraph_address ) const;
+		std::size_t element_address( std::size_t subgraph_address ) const;
+		std::size_t subgraph_address( std::size_t element_address ) const;
+	private:
+		constexpr static const std::size_t chunk_bits = 8;
+		std::size_t n_;
+		std::size_t r_;
+		bool d_;
+		std::size_t bits;
+		std::size_t chunks;
+		std::size_t permutation_count;
+		std::vector<std::size_t> permutation_tables; // permuted image of every byte of an address, for each permutation fixing v1 and v2
+		std::vector<std::size_t> representatives; // smallest subgraph address of each isomorphism class, in ascending order
+		std::size_t permute( std::size_t permutation, std::size_t address ) const;
+		bool is_maximal( std::size_t address ) const;
+};
+
+constexpr const std::size_t vcp_canonical_mapper::chunk_bits;
+
+std::size_t vcp_canonical_mapper::subgraph_count( std::size_t n, std::size_t r, bool d ) {
+	return std::size_t( 1 ) << n*(n-1)*r*(d+1)/2;
+}
+
+vcp_canonical_mapper::vcp_canonical_mapper( std::size_t n, std::size_t r, bool d ) : n_(n), r_(r), d_(d), bits( n*(n-1)*r*(d+1)/2 ), chunks( (bits + chunk_bits - 1) / chunk_bits ), permutation_count( 0 ) {
+	if( bits >= CHAR_BIT * sizeof( std::size_t ) ) {
+		throw std::length_error( "subgraph addresses for this VCP exceed the width of std::size_t" );
+	}
+	std::vector<std::size_t> cell_index( n_ * n_ ); // the same cell ordering as vcp_static_mapper
+	std::size_t index( 0 );
+	for( std::size_t row( 0 ); row < n_; ++row ) {
+		for( std::size_t column( row + 1 ); column < n_; ++column ) {
+			cell_index[row * n_ + column] = index++;
+			cell_index[column * n_ + row] = d_ ? index++ : cell_index[row * n_ + column];
+		}
+	}
+
+	std::vector<std::size_t> permuter( n_ );
+	for( std::size_t i( 0 ); i < n_; ++i ) {
+		permuter[i] = i;
+	}
+	std::vector<std::size_t> bit_image( bits );
+	while( std::next_permutation( permuter.begin() + 2, permuter.end() ) ) { // every non-identity relabeling of v3..vn
+		for( std::size_t row( 0 ); row < n_; ++row ) {
+			for( std::size_t column( d_ ? 0 : row + 1 ); column < n_; ++column ) {
+				if( row != column ) {
+					for( std::size_t bit( 0 ); bit < r_; ++bit ) {
+						bit_image[r_ * cell_index[row * n_ + column] + bit] = r_ * cell_index[permuter[row] * n_ + permuter[column]] + bit;
+					}
+				}
+			}
+		}
+		for( std::size_t chunk( 0 ); chunk < chunks; ++chunk ) {
+			for( std::size_t byte( 0 ); byte < (std::size_t( 1 ) << chunk_bits); ++byte ) {
+				std::size_t image( 0 );
+				for( std::size_t bit( 0 ); bit < chunk_bits && chunk * chunk_bits + bit < bits; ++bit ) {
+					if( byte & (std::size_t( 1 ) << bit) ) {
+						image |= std::size_t( 1 ) << bit_image[chunk * chunk_bits + bit];
+					}
+				}
+				permutation_tables.push_back( image );
+			}
+		}
+		++permutation_count;
+	}
+
+	// Orderly generation over complemented addresses. A class's smallest address is the complement of the largest
+	// address in the complemented class, and removing the lowest set bit of a largest address leaves a largest address,
+	// so every class is reached exactly once by adding bits below the lowest set bit of an already accepted address.
+	std::size_t const mask( (std::size_t( 1 ) << bits) - 1 );
+	std::vector<std::pair<std::size_t,std::size_t> > stack( 1, std::make_pair( std::size_t( 0 ), bits ) );
+	while( !stack.empty() ) {
+		std::size_t complement( stack.back().first );
+		std::size_t lowest_bit( stack.back().second );
+		stack.pop_back();
+		representatives.push_back( mask ^ complement );
+		for( std::size_t bit( 0 ); bit < lowest_bit; ++bit ) {
+			std::size_t child( complement | (std::size_t( 1 ) << bit) );
+			if( is_maximal( child ) ) {
+				stack.push_back( std::make_pair( child, bit ) );
+			}
+		}
+	}
+	std::sort( representatives.begin(), representatives.end() );
+}
+
+std::size_t vcp_canonical_mapper::n() const {
+	return n_;
+}
+
+std::size_t vcp_canonical_mapper::r() const {
+	return r_;
+}
+
+bool vcp_canonical_mapper::d() const {
+	return d_;
+}
+
+std::size_t vcp_canonical_mapper::element_count() const {
+	return representatives.size();
+}
+
+std::size_t vcp_canonical_mapper::permute( std::size_t permutation, std::size_t address ) const {
+	std::size_t const * table( &permutation_tables[permutation * chunks << chunk_bits] );
+	std::size_t image( 0 );
+	for( std::size_t chunk( 0 ); chunk < chunks; ++chunk, table += std::size_t( 1 ) << chunk_bits ) {
+		image |= table[(address >> (chunk * chunk_bits)) & ((std::size_t( 1 ) << chunk_bits) - 1)];
+	}
+	return image;
+}
+
+bool vcp_canonical_mapper::is_maximal( std::size_t address ) const {
+	for( std::size_t permutation( 0 ); permutation < permutation_count; ++permutation ) {
+		if( permute( permutation, address ) > address ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::size_t vcp_canonical_mapper::canonical_address( std::size_t subgraph_address ) const {
+	std::size_t canonical( subgraph_address );
+	for( std::size_t permutation( 0 ); permutation < permutation_count; ++permutation ) {
+		canonical = std::min( canonical, permute( permutation, subgraph_address ) );
+	}
+	return canonical;
+}
+
+std::size_t vcp_canonical_mapper::element_address( std::size_t subgraph_address ) const {
+	return std::lower_bound( representatives.begin(), representatives.end(), canonical_address( subgraph_address ) ) - representatives.begin();
+}
+
+std::size_t vcp_canonical_mapper::subgraph_address( std::size_t element_address ) const {
+	return representatives[element_address];
+}
+
+}
+
+#endif
@@ -21,6 +21,8 @@ You should have received a copy of the GNU General Public License along with the
 #include <iostream>
 #include <boost/multiprecision/cpp_int.hpp>
 #include <vcp/multirelational_graph.hpp>
+#include <vcp/pair_cost.hpp>
+#include <vcp/perf_counters.hpp>
 #include <vcp/square_matrix.hpp>
 
 namespace vcp {
@@ -72,8 +74,11 @@ class vcp_dynamic_mapper {
 		subgraph_address_type subgraph_address( square_matrix<connectivity_address_type,n> const & connectivity ) const;
 		subgraph_address_type canonical_subgraph_address( square_matrix<connectivity_address_type,n> const & connectivity ) const;
 		square_matrix<connectivity_address_type,n> element_structure( subgraph_address_type const & address ) const;
+		subgraph_address_type exchange_endpoints( subgraph_address_type const & address ) const;
 	private:
 		square_matrix<std::size_t,n> value_matrix;
+		static connectivity_address_type cell( std::size_t address, std::size_t shift );
+		template <typename backend_type> static connectivity_address_type cell( boost::multiprecision::number<backend_type> const & address, std::size_t shift );
 		subgraph_address_type canonical_subgraph_address( square_matrix<connectivity_address_type,n> const & connectivity, subgraph_address_type subgraph_address ) const;
 };
 
@@ -115,6 +120,8 @@ typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type vcp_dynamic_mapper<n,r
 
 template <std::size_t n,std::size_t r,bool d>
 typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type vcp_dynamic_mapper<n,r,d>::canonical_subgraph_address( square_matrix<connectivity_address_type,n> const & connectivity, subgraph_address_type subgraph_address ) const {
+	VCP_PAIR_COST( canonicalizations, 1 );
+	perf_phase_scope phase( perf_phase::canonicalization );
 	std::array<std::size_t,n> permuter;
 	for( std::size_t row( 0 ); row < n; ++row ) {
 		permuter[row] = row;
@@ -134,32 +141,51 @@ typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type vcp_dynamic_mapper<n,r
 }
 
 template <std::size_t n,std::size_t r,bool d>
-square_matrix<typename vcp_dynamic_mapper<n,r,d>::connectivity_address_type,n> vcp_dynamic_mapper<n,r,d>::element_structure( subgraph_address_type const & address ) const {
-	subgraph_address_type r_pset( vcp_dynamic_mapper::subgraph_address_type(1) << r );
-	square_matrix<connectivity_address_type,n> matrix;
-	std::size_t row( 0 );
-	std::size_t column( 1 );
-	while( address > 0 ) {
-		matrix( row, column ) = address & (r_pset - 1);
-		address >>= r_pset;
-		if( d ) {
-			std::swap( row, column );
-			if( row < column ) {
-				++column;
-				if( column >= n ) {
-					++row;
-					column = row + 1;
-				}
+square_matrix<typename vcp_dynamic_mapper<n,r,d>::connectivity_address_type,n> vcp_dynamic_mapper<n,r,d>::element_structure( subgraph_address_type const & address ) const { // the inverse of subgraph_address; undirected cells are filled above the diagonal only
+	square_matrix<connectivity_address_type,n> connectivity;
+	for( std::size_t row( 0 ); row < n; ++row ) {
+		for( std::size_t column( d ? 0 : row + 1 ); column < n; ++column ) {
+			if( row != column ) {
+				connectivity( row, column ) = cell( address, value_matrix( row, column ) );
 			}
-		} else {
-			++column;
-			if( column >= n ) {
-				++row;
-				column = row + 1;
+		}
+	}
+	return connectivity;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type vcp_dynamic_mapper<n,r,d>::exchange_endpoints( subgraph_address_type const & address ) const { // the element that the same subgraph is counted under when the pair is profiled as (v2, v1)
+	square_matrix<connectivity_address_type,n> structure( element_structure( address ) );
+	square_matrix<connectivity_address_type,n> exchanged;
+	std::array<std::size_t,n> relabel;
+	for( std::size_t row( 0 ); row < n; ++row ) {
+		relabel[row] = row;
+	}
+	std::swap( relabel[0], relabel[1] );
+	for( std::size_t row( 0 ); row < n; ++row ) {
+		for( std::size_t column( d ? 0 : row + 1 ); column < n; ++column ) {
+			if( row != column ) {
+				std::size_t source_row( relabel[row] );
+				std::size_t source_column( relabel[column] );
+				if( !d && source_row > source_column ) {
+					std::swap( source_row, source_column );
+				}
+				exchanged( row, column ) = structure( source_row, source_column );
 			}
 		}
 	}
-	return matrix;
+	return canonical_subgraph_address( exchanged );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+typename vcp_dynamic_mapper<n,r,d>::connectivity_address_type vcp_dynamic_mapper<n,r,d>::cell( std::size_t address, std::size_t shift ) {
+	return (address >> shift) & ((std::size_t( 1 ) << r) - 1);
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename backend_type>
+typename vcp_dynamic_mapper<n,r,d>::connectivity_address_type vcp_dynamic_mapper<n,r,d>::cell( boost::multiprecision::number<backend_type> const & address, std::size_t shift ) {
+	return static_cast<boost::multiprecision::number<backend_type> >( (address >> shift) & ((boost::multiprecision::number<backend_type>( 1 ) << r) - 1) ).template convert_to<connectivity_address_type>();
 }
 
 }
@@ -0,0 +1,302 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_VCP_MAINTAINER
+#define VCP_VCP_MAINTAINER
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <vcp/graph.hpp>
+#include <vcp/mutable_graph.hpp>
+#include <vcp/square_matrix.hpp>
+#include <vcp/vcp.hpp>
+#include <vcp/vcp_canonical_mapper.hpp>
+#include <vcp/vcp_dynamic_mapper.hpp>
+
+namespace vcp {
+
+// keeps stored profiles current as edges change: an update alters only the subgraphs containing both of its endpoints, so only those are classified again, and the subgraphs whose remaining vertex is adjacent to none of the others are moved in bulk
+template <std::size_t n,std::size_t r,bool d>
+class vcp_maintainer {
+	static_assert( n == 3 || n == 4, "profiles are maintained for the n of the specialized VCP classes" );
+	public:
+		typedef typename vcp_reference<n,r,d>::graph_type graph_type;
+		typedef typename multirelational_graph<r>::connectivity_address_type connectivity_address_type;
+		typedef typename vcp_dynamic_mapper<n,r,d>::subgraph_address_type subgraph_address_type;
+		typedef std::pair<connectivity_address_type,connectivity_address_type> pair_type; // the values of the arcs between two vertices, smaller first, or (0, value) for d=0
+		explicit vcp_maintainer( graph_type const & g );
+		explicit vcp_maintainer( mutable_graph<r,d> & graph ); // updates are applied to the graph, which must receive them only through the maintainer
+		connectivity_address_type value( vertex_id_t source, vertex_id_t target ) const;
+		template <typename iterator_type> void adjust( vertex_id_t v1, vertex_id_t v2, edge_update const & update, iterator_type counts ) const; // r=1 vectors of element counts
+		void adjust( vertex_id_t v1, vertex_id_t v2, edge_update const & update, std::map<subgraph_address_type,unsigned long> & counts ) const; // vectors keyed by canonical subgraph address
+		void apply( edge_update const & update );
+		std::map<pair_type,unsigned long> const & pair_types() const; // every pair of vertices by type, unconnected pairs under (0, 0)
+		void write( std::ostream & os ) const;
+	private:
+		typedef square_matrix<connectivity_address_type,n> structure_type;
+		typedef typename mutable_graph<r,d>::view view_type;
+		std::unique_ptr<mutable_graph<r,d> > owned;
+		mutable_graph<r,d> & graph;
+		vcp_dynamic_mapper<n,r,d> mapper;
+		vcp_canonical_mapper classes;
+		std::map<pair_type,unsigned long> types;
+		void count_types();
+		void neighbors( view_type const & state, vertex_id_t v, std::vector<vertex_id_t> & ids, std::false_type ) const;
+		void neighbors( view_type const & state, vertex_id_t v, std::vector<vertex_id_t> & ids, std::true_type ) const;
+		static pair_type pair_of( connectivity_address_type forward, connectivity_address_type backward );
+		void validate( view_type const & state, vertex_id_t v1, vertex_id_t v2, edge_update const & update ) const;
+		structure_type structure( view_type const & state, std::array<vertex_id_t,n> const & vertices, std::size_t present ) const;
+		template <typename visitor_type> void reclassify( view_type const & state, vertex_id_t v1, vertex_id_t v2, edge_update const & update, visitor_type visit ) const;
+};
+
+template <std::size_t n,std::size_t r,bool d>
+vcp_maintainer<n,r,d>::vcp_maintainer( graph_type const & g ) : owned( new mutable_graph<r,d>( std::shared_ptr<graph_type const>( std::shared_ptr<graph_type const>(), &g ) ) ), graph( *owned ), classes( n, 1, d ) { // the graph is not owned
+	count_types();
+}
+
+template <std::size_t n,std::size_t r,bool d>
+vcp_maintainer<n,r,d>::vcp_maintainer( mutable_graph<r,d> & graph ) : graph( graph ), classes( n, 1, d ) {
+	count_types();
+}
+
+template <std::size_t n,std::size_t r,bool d>
+typename vcp_maintainer<n,r,d>::connectivity_address_type vcp_maintainer<n,r,d>::value( vertex_id_t source, vertex_id_t target ) const {
+	return graph.current().value( source, target );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename iterator_type>
+void vcp_maintainer<n,r,d>::adjust( vertex_id_t v1, vertex_id_t v2, edge_update const & update, iterator_type counts ) const {
+	static_assert( r == 1, "dense vectors hold the elements of r=1 VCPs" );
+	view_type const state( graph.current() );
+	validate( state, v1, v2, update );
+	connectivity_address_type const before( state.value( update.source, update.target ) );
+	connectivity_address_type const after( updated_value( before, update ) );
+	if( before == after ) {
+		return;
+	}
+	if( (update.source == v1 && update.target == v2) || (update.source == v2 && update.target == v1) ) { // every subgraph changes, each into the class differing only in the edge between v1 and v2
+		std::vector<unsigned long> moved( classes.element_count(), 0 );
+		for( std::size_t element( 0 ); element < moved.size(); ++element ) {
+			structure_type connectivity( mapper.element_structure( classes.subgraph_address( element ) ) );
+			connectivity( d && update.source == v2 ? 1 : 0, d && update.source == v2 ? 0 : 1 ) = after;
+			moved[ classes.element_address( mapper.subgraph_address( connectivity ) ) ] += counts[ element ];
+		}
+		std::copy( moved.begin(), moved.end(), counts );
+		return;
+	}
+	auto move = [&]( structure_type const & connectivity, structure_type const & changed_connectivity, unsigned long count ) {
+		std::size_t const source( classes.element_address( mapper.subgraph_address( connectivity ) ) );
+		if( counts[ source ] < count ) {
+			throw std::invalid_argument( "the profile of pair " + std::to_string( v1 ) + " " + std::to_string( v2 ) + " does not match the graph" );
+		}
+		counts[ source ] -= count;
+		counts[ classes.element_address( mapper.subgraph_address( changed_connectivity ) ) ] += count;
+	};
+	reclassify( state, v1, v2, update, move );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void vcp_maintainer<n,r,d>::adjust( vertex_id_t v1, vertex_id_t v2, edge_update const & update, std::map<subgraph_address_type,unsigned long> & counts ) const {
+	view_type const state( graph.current() );
+	validate( state, v1, v2, update );
+	connectivity_address_type const before( state.value( update.source, update.target ) );
+	connectivity_address_type const after( updated_value( before, update ) );
+	if( before == after ) {
+		return;
+	}
+	if( (update.source == v1 && update.target == v2) || (update.source == v2 && update.target == v1) ) {
+		std::map<subgraph_address_type,unsigned long> moved;
+		for( typename std::map<subgraph_address_type,unsigned long>::const_iterator it( counts.begin() ); it != counts.end(); ++it ) {
+			structure_type connectivity( mapper.element_structure( it->first ) );
+			connectivity( d && update.source == v2 ? 1 : 0, d && update.source == v2 ? 0 : 1 ) = after;
+			moved[ mapper.canonical_subgraph_address( connectivity ) ] += it->second;
+		}
+		counts.swap( moved );
+		return;
+	}
+	auto move = [&]( structure_type const & connectivity, structure_type const & changed_connectivity, unsigned long count ) {
+		typename std::map<subgraph_address_type,unsigned long>::iterator source( counts.find( mapper.canonical_subgraph_address( connectivity ) ) );
+		if( source == counts.end() || source->second < count ) {
+			throw std::invalid_argument( "the profile of pair " + std::to_string( v1 ) + " " + std::to_string( v2 ) + " does not match the graph" );
+		}
+		if( (source->second -= count) == 0 ) {
+			counts.erase( source );
+		}
+		counts[ mapper.canonical_subgraph_address( changed_connectivity ) ] += count;
+	};
+	reclassify( state, v1, v2, update, move );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void vcp_maintainer<n,r,d>::apply( edge_update const & update ) {
+	view_type const state( graph.current() );
+	validate( state, update.source, update.target, update );
+	connectivity_address_type const forward( state.value( update.source, update.target ) );
+	connectivity_address_type const backward( state.value( update.target, update.source ) );
+	connectivity_address_type const after( updated_value( forward, update ) );
+	if( forward == after ) {
+		return;
+	}
+	typename std::map<pair_type,unsigned long>::iterator type( types.find( pair_of( forward, backward ) ) );
+	if( --type->second == 0 ) {
+		types.erase( type );
+	}
+	++types[ pair_of( after, d ? backward : after ) ];
+	graph.apply( update );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::map<typename vcp_maintainer<n,r,d>::pair_type,unsigned long> const & vcp_maintainer<n,r,d>::pair_types() const {
+	return types;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void vcp_maintainer<n,r,d>::write( std::ostream & os ) const { // the current graph in the adjacency format read by the graph classes
+	graph.current().write( os );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void vcp_maintainer<n,r,d>::count_types() {
+	view_type const state( graph.current() );
+	unsigned long connected( 0 );
+	for( vertex_id_t v( 0 ); v < state.vertex_count(); ++v ) {
+		for( typename mutable_graph<r,d>::arc_iterator it( state.out_arcs_begin( v ) ); it != state.out_arcs_end( v ); ++it ) {
+			connectivity_address_type const backward( d ? state.value( it->first, v ) : it->second );
+			if( (d && backward == 0) || v < it->first ) { // each pair once
+				++types[ pair_of( it->second, backward ) ];
+				++connected;
+			}
+		}
+	}
+	types[ pair_type( 0, 0 ) ] += state.vertex_count() * (state.vertex_count() - 1) / 2 - connected;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void vcp_maintainer<n,r,d>::neighbors( view_type const & state, vertex_id_t v, std::vector<vertex_id_t> & ids, std::false_type ) const {
+	for( typename mutable_graph<r,d>::arc_iterator it( state.out_arcs_begin( v ) ); it != state.out_arcs_end( v ); ++it ) {
+		ids.push_back( it->first );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void vcp_maintainer<n,r,d>::neighbors( view_type const & state, vertex_id_t v, std::vector<vertex_id_t> & ids, std::true_type ) const {
+	neighbors( state, v, ids, std::false_type() );
+	for( typename mutable_graph<r,d>::arc_iterator it( state.in_arcs_begin( v ) ); it != state.in_arcs_end( v ); ++it ) {
+		ids.push_back( it->first );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+typename vcp_maintainer<n,r,d>::pair_type vcp_maintainer<n,r,d>::pair_of( connectivity_address_type forward, connectivity_address_type backward ) {
+	if( !d ) {
+		return pair_type( 0, forward );
+	}
+	return forward < backward ? pair_type( forward, backward ) : pair_type( backward, forward );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void vcp_maintainer<n,r,d>::validate( view_type const & state, vertex_id_t v1, vertex_id_t v2, edge_update const & update ) const {
+	std::array<vertex_id_t,4> const vertices {{ v1, v2, update.source, update.target }};
+	for( std::size_t i( 0 ); i < vertices.size(); ++i ) {
+		if( vertices[ i ] >= state.vertex_count() ) {
+			throw std::out_of_range( "vertex id " + std::to_string( vertices[ i ] ) + " is not in the graph" );
+		}
+	}
+	if( v1 == v2 || update.source == update.target ) {
+		throw std::invalid_argument( "pairs and updated edges must join two distinct vertices" );
+	}
+	if( update.relation >= r ) {
+		throw std::invalid_argument( "relation " + std::to_string( update.relation ) + " is not among the " + std::to_string( r ) + " relations of the VCP" );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+typename vcp_maintainer<n,r,d>::structure_type vcp_maintainer<n,r,d>::structure( view_type const & state, std::array<vertex_id_t,n> const & vertices, std::size_t present ) const { // vertices past the first present ones are adjacent to none of the others
+	structure_type connectivity;
+	for( std::size_t row( 0 ); row < present; ++row ) {
+		for( std::size_t column( d ? 0 : row + 1 ); column < present; ++column ) {
+			if( row != column ) {
+				connectivity( row, column ) = state.value( vertices[ row ], vertices[ column ] );
+			}
+		}
+	}
+	return connectivity;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename visitor_type>
+void vcp_maintainer<n,r,d>::reclassify( view_type const & state, vertex_id_t v1, vertex_id_t v2, edge_update const & update, visitor_type visit ) const { // visits the subgraphs containing both endpoints of the update, unless those are v1 and v2, before and after it
+	std::array<vertex_id_t,n> vertices;
+	vertices[ 0 ] = v1;
+	vertices[ 1 ] = v2;
+	std::size_t source( v1 == update.source ? 0 : v2 == update.source ? 1 : n );
+	std::size_t target( v1 == update.target ? 0 : v2 == update.target ? 1 : n );
+	std::size_t present( 0 );
+	std::vector<vertex_id_t> others; // vertices that complete a subgraph individually
+	if( source == n && target == n ) {
+		if( n == 3 ) {
+			return;
+		}
+		vertices[ 2 ] = update.source;
+		vertices[ n - 1 ] = update.target;
+		source = 2;
+		target = n - 1;
+		present = n;
+	} else {
+		vertices[ 2 ] = source == n ? update.source : update.target;
+		(source == n ? source : target) = 2;
+		present = 3;
+		if( n == 4 ) { // the fourth vertex is any other; those adjacent to none of the three share one class
+			for( std::size_t i( 0 ); i < 3; ++i ) {
+				neighbors( state, vertices[ i ], others, std::integral_constant<bool,d>() );
+			}
+			std::sort( others.begin(), others.end() );
+			others.erase( std::unique( others.begin(), others.end() ), others.end() );
+			others.erase( std::remove_if( others.begin(), others.end(), [&vertices]( vertex_id_t v ) { return v == vertices[ 0 ] || v == vertices[ 1 ] || v == vertices[ 2 ]; } ), others.end() );
+		}
+	}
+	std::size_t const row( d || source < target ? source : target );
+	std::size_t const column( d || source < target ? target : source );
+	auto reclassify_one = [&]( std::size_t known, unsigned long count ) {
+		structure_type connectivity( structure( state, vertices, known ) );
+		structure_type changed_connectivity( connectivity );
+		changed_connectivity( row, column ) = updated_value( connectivity( row, column ), update );
+		visit( connectivity, changed_connectivity, count );
+	};
+	if( present == n || n == 3 ) {
+		reclassify_one( n, 1 );
+		return;
+	}
+	for( std::vector<vertex_id_t>::const_iterator it( others.begin() ); it != others.end(); ++it ) {
+		vertices[ n - 1 ] = *it;
+		reclassify_one( n, 1 );
+	}
+	unsigned long const isolated( state.vertex_count() - 3 - others.size() );
+	if( isolated != 0 ) {
+		reclassify_one( 3, isolated );
+	}
+}
+
+}
+
+#endif
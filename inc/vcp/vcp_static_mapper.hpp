@@ -15,18 +15,36 @@ You should have received a copy of the GNU General Public License along with the
 #define VCP_VCP_STATIC_MAPPER
 
 #include <algorithm>
+#include <cerrno>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
 #include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vcp/square_matrix.hpp>
+#include <vcp/vcp_canonical_mapper.hpp>
 
 namespace vcp {
 
 class vcp_static_mapper {
 	public:
 		static std::size_t subgraph_count( std::size_t n, std::size_t r, bool d );
-		vcp_static_mapper( std::size_t n, std::size_t r, bool d );
+		static std::string cache_filename( std::size_t n, std::size_t r, bool d );
+		vcp_static_mapper( std::size_t n, std::size_t r, bool d, std::size_t threads = 1, std::string const & cache_path = "" );
+		vcp_static_mapper( vcp_static_mapper const & ) = delete;
+		vcp_static_mapper & operator=( vcp_static_mapper const & ) = delete;
+		~vcp_static_mapper();
 		std::size_t n() const;
 		std::size_t r() const;
 		bool d() const;
@@ -38,18 +56,39 @@ class vcp_static_mapper {
 		square_matrix<std::size_t> element_structure( std::size_t element_address ) const;
 		friend std::ostream & operator<<( std::ostream & os, vcp_static_mapper const & mapper );
 	private:
+		struct cache_header {
+			char magic[8];
+			std::uint32_t byte_order;
+			std::uint32_t n;
+			std::uint32_t r;
+			std::uint32_t d;
+			std::uint64_t subgraph_count;
+			unsigned char padding[32];
+		};
 		std::size_t n_;
 		std::size_t r_;
 		bool d_;
-		std::vector<std::size_t> map;
+		std::size_t count;
+		std::vector<std::uint32_t> table;
+		std::uint32_t const * map;
+		void * mapping;
+		std::size_t mapping_size;
 		square_matrix<std::size_t> value_matrix;
+		void build( std::size_t threads );
+		cache_header header() const;
+		bool load( std::string const & cache_path );
+		void save( std::string const & cache_path ) const;
 };
 
 std::size_t vcp_static_mapper::subgraph_count( std::size_t n, std::size_t r, bool d ) {
 	return std::pow( 2, n*(n-1)*r*(d+1)/2 );
 }
 
-vcp_static_mapper::vcp_static_mapper( std::size_t n, std::size_t r, bool d ) : n_(n), r_(r), d_(d), map( vcp_static_mapper::subgraph_count(n,r,d) ), value_matrix( n_ )  {
+std::string vcp_static_mapper::cache_filename( std::size_t n, std::size_t r, bool d ) {
+	return "vcp_map_" + std::to_string( n ) + "_" + std::to_string( r ) + "_" + std::to_string( d ) + ".bin";
+}
+
+vcp_static_mapper::vcp_static_mapper( std::size_t n, std::size_t r, bool d, std::size_t threads, std::string const & cache_path ) : n_(n), r_(r), d_(d), count( vcp_static_mapper::subgraph_count(n,r,d) ), map( nullptr ), mapping( nullptr ), mapping_size( 0 ), value_matrix( n_ )  {
 	std::size_t r_pset( std::pow( 2, r_ ) );
 	std::size_t index( 0 );
 	for( std::size_t row( 0 ); row < n_; ++row ) {
@@ -59,70 +98,120 @@ vcp_static_mapper::vcp_static_mapper( std::size_t n, std::size_t r, bool d ) : n
 			value_matrix( column, row ) = d_ ? std::pow( r_pset, index++ ) : value_matrix( row, column );
 		}
 	}
+	if( cache_path.empty() || !load( cache_path ) ) {
+		build( threads );
+		if( !cache_path.empty() ) {
+			save( cache_path );
+		}
+	}
+}
 
-	square_matrix<std::size_t> connectivity( n_ );
-	std::vector<std::size_t> permuter( n_ );	
-	
-	std::size_t element_address( 0 );
-	while( !connectivity( 0, 0 ) ) {
-		std::size_t subgraph_address( 0 );
-		for( std::size_t row( 0 ); row < n_; ++row ) {
-			for( std::size_t column( d_ ? 0 : row + 1 ); column < n_; ++column ) {
-				subgraph_address += connectivity( row, column ) * value_matrix( row, column );
-			}
+vcp_static_mapper::~vcp_static_mapper() {
+	if( mapping != nullptr ) {
+		munmap( mapping, mapping_size );
+	}
+}
+
+void vcp_static_mapper::build( std::size_t threads ) {
+	vcp_canonical_mapper canonical( n_, r_, d_ ); // elements are numbered in order of their smallest subgraph address, as a sequential sweep encounters them
+	if( canonical.element_count() > std::numeric_limits<std::uint32_t>::max() ) {
+		throw std::length_error( "element addresses for this VCP exceed 32 bits" );
+	}
+	table.resize( count );
+	threads = std::max<std::size_t>( 1, std::min( threads, count ) );
+	auto fill = [&]( std::size_t begin, std::size_t end ) {
+		for( std::size_t address( begin ); address < end; ++address ) {
+			table[address] = canonical.element_address( address );
 		}
-		if( map[ subgraph_address ] == 0 ) { // we have not encountered this subgraph or its isomorphic equivalents before
-			map[ subgraph_address ] = element_address;
-			for( std::size_t i( 0 ); i < n_; ++i ) { // reset the permuter vector
-				permuter[i] = i;
-			}
-			while( std::next_permutation( permuter.begin() + 2, permuter.end() ) ) { // find all isomorphisms
-				std::size_t isomorphism_address( 0 );
-				for( std::size_t row( 0 ); row < n_; ++row ) {
-					for( std::size_t column( 0 ); column < n_; ++column ) {
-						isomorphism_address += connectivity( row, column ) * value_matrix( permuter[row], permuter[column] );
-					}
-				}
-				map[ isomorphism_address ] = element_address;
+	};
+	std::vector<std::thread> workers;
+	for( std::size_t t( 1 ); t < threads; ++t ) {
+		workers.emplace_back( fill, count * t / threads, count * (t + 1) / threads );
+	}
+	fill( 0, count / threads );
+	for( std::vector<std::thread>::iterator it( workers.begin() ); it != workers.end(); ++it ) {
+		it->join();
+	}
+	map = table.data();
+}
+
+vcp_static_mapper::cache_header vcp_static_mapper::header() const {
+	cache_header h;
+	std::memset( &h, 0, sizeof( h ) );
+	std::memcpy( h.magic, "VCPMAP1", 8 );
+	h.byte_order = 0x01020304;
+	h.n = n_;
+	h.r = r_;
+	h.d = d_;
+	h.subgraph_count = count;
+	return h;
+}
+
+bool vcp_static_mapper::load( std::string const & cache_path ) { // a missing, stale, or foreign cache file is silently rebuilt
+	int fd( open( cache_path.c_str(), O_RDONLY ) );
+	if( fd == -1 ) {
+		return false;
+	}
+	struct stat status;
+	std::size_t expected_size( sizeof( cache_header ) + count * sizeof( std::uint32_t ) );
+	if( fstat( fd, &status ) == 0 && S_ISREG( status.st_mode ) && static_cast<std::size_t>( status.st_size ) == expected_size ) {
+		void * address( mmap( nullptr, expected_size, PROT_READ, MAP_SHARED, fd, 0 ) );
+		if( address != MAP_FAILED ) {
+			cache_header expected( header() );
+			if( std::memcmp( address, &expected, sizeof( cache_header ) ) == 0 ) {
+				mapping = address;
+				mapping_size = expected_size;
+				map = reinterpret_cast<std::uint32_t const *>( static_cast<unsigned char const *>( address ) + sizeof( cache_header ) );
+			} else {
+				munmap( address, expected_size );
 			}
-			++element_address;
 		}
-		
-		// move to the next subgraph
-		std::size_t row( 0 );
-		std::size_t column( 1 );
-		std::size_t * cell( &connectivity( row, column ) );
-		++(*cell);
-		while( *cell == r_pset ) {
-			*cell = 0;
-			if( d_ ) {
-				std::swap( row, column );
-				if( row < column ) {
-					++column;
-					if( column >= n_ ) {
-						++row;
-						column = row + 1;
-						if( row == n_ - 1 ) {
-							row = 0;
-							column = 0;
-						}
-					}
-				}
-			} else {
-				++column;
-				if( column >= n_ ) {
-					++row;
-					column = row + 1;
-					if( row == n_ - 1 ) {
-						row = 0;
-						column = 0;
-					}
+	}
+	close( fd );
+	return map != nullptr;
+}
+
+void vcp_static_mapper::save( std::string const & cache_path ) const { // written under a temporary name and renamed so that concurrent readers never map a partial file
+	std::string temporary_path( cache_path + "." + std::to_string( getpid() ) + ".tmp" );
+	int fd( open( temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 ) );
+	if( fd == -1 ) {
+		throw std::system_error( errno, std::system_category(), "open " + temporary_path );
+	}
+	cache_header h( header() );
+	std::size_t const sizes[] = { sizeof( cache_header ), count * sizeof( std::uint32_t ) };
+	char const * const sources[] = { reinterpret_cast<char const *>( &h ), reinterpret_cast<char const *>( map ) };
+	for( std::size_t part( 0 ); part < 2; ++part ) {
+		for( std::size_t written( 0 ); written < sizes[part]; ) {
+			ssize_t result( write( fd, sources[part] + written, sizes[part] - written ) );
+			if( result == -1 ) {
+				if( errno == EINTR ) {
+					continue;
 				}
+				int error( errno );
+				close( fd );
+				unlink( temporary_path.c_str() );
+				throw std::system_error( error, std::system_category(), "write " + temporary_path );
 			}
-			cell = &connectivity( row, column );
-			++(*cell);
+			written += result;
 		}
 	}
+	if( close( fd ) == -1 || rename( temporary_path.c_str(), cache_path.c_str() ) == -1 ) {
+		int error( errno );
+		unlink( temporary_path.c_str() );
+		throw std::system_error( error, std::system_category(), "rename " + cache_path );
+	}
+}
+
+std::size_t vcp_static_mapper::n() const {
+	return n_;
+}
+
+std::size_t vcp_static_mapper::r() const {
+	return r_;
+}
+
+bool vcp_static_mapper::d() const {
+	return d_;
 }
 
 template <std::size_t nn>
@@ -155,6 +244,10 @@ std::size_t vcp_static_mapper::element_address( square_matrix<std::size_t> const
 	return map[ subgraph_address( connectivity ) ];
 }
 
+std::size_t vcp_static_mapper::element_address( std::size_t address ) const {
+	return map[ address ];
+}
+
 square_matrix<std::size_t> vcp_static_mapper::element_structure( std::size_t address ) const {
 	std::size_t r_pset( std::pow( 2, r_ ) );
 	square_matrix<std::size_t> matrix( n_ );
@@ -184,7 +277,7 @@ square_matrix<std::size_t> vcp_static_mapper::element_structure( std::size_t add
 }
 
 std::ostream & operator<<( std::ostream & os, vcp_static_mapper const & mapper ) {
-	std::copy( mapper.map.begin(), mapper.map.end(), std::ostream_iterator<std::size_t>( os, "\n" ) );
+	std::copy( mapper.map, mapper.map + mapper.count, std::ostream_iterator<std::uint32_t>( os, "\n" ) );
 	return os;
 }
 
@@ -0,0 +1,215 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCP_VECTOR_WRITER
+#define VCP_VECTOR_WRITER
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <vcp/buffered_writer.hpp>
+
+namespace vcp {
+
+enum class vector_format {
+	text,     // space-separated counts, or space-separated address,count pairs for sparse vectors
+	binary,   // rows of little-endian uint64 counts with no header
+	npy,      // the binary layout preceded by a NumPy .npy header; the row count is patched in on finish()
+	triplet   // little-endian records of uint64 pair index, address, and uint64 count for each nonzero count
+};
+
+vector_format parse_vector_format( std::string const & name );
+
+class vector_writer {
+	public:
+		vector_writer( buffered_writer & out, vector_format format, std::size_t element_count, std::size_t address_bits );
+		void begin();
+		template <typename iterator_type> void write_row( iterator_type begin, iterator_type end );
+		template <typename address_type> void write_entry( address_type const & address, unsigned long count );
+		void end_row();
+		bool fixed_width() const;
+		std::uint64_t row_index() const;
+		void set_row_index( std::uint64_t row );
+		void finish();
+	private:
+		buffered_writer & out;
+		vector_format format;
+		std::size_t columns;
+		std::size_t address_bytes;
+		std::uint64_t rows;
+		std::size_t row_entries;
+		off_t header_offset;
+		std::string npy_header( std::uint64_t rows ) const;
+		template <typename value_type> typename std::enable_if<std::is_integral<value_type>::value>::type write_address( value_type value );
+		template <typename backend_type> void write_address( boost::multiprecision::number<backend_type> const & value );
+};
+
+vector_format parse_vector_format( std::string const & name ) {
+	if( name == "text" ) {
+		return vector_format::text;
+	} else if( name == "binary" ) {
+		return vector_format::binary;
+	} else if( name == "npy" ) {
+		return vector_format::npy;
+	} else if( name == "triplet" ) {
+		return vector_format::triplet;
+	}
+	throw std::invalid_argument( "unknown vector format: " + name );
+}
+
+vector_writer::vector_writer( buffered_writer & out, vector_format format, std::size_t element_count, std::size_t address_bits ) : out( out ), format( format ), columns( element_count ), address_bytes( (address_bits + 63) / 64 * 8 ), rows( 0 ), row_entries( 0 ), header_offset( 0 ) {
+	if( (format == vector_format::binary || format == vector_format::npy) && columns == 0 ) {
+		throw std::invalid_argument( "binary and npy formats require fixed-width vectors; use the triplet format for sparse vectors" );
+	}
+}
+
+void vector_writer::begin() {
+	if( format == vector_format::npy ) {
+		if( out.size() != 0 ) { // an empty writer keeps O_DIRECT, which flushing would end
+			out.flush();
+		}
+		header_offset = lseek( out.descriptor(), 0, SEEK_CUR );
+		if( header_offset < 0 ) {
+			throw std::runtime_error( "npy output requires a seekable file; use the binary format for pipes" );
+		}
+		std::string header( npy_header( 0 ) );
+		out.write( header.data(), header.size() );
+	}
+}
+
+template <typename iterator_type>
+void vector_writer::write_row( iterator_type begin, iterator_type end ) {
+	switch( format ) {
+		case vector_format::text:
+			for( iterator_type it( begin ); it != end; ++it ) {
+				if( it != begin ) {
+					out.put( ' ' );
+				}
+				out.write_decimal( *it );
+			}
+			out.put( '\n' );
+			break;
+		case vector_format::binary:
+		case vector_format::npy:
+			for( iterator_type it( begin ); it != end; ++it ) {
+				out.write_le( static_cast<std::uint64_t>( *it ) );
+			}
+			break;
+		case vector_format::triplet:
+			for( iterator_type it( begin ); it != end; ++it ) {
+				if( *it != 0 ) {
+					out.write_le( rows );
+					write_address( static_cast<std::uint64_t>( it - begin ) );
+					out.write_le( static_cast<std::uint64_t>( *it ) );
+				}
+			}
+			break;
+	}
+	++rows;
+}
+
+template <typename address_type>
+void vector_writer::write_entry( address_type const & address, unsigned long count ) {
+	switch( format ) {
+		case vector_format::text:
+			if( row_entries != 0 ) {
+				out.put( ' ' );
+			}
+			out.write_decimal( address );
+			out.put( ',' );
+			out.write_decimal( count );
+			break;
+		case vector_format::binary:
+		case vector_format::npy:
+			break;
+		case vector_format::triplet:
+			if( count != 0 ) {
+				out.write_le( rows );
+				write_address( address );
+				out.write_le( static_cast<std::uint64_t>( count ) );
+			}
+			break;
+	}
+	++row_entries;
+}
+
+void vector_writer::end_row() {
+	if( format == vector_format::text && row_entries != 0 ) { // an empty sparse vector produces no line, as with the original map output
+		out.put( '\n' );
+	}
+	row_entries = 0;
+	++rows;
+}
+
+bool vector_writer::fixed_width() const {
+	return format == vector_format::binary || format == vector_format::npy;
+}
+
+std::uint64_t vector_writer::row_index() const {
+	return rows;
+}
+
+void vector_writer::set_row_index( std::uint64_t row ) { // for writers over per-thread chunks, whose first row is not the first row of the output
+	rows = row;
+}
+
+void vector_writer::finish() {
+	out.flush();
+	if( format == vector_format::npy ) {
+		std::string header( npy_header( rows ) );
+		if( pwrite( out.descriptor(), header.data(), header.size(), header_offset ) != static_cast<ssize_t>( header.size() ) ) {
+			throw std::system_error( errno, std::system_category(), "pwrite" );
+		}
+	}
+}
+
+std::string vector_writer::npy_header( std::uint64_t rows ) const {
+	// the header is padded to the width of the largest possible row count so that it can be rewritten in place
+	std::string dictionary( "{'descr': '<u8', 'fortran_order': False, 'shape': (" + std::to_string( rows ) + ", " + std::to_string( columns ) + "), }" );
+	std::size_t reserved( 10 + dictionary.size() + 20 - std::to_string( rows ).size() + 1 );
+	std::size_t length( (reserved + 63) / 64 * 64 );
+	std::string header( "\x93NUMPY\x01\x00", 8 );
+	header += static_cast<char>( (length - 10) & 0xff );
+	header += static_cast<char>( (length - 10) >> 8 );
+	header += dictionary;
+	header.append( length - header.size() - 1, ' ' );
+	header += '\n';
+	return header;
+}
+
+template <typename value_type>
+typename std::enable_if<std::is_integral<value_type>::value>::type vector_writer::write_address( value_type value ) {
+	out.write_le( static_cast<std::uint64_t>( value ) );
+	for( std::size_t i( 8 ); i < address_bytes; ++i ) {
+		out.put( 0 );
+	}
+}
+
+template <typename backend_type>
+void vector_writer::write_address( boost::multiprecision::number<backend_type> const & value ) {
+	boost::multiprecision::number<backend_type> const mask( std::numeric_limits<std::uint64_t>::max() );
+	for( std::size_t i( 0 ); i < address_bytes / 8; ++i ) {
+		out.write_le( static_cast<std::uint64_t>( ((value >> (64 * i)) & mask).template convert_to<unsigned long long>() ) );
+	}
+}
+
+}
+
+#endif
@@ -11,8 +11,11 @@ The Vertex Collocation Profiles code base is distributed in the hope that it wil
 You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <iostream>
+#include <system_error>
 #include <vector>
 #include <tclap/CmdLine.h>
+#include <vcp/buffered_writer.hpp>
 #include <vcp/directed_graph.hpp>
 
 int main( int argc, char* argv[] ) {
@@ -30,45 +33,51 @@ int main( int argc, char* argv[] ) {
 	vcp::directed_graph g;
 	std::cin >> g;
 	std::vector<vcp::const_vertex_iterator> neighbors;
-	for( vcp::const_vertex_iterator vIt( g.vertices_begin() ); vIt != g.vertices_end(); ++vIt ) {
-		vcp::const_edge_iterator outIt = g.out_neighbors_begin( vIt );
-		vcp::const_edge_iterator outEnd = g.out_neighbors_end( vIt );
-		vcp::const_edge_iterator inIt = g.in_neighbors_begin( vIt );
-		vcp::const_edge_iterator inEnd = g.in_neighbors_end( vIt );
-		while( outIt != outEnd && inIt != inEnd ) {
-			if( g.target_of( outIt ) < g.target_of( inIt ) ) {
-				if( !bidirectional ) {
+	try {
+		vcp::buffered_writer out( 1 );
+		for( vcp::const_vertex_iterator vIt( g.vertices_begin() ); vIt != g.vertices_end(); ++vIt ) {
+			vcp::const_edge_iterator outIt = g.out_neighbors_begin( vIt );
+			vcp::const_edge_iterator outEnd = g.out_neighbors_end( vIt );
+			vcp::const_edge_iterator inIt = g.in_neighbors_begin( vIt );
+			vcp::const_edge_iterator inEnd = g.in_neighbors_end( vIt );
+			while( outIt != outEnd && inIt != inEnd ) {
+				if( g.target_of( outIt ) < g.target_of( inIt ) ) {
+					if( !bidirectional ) {
+						neighbors.push_back( g.target_of( outIt ) );
+					}
+					++outIt;
+				} else if( g.target_of( outIt ) > g.target_of( inIt ) ) {
+					if( !bidirectional ) {
+						neighbors.push_back( g.target_of( inIt ) );
+					}
+					++inIt;
+				} else {
 					neighbors.push_back( g.target_of( outIt ) );
+					++outIt;
+					++inIt;
 				}
-				++outIt;
-			} else if( g.target_of( outIt ) > g.target_of( inIt ) ) {
-				if( !bidirectional ) {
-					neighbors.push_back( g.target_of( inIt ) );
-				}
-				++inIt;
-			} else {
-				neighbors.push_back( g.target_of( outIt ) );
-				++outIt;
-				++inIt;
 			}
-		}
-		if( !bidirectional ) {
-			while( outIt != outEnd ) {
-				neighbors.push_back( g.target_of( outIt ) );
+			if( !bidirectional ) {
+				while( outIt != outEnd ) {
+					neighbors.push_back( g.target_of( outIt++ ) );
+				}
+				while( inIt != inEnd ) {
+					neighbors.push_back( g.target_of( inIt++ ) );
+				}
 			}
-			while( inIt != inEnd ) {
-				neighbors.push_back( g.target_of( inIt ) );
+			for( std::vector<vcp::const_vertex_iterator>::const_iterator neighbors_it( neighbors.begin() ); neighbors_it != neighbors.end(); ++neighbors_it ) {
+				if( neighbors_it != neighbors.begin() ) {
+					out.put( ' ' );
+				}
+				out.write_decimal( g.vertex_id( *neighbors_it ) );
 			}
+			out.put( '\n' );
+			neighbors.clear();
 		}
-		std::vector<vcp::const_vertex_iterator>::const_iterator neighbors_it( neighbors.begin() );
-		while( neighbors_it < neighbors.end() - 1 ) {
-			std::cout << g.vertex_id( *neighbors_it++ ) << ' ';
-		}
-		if( neighbors_it < neighbors.end() ) {
-			std::cout << g.vertex_id( *neighbors_it );
-		}
-		std::cout << '\n';
-		neighbors.clear();
+		out.flush();
+	} catch( std::system_error const & e ) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
 	}
 
 	return 0;
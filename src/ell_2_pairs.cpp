@@ -11,14 +11,98 @@ The Vertex Collocation Profiles code base is distributed in the hope that it wil
 You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <set>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
 #include <tclap/CmdLine.h>
+#include <vcp/buffered_writer.hpp>
+#include <vcp/candidate_pairs.hpp>
 #include <vcp/graph.hpp>
+#include <vcp/pair_reader.hpp>
+#include <vcp/parallel_chunks.hpp>
+
+class pair_emitter {
+	public:
+		pair_emitter( vcp::graph const & g, vcp::pair_encoding encoding, bool sorted, std::size_t max_distance, std::size_t min_common, std::size_t max_degree, double sample_rate, std::uint64_t seed, std::size_t chunk_size );
+		void operator()( std::size_t chunk, vcp::buffered_writer & out );
+	private:
+		vcp::graph const & g;
+		vcp::pair_encoding encoding;
+		bool sorted;
+		std::size_t chunk_size;
+		vcp::candidate_pairs<vcp::graph> candidates;
+};
+
+pair_emitter::pair_emitter( vcp::graph const & g, vcp::pair_encoding encoding, bool sorted, std::size_t max_distance, std::size_t min_common, std::size_t max_degree, double sample_rate, std::uint64_t seed, std::size_t chunk_size ) : g( g ), encoding( encoding ), sorted( sorted ), chunk_size( chunk_size ), candidates( g, max_distance, min_common, max_degree, sample_rate, seed ) {
+}
+
+void pair_emitter::operator()( std::size_t chunk, vcp::buffered_writer & out ) {
+	auto emit = [&]( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, std::size_t ) {
+		switch( encoding ) {
+			case vcp::pair_encoding::text:
+				out.write_decimal( g.vertex_id( v1 ) );
+				out.put( ' ' );
+				out.write_decimal( g.vertex_id( v2 ) );
+				out.put( '\n' );
+				break;
+			case vcp::pair_encoding::u32:
+				out.write_le( static_cast<std::uint32_t>( g.vertex_id( v1 ) ) );
+				out.write_le( static_cast<std::uint32_t>( g.vertex_id( v2 ) ) );
+				break;
+			case vcp::pair_encoding::u64:
+				out.write_le( static_cast<std::uint64_t>( g.vertex_id( v1 ) ) );
+				out.write_le( static_cast<std::uint64_t>( g.vertex_id( v2 ) ) );
+				break;
+		}
+	};
+	vcp::const_vertex_iterator end( g.vertices_begin() + std::min( g.vertex_count(), (chunk + 1) * chunk_size ) );
+	for( vcp::const_vertex_iterator vIt( g.vertices_begin() + chunk * chunk_size ); vIt != end; ++vIt ) {
+		candidates.enumerate( vIt, sorted, emit );
+	}
+}
 
 int main( int argc, char* argv[] ) {
+	std::size_t threads;
+	bool unordered;
+	std::size_t max_distance;
+	vcp::pair_encoding encoding;
+	std::size_t min_common;
+	std::size_t max_degree;
+	double sample_rate;
+	std::uint64_t seed;
 	try {
 		TCLAP::CmdLine cmd( "Print, in lexicographical order, all pairs of nodes that are two hops distant from each other.", ' ', "1.0.0" );
+		TCLAP::ValueArg<std::size_t> threadsArg( "t", "threads", "Number of threads across which to divide source vertices (0 for one per hardware thread)", false, 1, "threads", cmd );
+		TCLAP::SwitchArg unorderedArg( "u", "unordered", "With multiple threads, write pairs in completion order rather than lexicographical order", cmd );
+		std::vector<std::string> allowedFormats {"text", "u32", "u64"};
+		TCLAP::ValuesConstraint<std::string> allowedFormatVals( allowedFormats );
+		TCLAP::ValueArg<std::string> formatArg( "f", "format", "Output format: text, or u32 or u64 for packed little-endian pairs as read by vcp_generate --pair-format", false, "text", &allowedFormatVals, cmd );
+		TCLAP::ValueArg<std::size_t> distanceArg( "k", "distance", "Print all non-adjacent pairs within this many hops rather than exactly two", false, 2, "hops", cmd );
+		TCLAP::ValueArg<std::size_t> minCommonArg( "c", "min-common", "Only print pairs sharing at least this many common neighbors", false, 0, "count", cmd );
+		TCLAP::ValueArg<std::size_t> maxDegreeArg( "", "max-degree", "Do not form paths through intermediate vertices with degree above this value", false, std::numeric_limits<std::size_t>::max(), "degree", cmd );
+		TCLAP::ValueArg<double> sampleArg( "s", "sample", "Print each pair with this probability, determined by hashing the pair so that the sample does not depend on thread count", false, 1.0, "rate", cmd );
+		TCLAP::ValueArg<std::uint64_t> seedArg( "", "seed", "Seed for --sample", false, 0, "seed", cmd );
 		cmd.parse( argc, argv );
+		threads = threadsArg.getValue();
+		if( threads == 0 ) {
+			threads = std::max( 1u, std::thread::hardware_concurrency() );
+		}
+		unordered = unorderedArg.isSet();
+		max_distance = distanceArg.getValue();
+		if( max_distance < 2 ) {
+			throw TCLAP::ArgException( "distance must be at least 2", distanceArg.longID() );
+		}
+		encoding = vcp::parse_pair_encoding( formatArg.getValue() );
+		min_common = minCommonArg.getValue();
+		max_degree = maxDegreeArg.getValue();
+		sample_rate = sampleArg.getValue();
+		seed = seedArg.getValue();
 	} catch( TCLAP::ArgException & e ) {
 		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
 		return 1;
@@ -26,18 +110,23 @@ int main( int argc, char* argv[] ) {
 	
 	vcp::graph g;
 	std::cin >> g;
-	for( vcp::const_vertex_iterator vIt( g.vertices_begin() ); vIt != g.vertices_end(); ++vIt ) {
-		std::set<vcp::const_vertex_iterator> neighbors;
-		for( vcp::const_edge_iterator e1It( g.neighbors_begin( vIt ) ); e1It != g.neighbors_end( vIt ); ++e1It ) {
-			for( vcp::const_edge_iterator e2It( g.neighbors_begin( g.target_of( e1It ) ) ); e2It != g.neighbors_end( g.target_of( e1It ) ); ++e2It ) {
-				if( vIt < g.target_of( e2It ) && !g.edge_exists( vIt, g.target_of( e2It ) ) ) {
-					neighbors.insert( g.target_of( e2It ) );
-				}
-			}
-		}
-		for( std::set<vcp::const_vertex_iterator>::const_iterator it( neighbors.begin() ); it != neighbors.end(); ++it ) {
-			std::cout << g.vertex_id( vIt ) << ' ' << g.vertex_id( *it ) << '\n';
-		}
+	if( encoding == vcp::pair_encoding::u32 && g.vertex_count() > std::numeric_limits<std::uint32_t>::max() ) {
+		std::cerr << "error: vertex ids do not fit the u32 format" << std::endl;
+		return 1;
+	}
+	std::size_t chunk_size( std::max<std::size_t>( 1, std::min<std::size_t>( 4096, g.vertex_count() / (64 * threads) ) ) );
+	std::size_t chunk_count( (g.vertex_count() + chunk_size - 1) / chunk_size );
+	std::vector<pair_emitter> emitters;
+	for( std::size_t i( 0 ); i < threads; ++i ) {
+		emitters.push_back( pair_emitter( g, encoding, !unordered, max_distance, min_common, max_degree, sample_rate, seed, chunk_size ) );
+	}
+	try {
+		vcp::buffered_writer out( 1 );
+		vcp::run_chunks( emitters, chunk_count, out, !unordered );
+		out.flush();
+	} catch( std::exception const & e ) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
 	}
 
 	return 0;
@@ -0,0 +1,264 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <sys/resource.h>
+#include <tclap/CmdLine.h>
+#include <vcp/candidate_pairs.hpp>
+#include <vcp/directed_graph.hpp>
+#include <vcp/graph.hpp>
+#include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/multirelational_graph.hpp>
+#include <vcp/perf_counters.hpp>
+#include <vcp/relation_storage.hpp>
+#include <vcp/synthetic_graph.hpp>
+#include <vcp/vcp.hpp>
+
+struct bench_options {
+	double reciprocity;
+	std::size_t combinations;
+	std::uint64_t seed;
+	bool perf_counters;
+};
+
+// counts the vector entries so that profiling cannot be optimized away and runs can be compared
+template <std::size_t n,std::size_t r,bool d,typename profiler_type>
+std::uint64_t profile_pair( profiler_type & profiler, vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, std::true_type ) {
+	std::array<unsigned long,profiler_type::element_count()> counts;
+	profiler.generate_vector( v1, v2, counts.begin() );
+	vcp::perf_counters::enter( vcp::perf_phase::output );
+	std::uint64_t total( 0 );
+	for( std::size_t i( 0 ); i < counts.size(); ++i ) {
+		total += counts[ i ];
+	}
+	return total;
+}
+
+template <std::size_t n,std::size_t r,bool d,typename profiler_type>
+std::uint64_t profile_pair( profiler_type & profiler, vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, std::false_type ) {
+	std::uint64_t total( 0 );
+	auto sink = [&total]( typename profiler_type::subgraph_address_type const &, unsigned long count ) {
+		total += count;
+	};
+	profiler.generate_vector( v1, v2, sink );
+	return total;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void bench( vcp::synthetic_graph skeleton, std::vector<vcp::vertex_id_t> const & pairs, bench_options const & options, bool first ) {
+	typedef typename std::conditional< d,
+			typename std::conditional< (r>1), vcp::multirelational_directed_graph<r>, vcp::directed_graph >::type,
+			typename std::conditional< (r>1), vcp::multirelational_graph<r>, vcp::graph >::type
+			>::type graph_type;
+	if( d ) {
+		skeleton.orient( options.reciprocity, options.seed + 1 );
+	}
+	skeleton.label( r, options.combinations, options.seed + 2 );
+	std::stringstream text;
+	skeleton.write( text );
+	graph_type g;
+	vcp::perf_counters::reset(); // each specialization reports its own phases
+	vcp::perf_counters::enter( vcp::perf_phase::load );
+	text >> g;
+
+	vcp::perf_counters::enter( vcp::perf_phase::precomputation );
+	vcp::vcp<n,r,d> profiler( g );
+	vcp::candidate_pairs<graph_type> degrees( g );
+	std::uint64_t edges( 0 ); // arcs when directed
+	for( vcp::const_vertex_iterator v( g.vertices_begin() ); v != g.vertices_end(); ++v ) {
+		edges += degrees.degree( v );
+	}
+	edges /= 2;
+	std::uint64_t neighbors( 0 );
+	for( std::size_t i( 0 ); i < pairs.size(); ++i ) {
+		neighbors += degrees.degree( g.vertices_begin() + pairs[ i ] );
+	}
+	std::uint64_t checksum( 0 );
+	std::chrono::steady_clock::time_point const start( std::chrono::steady_clock::now() );
+	for( std::size_t i( 0 ); i < pairs.size(); i += 2 ) {
+		checksum += profile_pair<n,r,d>( profiler, g.vertices_begin() + pairs[ i ], g.vertices_begin() + pairs[ i + 1 ], std::integral_constant<bool,r == 1>() );
+		vcp::perf_counters::enter( vcp::perf_phase::pairs );
+	}
+	double const seconds( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+	struct rusage usage;
+	getrusage( RUSAGE_SELF, &usage );
+
+	std::cout << (first ? "" : ",") << "\n\t\t{\"n\": " << n << ", \"r\": " << r << ", \"d\": " << d;
+	std::cout << ", \"edges\": " << edges << ", \"pairs\": " << pairs.size() / 2;
+	std::cout << ", \"seconds\": " << seconds;
+	std::cout << ", \"pairs_per_second\": " << (seconds > 0 ? pairs.size() / 2 / seconds : 0);
+	std::cout << ", \"ns_per_neighbor\": " << (neighbors > 0 ? seconds * 1e9 / neighbors : 0);
+	std::cout << ", \"peak_rss_kb\": " << usage.ru_maxrss << ", \"checksum\": " << checksum;
+	if( options.perf_counters ) {
+		std::cout << ", \"phases\": ";
+		vcp::perf_counters::write_summary( std::cout );
+	}
+	std::cout << "}";
+}
+
+// benchmarks r among the storage widths that vcp_generate instantiates for n and d, from the narrowest, skipping it when it is not one
+template <std::size_t n,std::size_t storage_r,bool d>
+typename std::enable_if<(storage_r <= vcp::max_relations)>::type run_storage( std::size_t r, vcp::synthetic_graph const & skeleton, std::vector<vcp::vertex_id_t> const & pairs, bench_options const & options, bool & first ) {
+	if( r != storage_r ) {
+		run_storage<n,vcp::storage_relations<n,d>( storage_r + 1 ),d>( r, skeleton, pairs, options, first );
+		return;
+	}
+	bench<n,storage_r,d>( skeleton, pairs, options, first );
+	first = false;
+}
+
+template <std::size_t n,std::size_t storage_r,bool d>
+typename std::enable_if<(storage_r > vcp::max_relations)>::type run_storage( std::size_t, vcp::synthetic_graph const &, std::vector<vcp::vertex_id_t> const &, bench_options const &, bool & ) {
+}
+
+// one entry per vcp<n,r,d> instantiation built by vcp_generate, which for r>1 are those of the storage widths; r=2 and r=30, which vcp_generate profiles with the storage widths that hold them, remain for comparison with earlier results
+template <std::size_t n,bool d>
+void run_relations( std::size_t r, vcp::synthetic_graph const & skeleton, std::vector<vcp::vertex_id_t> const & pairs, bench_options const & options, bool & first ) {
+	if( r == 1 ) {
+		bench<n,1,d>( skeleton, pairs, options, first );
+		first = false;
+	} else if( r == 2 ) {
+		bench<n,2,d>( skeleton, pairs, options, first );
+		first = false;
+	} else if( r == 30 ) {
+		bench<n,30,d>( skeleton, pairs, options, first );
+		first = false;
+	} else {
+		run_storage<n,vcp::storage_relations<n,d>( 2 ),d>( r, skeleton, pairs, options, first );
+	}
+}
+
+void run( std::size_t n, std::size_t r, bool d, vcp::synthetic_graph const & skeleton, std::vector<vcp::vertex_id_t> const & pairs, bench_options const & options, bool & first ) {
+	if( d ) {
+		if( n == 3 ) {
+			run_relations<3,1>( r, skeleton, pairs, options, first );
+		} else {
+			run_relations<4,1>( r, skeleton, pairs, options, first );
+		}
+	} else {
+		if( n == 3 ) {
+			run_relations<3,0>( r, skeleton, pairs, options, first );
+		} else {
+			run_relations<4,0>( r, skeleton, pairs, options, first );
+		}
+	}
+}
+
+int main( int argc, char * argv[] ) {
+	std::string generator;
+	std::size_t vertex_count;
+	double mean_degree;
+	std::string sampler;
+	std::size_t pair_count;
+	std::vector<std::size_t> ns;
+	std::vector<std::size_t> rs;
+	std::vector<std::size_t> ds;
+	bench_options options;
+	try {
+		TCLAP::CmdLine cmd( "Time each VCP specialization on a seeded synthetic graph and report the results as JSON.", ' ', "1.0.0" );
+		std::vector<std::string> allowedGenerators {"er", "ba", "rmat"};
+		TCLAP::ValuesConstraint<std::string> allowedGeneratorVals( allowedGenerators );
+		TCLAP::ValueArg<std::string> generatorArg( "g", "generator", "Graph generator: er (Erdos-Renyi), ba (Barabasi-Albert), or rmat (R-MAT with a=0.57, b=c=0.19; the vertex count is rounded up to a power of two)", false, "er", &allowedGeneratorVals, cmd );
+		TCLAP::ValueArg<std::size_t> verticesArg( "v", "vertices", "Number of vertices", false, 10000, "vertices", cmd );
+		TCLAP::ValueArg<double> degreeArg( "", "degree", "Mean degree of the undirected graph before orientation", false, 16, "degree", cmd );
+		TCLAP::ValueArg<double> reciprocityArg( "", "reciprocity", "For d=1, the probability that an edge is kept in both directions rather than one chosen at random", false, 0.5, "probability", cmd );
+		TCLAP::ValueArg<std::size_t> combinationsArg( "", "combinations", "For r>1, the number of distinct relation combinations from which edge values are drawn (0 to draw from all of them)", false, 0, "combinations", cmd );
+		std::vector<std::string> allowedSamplers {"uniform", "distance2", "hub"};
+		TCLAP::ValuesConstraint<std::string> allowedSamplerVals( allowedSamplers );
+		TCLAP::ValueArg<std::string> samplerArg( "", "sampler", "Pair sampler: uniform (any two vertices), distance2 (non-adjacent pairs with a common neighbor), or hub (endpoints drawn in proportion to degree)", false, "distance2", &allowedSamplerVals, cmd );
+		TCLAP::ValueArg<std::size_t> pairsArg( "p", "pairs", "Number of pairs to profile per specialization", false, 10000, "pairs", cmd );
+		TCLAP::ValueArg<std::uint64_t> seedArg( "s", "seed", "Seed for the graph, its labeling, and the pairs", false, 1, "seed", cmd );
+		std::vector<std::size_t> allowedN {3, 4};
+		TCLAP::ValuesConstraint<std::size_t> allowedNVals( allowedN );
+		TCLAP::MultiArg<std::size_t> nArg( "n", "n", "Benchmark only specializations with this n (repeatable)", false, &allowedNVals, cmd );
+		std::vector<std::size_t> allowedR {1, 2, 5, 10, 16, 21, 26, 30, 32, 37, 42, 48, 53, 58, 64};
+		TCLAP::ValuesConstraint<std::size_t> allowedRVals( allowedR );
+		TCLAP::MultiArg<std::size_t> rArg( "r", "r", "Benchmark only specializations with this r (repeatable). For r>1, vcp_generate instantiates the storage widths, the largest r whose subgraph addresses fill as many 64-bit words as fewer relations do; a storage width that vcp_generate does not instantiate for n and d is skipped.", false, &allowedRVals, cmd );
+		std::vector<std::size_t> allowedD {0, 1};
+		TCLAP::ValuesConstraint<std::size_t> allowedDVals( allowedD );
+		TCLAP::MultiArg<std::size_t> dArg( "d", "d", "Benchmark only specializations with this d (repeatable)", false, &allowedDVals, cmd );
+		TCLAP::SwitchArg perfCountersArg( "", "perf-counters", "Count cycles, instructions, L1 data and last-level cache misses, dTLB misses, and branch mispredictions with perf_event_open and report them per phase of profiling", cmd );
+		cmd.parse( argc, argv );
+		generator = generatorArg.getValue();
+		vertex_count = verticesArg.getValue();
+		mean_degree = degreeArg.getValue();
+		sampler = samplerArg.getValue();
+		pair_count = pairsArg.getValue();
+		ns = nArg.isSet() ? nArg.getValue() : allowedN;
+		rs = rArg.isSet() ? rArg.getValue() : allowedR;
+		ds = dArg.isSet() ? dArg.getValue() : allowedD;
+		options.reciprocity = reciprocityArg.getValue();
+		options.combinations = combinationsArg.getValue();
+		options.seed = seedArg.getValue();
+		options.perf_counters = perfCountersArg.isSet();
+	} catch( TCLAP::ArgException & e ) {
+		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+		return 1;
+	}
+
+	if( options.perf_counters ) {
+		std::vector<std::string> unavailable;
+		if( !vcp::perf_counters::enable( unavailable ) ) {
+			std::cerr << "warning: perf_event_open is not permitted; performance counters are disabled" << std::endl;
+			options.perf_counters = false;
+		} else if( !unavailable.empty() ) {
+			std::cerr << "warning: performance counters not supported here:";
+			for( std::size_t i( 0 ); i < unavailable.size(); ++i ) {
+				std::cerr << ' ' << unavailable[i];
+			}
+			std::cerr << std::endl;
+		}
+	}
+
+	try {
+		vcp::synthetic_graph skeleton( 0 );
+		if( generator == "er" ) {
+			skeleton = vcp::synthetic_graph::erdos_renyi( vertex_count, mean_degree, options.seed );
+		} else if( generator == "ba" ) {
+			skeleton = vcp::synthetic_graph::barabasi_albert( vertex_count, static_cast<std::size_t>( mean_degree / 2 + 0.5 ), options.seed );
+		} else {
+			std::size_t scale( 0 );
+			while( (std::size_t( 1 ) << scale) < vertex_count ) {
+				++scale;
+			}
+			skeleton = vcp::synthetic_graph::rmat( scale, mean_degree, 0.57, 0.19, 0.19, options.seed );
+		}
+		std::vector<vcp::vertex_id_t> pairs( skeleton.sample_pairs( vcp::parse_pair_sampler( sampler ), pair_count, options.seed + 3 ) );
+
+		std::cout << "{\n\t\"generator\": \"" << generator << "\", \"vertices\": " << skeleton.vertex_count() << ", \"edges\": " << skeleton.edge_count();
+		std::cout << ", \"sampler\": \"" << sampler << "\", \"seed\": " << options.seed << ",\n\t\"results\": [";
+		bool first( true );
+		for( std::size_t i( 0 ); i < ns.size(); ++i ) {
+			for( std::size_t j( 0 ); j < rs.size(); ++j ) {
+				for( std::size_t k( 0 ); k < ds.size(); ++k ) {
+					run( ns[ i ], rs[ j ], ds[ k ], skeleton, pairs, options, first );
+				}
+			}
+		}
+		std::cout << "\n\t]\n}" << std::endl;
+	} catch( std::exception const & e ) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -12,44 +12,766 @@ You should have received a copy of the GNU General Public License along with the
 */
 
 #include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <iostream>
+#include <memory>
 #include <fstream>
-#include <map>
+#include <numeric>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#include <fcntl.h>
+#include <unistd.h>
 #include <tclap/CmdLine.h>
+#include <vcp/buffered_writer.hpp>
+#include <vcp/candidate_pairs.hpp>
 #include <vcp/directed_graph.hpp>
+#include <vcp/element_index.hpp>
 #include <vcp/graph.hpp>
+#include <vcp/graph_statistics.hpp>
 #include <vcp/multirelational_graph.hpp>
 #include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/pair_cost.hpp>
+#include <vcp/pair_reader.hpp>
+#include <vcp/perf_counters.hpp>
+#include <vcp/parallel_chunks.hpp>
+#include <vcp/profile_cache.hpp>
+#include <vcp/profile_projection.hpp>
+#include <vcp/relation_mask.hpp>
+#include <vcp/relation_dictionary.hpp>
+#include <vcp/relation_storage.hpp>
+#include <vcp/v3_sample.hpp>
 #include <vcp/vcp.hpp>
+#include <vcp/vcp_dynamic_mapper.hpp>
+#include <vcp/vector_writer.hpp>
 
-template <std::size_t n>
-std::ostream & operator<<( std::ostream & os, std::array<unsigned long,n> const & array ) {
-	if( array.empty() ) {
-		return os;
+struct generation_options {
+	vcp::vector_format format;
+	std::size_t relations; // r as requested, which may be fewer relations than the instantiation that profiles them packs into the same address words
+	std::size_t relation_mask; // the relations onto which the graph is projected before profiling, 0 for all of them
+	std::size_t max_distance; // 0 to profile the input pairs, otherwise the candidate radius
+	std::size_t threads;
+	bool element_ids; // write dense element ids in place of the canonical addresses of sparse vectors
+	std::string element_dictionary; // file receiving the address of each element id
+	bool recode; // profile over dictionary codes of the relation combinations present in the graph
+	vcp::profile_cache * cache; // null to profile every pair
+	bool dedup; // profile each input pair once however often and in whichever order it occurs
+	std::size_t approx_budget; // 0 to profile exactly, otherwise the expected number of v3 candidates expanded per sampled pair
+	std::size_t approx_threshold; // pairs whose degree sum is at most this are profiled exactly
+	bool approx_variance; // follow each row of estimates with their variance estimates
+	std::string statistics_graph; // the graph file whose sidecar holds the global statistics of the n=4 engines, empty for each engine to count its own
+	std::vector<std::pair<std::size_t,bool> > views; // the (n, d) of each profile derived from that of the pair and written side by side, empty to write the profile itself
+};
+
+// the cache shared by every worker, the fingerprint under which profiles of the graph are cached, and the input pairs that occur more than once
+struct cache_state {
+	template <typename graph_type> cache_state( generation_options const & options, graph_type const & g ) : cache( options.cache ), fingerprint( options.cache != nullptr ? vcp::graph_fingerprint( g ) : 0 ), repeats( nullptr ) {}
+	vcp::profile_cache * cache;
+	std::uint64_t fingerprint;
+	vcp::repeated_pairs * repeats; // set once the input pairs have been counted
+};
+
+// the global statistics shared by the engines of every worker, loaded from the sidecar of the graph file when it is current, otherwise computed and written to it
+template <std::size_t r,bool d>
+struct statistics_state {
+	template <typename graph_type> statistics_state( generation_options const & options, graph_type const & g );
+	std::unique_ptr<vcp::graph_statistics<r,d> > statistics; // null unless requested
+};
+
+template <std::size_t r,bool d>
+template <typename graph_type>
+statistics_state<r,d>::statistics_state( generation_options const & options, graph_type const & g ) {
+	if( options.statistics_graph.empty() ) {
+		return;
+	}
+	statistics = vcp::graph_statistics<r,d>::load( g, options.statistics_graph );
+	if( !statistics ) {
+		statistics.reset( new vcp::graph_statistics<r,d>( g, options.threads ) );
+		if( !statistics->save( g, options.statistics_graph ) ) {
+			std::cerr << "warning: could not write " << vcp::graph_statistics<r,d>::sidecar_path( options.statistics_graph ) << std::endl;
+		}
+	}
+}
+
+// writes one row of (element id, count) entries in ascending id order, densely when the writer has a fixed width
+void write_element_row( std::vector<std::pair<std::size_t,unsigned long> > const & entries, std::vector<unsigned long> & counts, vcp::vector_writer & writer ) {
+	if( writer.fixed_width() ) {
+		for( std::vector<std::pair<std::size_t,unsigned long> >::const_iterator it( entries.begin() ); it != entries.end(); ++it ) {
+			counts[it->first] = it->second;
+		}
+		writer.write_row( counts.begin(), counts.end() );
+		for( std::vector<std::pair<std::size_t,unsigned long> >::const_iterator it( entries.begin() ); it != entries.end(); ++it ) {
+			counts[it->first] = 0;
+		}
+	} else {
+		for( std::vector<std::pair<std::size_t,unsigned long> >::const_iterator it( entries.begin() ); it != entries.end(); ++it ) {
+			writer.write_entry( it->first, it->second );
+		}
+		writer.end_row();
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+class dense_rows {
+	public:
+		typedef vcp::cached_vcp<n,r,d> profiler_type;
+		struct shared_state : cache_state, statistics_state<r,d> {
+			template <typename graph_type> shared_state( generation_options const & options, graph_type const & g ) : cache_state( options, g ), statistics_state<r,d>( options, g ) {}
+		};
+		template <typename graph_type> dense_rows( graph_type const & g, shared_state & shared );
+		static std::size_t width( shared_state const & shared );
+		static std::size_t address_bits( shared_state const & shared );
+		static void write_dictionary( shared_state const & shared, vcp::buffered_writer & out );
+		void emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer );
+	private:
+		profiler_type profiler;
+		std::vector<unsigned long> counts;
+};
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename graph_type>
+dense_rows<n,r,d>::dense_rows( graph_type const & g, shared_state & shared ) : profiler( g, shared.cache, shared.fingerprint, shared.repeats, shared.statistics.get() ), counts( profiler_type::element_count() ) {
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t dense_rows<n,r,d>::width( shared_state const & ) {
+	return profiler_type::element_count();
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t dense_rows<n,r,d>::address_bits( shared_state const & ) {
+	return n*(n-1)*r*(d+1)/2;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void dense_rows<n,r,d>::write_dictionary( shared_state const &, vcp::buffered_writer & ) { // element ids of r=1 vectors are their column positions
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void dense_rows<n,r,d>::emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer ) {
+	profiler.generate_vector( v1, v2, counts.begin() );
+	vcp::perf_counters::enter( vcp::perf_phase::output );
+	writer.write_row( counts.begin(), counts.end() );
+}
+
+// writes the profiles of several views of each pair side by side, all derived from the one profile of the pair
+template <std::size_t n,std::size_t r,bool d>
+class view_rows {
+	public:
+		typedef vcp::cached_vcp<n,r,d> profiler_type;
+		struct shared_state : cache_state, statistics_state<r,d> {
+			template <typename graph_type> shared_state( generation_options const & options, graph_type const & g );
+			std::vector<vcp::profile_projection> projections;
+		};
+		template <typename graph_type> view_rows( graph_type const & g, shared_state & shared );
+		static std::size_t width( shared_state const & shared );
+		static std::size_t address_bits( shared_state const & shared );
+		static void write_dictionary( shared_state const & shared, vcp::buffered_writer & out );
+		void emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer );
+	private:
+		std::vector<vcp::profile_projection> const & projections;
+		std::size_t vertex_count;
+		profiler_type profiler;
+		std::vector<unsigned long> counts;
+		std::vector<unsigned long> row;
+};
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename graph_type>
+view_rows<n,r,d>::shared_state::shared_state( generation_options const & options, graph_type const & g ) : cache_state( options, g ), statistics_state<r,d>( options, g ) {
+	for( std::size_t i( 0 ); i < options.views.size(); ++i ) {
+		if( options.views[i].first < n && g.vertex_count() < 4 ) {
+			throw std::invalid_argument( "three-vertex views are derived from four-vertex profiles, which require at least four vertices" );
+		}
+		projections.push_back( vcp::profile_projection( n, d, options.views[i].first, options.views[i].second ) );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename graph_type>
+view_rows<n,r,d>::view_rows( graph_type const & g, shared_state & shared ) : projections( shared.projections ), vertex_count( g.vertex_count() ), profiler( g, shared.cache, shared.fingerprint, shared.repeats, shared.statistics.get() ), counts( profiler_type::element_count() ), row( width( shared ) ) {
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t view_rows<n,r,d>::width( shared_state const & shared ) {
+	std::size_t columns( 0 );
+	for( std::size_t i( 0 ); i < shared.projections.size(); ++i ) {
+		columns += shared.projections[i].element_count();
+	}
+	return columns;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t view_rows<n,r,d>::address_bits( shared_state const & ) {
+	return n*(n-1)*r*(d+1)/2;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void view_rows<n,r,d>::write_dictionary( shared_state const &, vcp::buffered_writer & ) {
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void view_rows<n,r,d>::emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer ) {
+	profiler.generate_vector( v1, v2, counts.begin() );
+	vcp::perf_counters::enter( vcp::perf_phase::output );
+	std::vector<unsigned long>::iterator column( row.begin() );
+	for( std::size_t i( 0 ); i < projections.size(); ++i ) {
+		projections[i].project( counts.begin(), vertex_count, column );
+		column += projections[i].element_count();
+	}
+	writer.write_row( row.begin(), row.end() );
+}
+
+// estimates the r=1 four-vertex profiles of pairs above the degree threshold by sampling their v3 candidates
+template <std::size_t n,std::size_t r,bool d>
+class approx_rows {
+	public:
+		typedef vcp::vcp<n,r,d> profiler_type;
+		struct shared_state : statistics_state<r,d> {
+			template <typename graph_type> shared_state( generation_options const & options, graph_type const & g ) : statistics_state<r,d>( options, g ), budget( options.approx_budget ), threshold( options.approx_threshold ), variance( options.approx_variance ), repeats( nullptr ) {}
+			std::size_t budget;
+			std::size_t threshold;
+			bool variance;
+			vcp::repeated_pairs * repeats; // unused; --approx excludes --dedup
+		};
+		template <typename graph_type> approx_rows( graph_type const & g, shared_state & shared );
+		static std::size_t width( shared_state const & shared );
+		static std::size_t address_bits( shared_state const & shared );
+		static void write_dictionary( shared_state const & shared, vcp::buffered_writer & out );
+		void emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer );
+	private:
+		profiler_type profiler;
+		vcp::v3_sample sample;
+		bool variance;
+		std::vector<unsigned long> counts;
+};
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename graph_type>
+approx_rows<n,r,d>::approx_rows( graph_type const & g, shared_state & shared ) : profiler( g, shared.statistics.get() ), sample( profiler_type::element_count(), shared.budget, shared.threshold ), variance( shared.variance ), counts( width( shared ) ) {
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t approx_rows<n,r,d>::width( shared_state const & shared ) {
+	return profiler_type::element_count() * (shared.variance ? 2 : 1);
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t approx_rows<n,r,d>::address_bits( shared_state const & ) {
+	return n*(n-1)*r*(d+1)/2;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void approx_rows<n,r,d>::write_dictionary( shared_state const &, vcp::buffered_writer & ) {
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void approx_rows<n,r,d>::emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer ) {
+	profiler.estimate_vector( v1, v2, counts.begin(), sample );
+	if( variance ) { // rounded up so that integer formats never understate the error
+		std::vector<double> const & variances( sample.variances() );
+		for( std::size_t element( 0 ); element < variances.size(); ++element ) {
+			counts[profiler_type::element_count() + element] = static_cast<unsigned long>( std::ceil( variances[element] ) );
+		}
+	}
+	vcp::perf_counters::enter( vcp::perf_phase::output );
+	writer.write_row( counts.begin(), counts.end() );
+}
+
+template <std::size_t n,std::size_t r,bool d>
+class sparse_rows {
+	public:
+		typedef vcp::cached_vcp<n,r,d> profiler_type;
+		typedef typename profiler_type::subgraph_address_type subgraph_address_type;
+		struct shared_state : cache_state, statistics_state<r,d> {
+			template <typename graph_type> shared_state( generation_options const & options, graph_type const & g ) : cache_state( options, g ), statistics_state<r,d>( options, g ), relation_count( options.relations ), elements( options.element_ids ? new vcp::element_index<n,r,d>( options.relations ) : nullptr ) {
+				if( elements != nullptr && !elements->enumerated() && options.threads > 1 ) { // ids assigned on first observation would depend on the interleaving of the threads
+					throw std::invalid_argument( "--element-ids with more than one thread requires a subgraph address space of at most " + std::to_string( vcp::element_index<n,r,d>::max_enumerated_bits ) + " bits" );
+				}
+			}
+			std::size_t relation_count; // the r of the addresses written
+			std::unique_ptr<vcp::element_index<n,r,d> > elements; // null to write canonical addresses
+		};
+		template <typename graph_type> sparse_rows( graph_type const & g, shared_state & shared );
+		static std::size_t width( shared_state const & shared );
+		static std::size_t address_bits( shared_state const & shared );
+		static void write_dictionary( shared_state const & shared, vcp::buffered_writer & out );
+		void emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer );
+	private:
+		profiler_type profiler;
+		std::size_t relations;
+		vcp::element_index<n,r,d> * elements;
+		std::vector<std::pair<std::size_t,unsigned long> > entries;
+		std::vector<unsigned long> counts;
+};
+
+template <std::size_t n,std::size_t r,bool d>
+template <typename graph_type>
+sparse_rows<n,r,d>::sparse_rows( graph_type const & g, shared_state & shared ) : profiler( g, shared.cache, shared.fingerprint, shared.repeats, shared.statistics.get() ), relations( shared.relation_count ), elements( shared.elements.get() ), counts( width( shared ) ) {
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t sparse_rows<n,r,d>::width( shared_state const & shared ) { // vectors are dense only when every element id is known in advance
+	return shared.elements != nullptr && shared.elements->enumerated() ? shared.elements->size() : 0;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+std::size_t sparse_rows<n,r,d>::address_bits( shared_state const & shared ) {
+	return shared.elements != nullptr ? 64 : n*(n-1)*shared.relation_count*(d+1)/2;
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void sparse_rows<n,r,d>::write_dictionary( shared_state const & shared, vcp::buffered_writer & out ) {
+	if( shared.elements == nullptr ) {
+		return;
+	}
+	for( std::size_t id( 0 ); id < shared.elements->size(); ++id ) {
+		out.write_decimal( id );
+		out.put( ' ' );
+		out.write_decimal( shared.elements->address( id ) );
+		out.put( '\n' );
+	}
+	out.flush();
+}
+
+template <std::size_t n,std::size_t r,bool d>
+void sparse_rows<n,r,d>::emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer ) {
+	if( elements == nullptr ) {
+		auto sink = [this,&writer]( subgraph_address_type const & address, unsigned long count ) {
+			writer.write_entry( vcp::pack_relations<n,r,d>( address, relations ), count );
+		};
+		profiler.generate_vector( v1, v2, sink );
+		writer.end_row();
+		return;
+	}
+	entries.clear();
+	auto sink = [this]( subgraph_address_type const & address, unsigned long count ) {
+		entries.push_back( std::make_pair( elements->index( vcp::pack_relations<n,r,d>( address, relations ) ), count ) );
+	};
+	profiler.generate_vector( v1, v2, sink );
+	vcp::perf_counters::enter( vcp::perf_phase::output );
+	if( !elements->enumerated() ) { // ids assigned on first observation do not follow address order
+		std::sort( entries.begin(), entries.end() );
+	}
+	write_element_row( entries, counts, writer );
+}
+
+// profiles pairs over a copy of the graph whose edge values are replaced by relation_dictionary codes, which need far fewer relation bits when few combinations of relations occur, and decodes each element back to its canonical address over all r relations
+template <std::size_t n,std::size_t r,bool d,std::size_t code_r>
+class recoded_rows {
+	public:
+		typedef vcp::cached_vcp<n,code_r,d> profiler_type;
+		typedef typename std::conditional<d,vcp::multirelational_directed_graph<code_r>,vcp::multirelational_graph<code_r> >::type code_graph_type;
+		typedef typename vcp::vcp_dynamic_mapper<n,r,d>::subgraph_address_type subgraph_address_type;
+		struct shared_state : sparse_rows<n,r,d>::shared_state { // element ids and their dictionary are those of sparse_rows
+			template <typename graph_type> shared_state( generation_options const & options, graph_type const & g );
+			vcp::relation_dictionary<r> relations;
+			code_graph_type graph;
+			vcp::const_vertex_iterator source_vertices; // first vertex of the graph whose vertices are passed to emit
+			vcp::vcp_dynamic_mapper<n,r,d> mapper;
+		};
+		template <typename graph_type> recoded_rows( graph_type const & g, shared_state & shared );
+		static std::size_t width( shared_state const & shared );
+		static std::size_t address_bits( shared_state const & shared );
+		static void write_dictionary( shared_state const & shared, vcp::buffered_writer & out );
+		void emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer );
+	private:
+		shared_state & shared;
+		profiler_type profiler;
+		std::vector<std::pair<subgraph_address_type,unsigned long> > decoded;
+		std::vector<std::pair<std::size_t,unsigned long> > entries;
+		std::vector<unsigned long> counts;
+};
+
+template <std::size_t n,std::size_t r,bool d,std::size_t code_r>
+template <typename graph_type>
+recoded_rows<n,r,d,code_r>::shared_state::shared_state( generation_options const & options, graph_type const & g ) : sparse_rows<n,r,d>::shared_state( options, g ), relations( g ), graph( g, [this]( typename vcp::relation_dictionary<r>::value_type const & value ) { return relations.code( value ); } ), source_vertices( g.vertices_begin() ) {
+	this->fingerprint = this->cache != nullptr ? vcp::graph_fingerprint( graph ) : 0; // profiles are cached under the graph that is profiled
+}
+
+template <std::size_t n,std::size_t r,bool d,std::size_t code_r>
+template <typename graph_type>
+recoded_rows<n,r,d,code_r>::recoded_rows( graph_type const &, shared_state & shared ) : shared( shared ), profiler( shared.graph, shared.cache, shared.fingerprint, shared.repeats ), counts( width( shared ) ) {
+}
+
+template <std::size_t n,std::size_t r,bool d,std::size_t code_r>
+std::size_t recoded_rows<n,r,d,code_r>::width( shared_state const & shared ) {
+	return sparse_rows<n,r,d>::width( shared );
+}
+
+template <std::size_t n,std::size_t r,bool d,std::size_t code_r>
+std::size_t recoded_rows<n,r,d,code_r>::address_bits( shared_state const & shared ) {
+	return sparse_rows<n,r,d>::address_bits( shared );
+}
+
+template <std::size_t n,std::size_t r,bool d,std::size_t code_r>
+void recoded_rows<n,r,d,code_r>::write_dictionary( shared_state const & shared, vcp::buffered_writer & out ) {
+	sparse_rows<n,r,d>::write_dictionary( shared, out );
+}
+
+template <std::size_t n,std::size_t r,bool d,std::size_t code_r>
+void recoded_rows<n,r,d,code_r>::emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer ) {
+	decoded.clear();
+	auto sink = [this]( typename profiler_type::subgraph_address_type const & address, unsigned long count ) {
+		decoded.push_back( std::make_pair( shared.relations.template decode<code_r,n,d>( address, shared.mapper ), count ) );
+	};
+	vcp::const_vertex_iterator vertices( shared.graph.vertices_begin() );
+	profiler.generate_vector( vertices + (v1 - shared.source_vertices), vertices + (v2 - shared.source_vertices), sink );
+	vcp::perf_counters::enter( vcp::perf_phase::output );
+	std::sort( decoded.begin(), decoded.end() ); // decoding maps distinct elements to distinct elements but does not preserve their order
+	if( shared.elements == nullptr ) {
+		for( typename std::vector<std::pair<subgraph_address_type,unsigned long> >::const_iterator it( decoded.begin() ); it != decoded.end(); ++it ) {
+			writer.write_entry( vcp::pack_relations<n,r,d>( it->first, shared.relation_count ), it->second );
+		}
+		writer.end_row();
+		return;
+	}
+	entries.clear();
+	for( typename std::vector<std::pair<subgraph_address_type,unsigned long> >::const_iterator it( decoded.begin() ); it != decoded.end(); ++it ) {
+		entries.push_back( std::make_pair( shared.elements->index( vcp::pack_relations<n,r,d>( it->first, shared.relation_count ) ), it->second ) );
+	}
+	if( !shared.elements->enumerated() ) {
+		std::sort( entries.begin(), entries.end() );
 	}
-	std::cout << array[0];
-	for( std::size_t i( 1 ); i < n; ++i ) {
-		std::cout << ' ' << array[i];
+	write_element_row( entries, counts, writer );
+}
+
+// profiles one chunk of work: a range of input pairs, or a range of source vertices whose candidate pairs are enumerated in place
+template <typename graph_type,typename rows_type>
+class profile_worker {
+	public:
+		profile_worker( graph_type const & g, generation_options const & options, typename rows_type::shared_state & shared, vcp::pair_reader * reader, std::vector<vcp::vertex_id_t> const * pairs, std::size_t chunk_size, std::vector<std::uint64_t> const * first_rows );
+		void operator()( std::size_t chunk, vcp::buffered_writer & out );
+		std::uint64_t row_count() const;
+		std::uint64_t count_candidates( std::size_t chunk );
+	private:
+		graph_type const & g;
+		generation_options const & options;
+		typename rows_type::shared_state & shared;
+		vcp::pair_reader * reader;
+		std::vector<vcp::vertex_id_t> const * pairs;
+		std::size_t chunk_size;
+		std::vector<std::uint64_t> const * first_rows;
+		std::uint64_t rows;
+		rows_type profiler;
+		vcp::candidate_pairs<graph_type> candidates;
+		vcp::const_vertex_iterator vertex( vcp::vertex_id_t id ) const;
+		void emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer );
+};
+
+template <typename graph_type,typename rows_type>
+profile_worker<graph_type,rows_type>::profile_worker( graph_type const & g, generation_options const & options, typename rows_type::shared_state & shared, vcp::pair_reader * reader, std::vector<vcp::vertex_id_t> const * pairs, std::size_t chunk_size, std::vector<std::uint64_t> const * first_rows ) : g( g ), options( options ), shared( shared ), reader( reader ), pairs( pairs ), chunk_size( chunk_size ), first_rows( first_rows ), rows( 0 ), profiler( g, shared ), candidates( g, std::max<std::size_t>( 2, options.max_distance ) ) {
+}
+
+template <typename graph_type,typename rows_type>
+void profile_worker<graph_type,rows_type>::operator()( std::size_t chunk, vcp::buffered_writer & out ) {
+	vcp::vector_writer writer( out, options.format, rows_type::width( shared ), rows_type::address_bits( shared ) );
+	writer.set_row_index( rows ); // exact when a single worker visits the chunks in order; otherwise overridden below where row indices are written
+	std::uint64_t first_row( writer.row_index() );
+	if( options.max_distance != 0 ) {
+		if( first_rows != nullptr ) {
+			writer.set_row_index( first_row = (*first_rows)[chunk] );
+		}
+		auto visit = [&]( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, std::size_t ) {
+			emit( v1, v2, writer );
+		};
+		vcp::const_vertex_iterator end( g.vertices_begin() + std::min( g.vertex_count(), (chunk + 1) * chunk_size ) );
+		for( vcp::const_vertex_iterator v1( g.vertices_begin() + chunk * chunk_size ); v1 != end; ++v1 ) {
+			candidates.enumerate( v1, true, visit );
+		}
+	} else if( pairs != nullptr || reader->mapped() ) {
+		std::size_t pair_count( pairs != nullptr ? pairs->size() / 2 : reader->size() );
+		writer.set_row_index( first_row = chunk * chunk_size );
+		for( std::size_t i( chunk * chunk_size ); i < std::min( pair_count, (chunk + 1) * chunk_size ); ++i ) {
+			vcp::vertex_id_t v1;
+			vcp::vertex_id_t v2;
+			if( pairs != nullptr ) {
+				v1 = (*pairs)[2 * i];
+				v2 = (*pairs)[2 * i + 1];
+			} else {
+				reader->get( i, v1, v2 );
+			}
+			emit( vertex( v1 ), vertex( v2 ), writer );
+		}
+	} else {
+		vcp::vertex_id_t v1;
+		vcp::vertex_id_t v2;
+		while( reader->next( v1, v2 ) ) {
+			emit( vertex( v1 ), vertex( v2 ), writer );
+		}
 	}
-	std::cout << '\n';
-	return os;
+	rows += writer.row_index() - first_row;
 }
 
-template <typename T>
-std::ostream & operator<<( std::ostream & os, std::map<T,unsigned long> const & map ) {
-	if( map.empty() ) {
-		return os;
+template <typename graph_type,typename rows_type>
+std::uint64_t profile_worker<graph_type,rows_type>::row_count() const {
+	return rows;
+}
+
+template <typename graph_type,typename rows_type>
+std::uint64_t profile_worker<graph_type,rows_type>::count_candidates( std::size_t chunk ) {
+	std::uint64_t count( 0 );
+	auto visit = [&count]( vcp::const_vertex_iterator, vcp::const_vertex_iterator, std::size_t ) {
+		++count;
+	};
+	vcp::const_vertex_iterator end( g.vertices_begin() + std::min( g.vertex_count(), (chunk + 1) * chunk_size ) );
+	for( vcp::const_vertex_iterator v1( g.vertices_begin() + chunk * chunk_size ); v1 != end; ++v1 ) {
+		candidates.enumerate( v1, false, visit );
 	}
-	typename std::map<T,unsigned long>::const_iterator it( map.begin() );
-	std::cout << it->first << ',' << it->second;
-	++it;
-	for( ; it != map.end(); ++it ) {
-		std::cout << ' ' << it->first << ',' << it->second;
+	return count;
+}
+
+template <typename graph_type,typename rows_type>
+vcp::const_vertex_iterator profile_worker<graph_type,rows_type>::vertex( vcp::vertex_id_t id ) const {
+	if( id >= g.vertex_count() ) {
+		throw std::out_of_range( "vertex id " + std::to_string( id ) + " is not in the graph" );
+	}
+	return g.vertices_begin() + id;
+}
+
+template <typename graph_type,typename rows_type>
+void profile_worker<graph_type,rows_type>::emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer ) {
+#ifdef VCP_INSTRUMENT
+	vcp::pair_cost_scope cost( g.vertex_id( v1 ), g.vertex_id( v2 ), candidates.degree( v1 ), candidates.degree( v2 ) );
+#endif
+	profiler.emit( v1, v2, writer );
+	vcp::perf_counters::enter( vcp::perf_phase::pairs ); // until the next pair is profiled
+}
+
+template <typename rows_type,typename graph_type>
+void profile( graph_type const & g, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	typedef profile_worker<graph_type,rows_type> worker_type;
+	typename rows_type::shared_state shared( options, g );
+	vcp::vector_writer writer( out, options.format, rows_type::width( shared ), rows_type::address_bits( shared ) );
+	writer.begin();
+
+	std::vector<vcp::vertex_id_t> pairs;
+	vcp::repeated_pairs repeats;
+	std::size_t chunk_count( 1 );
+	std::size_t chunk_size( 0 );
+	if( options.max_distance != 0 ) {
+		chunk_size = std::max<std::size_t>( 1, std::min<std::size_t>( 1024, g.vertex_count() / (64 * options.threads) ) );
+		chunk_count = (g.vertex_count() + chunk_size - 1) / chunk_size;
+	} else if( options.threads > 1 || reader.mapped() || options.dedup ) {
+		if( !reader.mapped() ) { // streamed pairs are read up front so that threads can divide them by index, and so that repeated pairs can be counted
+			vcp::vertex_id_t v1;
+			vcp::vertex_id_t v2;
+			while( reader.next( v1, v2 ) ) {
+				pairs.push_back( v1 );
+				pairs.push_back( v2 );
+			}
+		}
+		std::size_t pair_count( reader.mapped() ? reader.size() : pairs.size() / 2 );
+		chunk_size = std::max<std::size_t>( 1, std::min<std::size_t>( 65536, pair_count / (64 * options.threads) ) );
+		chunk_count = (pair_count + chunk_size - 1) / chunk_size;
+		if( options.dedup ) {
+			for( std::size_t i( 0 ); i < pair_count; ++i ) {
+				if( reader.mapped() ) {
+					vcp::vertex_id_t v1;
+					vcp::vertex_id_t v2;
+					reader.get( i, v1, v2 );
+					repeats.count( v1, v2 );
+				} else {
+					repeats.count( pairs[2 * i], pairs[2 * i + 1] );
+				}
+			}
+			repeats.seal();
+			shared.repeats = &repeats;
+		}
+	}
+
+	std::vector<worker_type> workers;
+	workers.reserve( options.threads );
+	std::vector<std::uint64_t> first_rows;
+	bool indexed_rows( options.max_distance != 0 && options.threads > 1 && options.format == vcp::vector_format::triplet );
+	for( std::size_t i( 0 ); i < options.threads; ++i ) {
+		workers.push_back( worker_type( g, options, shared, &reader, pairs.empty() ? nullptr : &pairs, chunk_size, indexed_rows ? &first_rows : nullptr ) );
+	}
+	if( indexed_rows ) { // triplet records carry the pair index, so count each chunk's candidates before profiling
+		first_rows.assign( chunk_count + 1, 0 );
+		std::vector<std::thread> threads;
+		std::atomic<std::size_t> next_chunk( 0 );
+		for( std::size_t i( 0 ); i < options.threads; ++i ) {
+			threads.push_back( std::thread( [&,i]() {
+				for( std::size_t chunk( next_chunk++ ); chunk < chunk_count; chunk = next_chunk++ ) {
+					first_rows[chunk + 1] = workers[i].count_candidates( chunk );
+				}
+			} ) );
+		}
+		for( std::size_t i( 0 ); i < threads.size(); ++i ) {
+			threads[i].join();
+		}
+		std::partial_sum( first_rows.begin(), first_rows.end(), first_rows.begin() );
+	}
+	vcp::run_chunks( workers, chunk_count, out, true );
+	std::uint64_t rows( 0 );
+	for( std::size_t i( 0 ); i < workers.size(); ++i ) {
+		rows += workers[i].row_count();
+	}
+	writer.set_row_index( rows );
+	writer.finish();
+	if( !options.element_dictionary.empty() ) {
+		int fd( open( options.element_dictionary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 ) );
+		if( fd < 0 ) {
+			throw std::system_error( errno, std::system_category(), "open " + options.element_dictionary );
+		}
+		vcp::buffered_writer dictionary( fd );
+		rows_type::write_dictionary( shared, dictionary );
+		close( fd );
+	}
+	if( options.dedup ) {
+		std::cerr << "{\"repeated_pairs\": {\"distinct\": " << repeats.distinct() << ", \"derived\": " << repeats.derived() << "}}" << std::endl;
+	}
+}
+
+// codes fill addresses of one or two words, where recoding gains the most; graphs with more relation combinations are profiled directly
+template <std::size_t n,bool d>
+constexpr std::size_t max_code_relations() {
+	return vcp::storage_relations<n,d>( vcp::storage_relations<n,d>( 1 ) + 1 );
+}
+
+template <std::size_t n,std::size_t r,bool d,std::size_t code_r,typename graph_type>
+typename std::enable_if<(code_r <= max_code_relations<n,d>())>::type profile_codes( graph_type const & g, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options, std::size_t code_bits ) {
+	if( code_bits <= code_r ) {
+		profile<recoded_rows<n,r,d,code_r> >( g, reader, out, options );
+	} else {
+		profile_codes<n,r,d,vcp::storage_relations<n,d>( code_r + 1 )>( g, reader, out, options, code_bits );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d,std::size_t code_r,typename graph_type>
+typename std::enable_if<(code_r > max_code_relations<n,d>())>::type profile_codes( graph_type const & g, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options, std::size_t ) {
+	profile<sparse_rows<n,r,d> >( g, reader, out, options );
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+typename std::enable_if<(r > max_code_relations<n,d>())>::type profile_recoded( graph_type const & g, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	profile_codes<n,r,d,vcp::storage_relations<n,d>( 1 )>( g, reader, out, options, vcp::relation_dictionary<r>( g ).code_bits() );
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+typename std::enable_if<(r <= max_code_relations<n,d>())>::type profile_recoded( graph_type const & g, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) { // addresses of r relations are already as narrow as those of any code width
+	typedef typename std::conditional<r == 1,dense_rows<n,r,d>,sparse_rows<n,r,d> >::type rows_type;
+	profile<rows_type>( g, reader, out, options );
+}
+
+// sampling is implemented by the four-vertex r=1 engines
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+typename std::enable_if<(n != 4 || r != 1)>::type profile_approx( graph_type const &, vcp::pair_reader &, vcp::buffered_writer &, generation_options const & ) {
+	throw std::invalid_argument( "--approx requires n=4 and r=1" );
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+typename std::enable_if<(n == 4 && r == 1)>::type profile_approx( graph_type const & g, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	profile<approx_rows<n,r,d> >( g, reader, out, options );
+}
+
+// edge values may name only the relations requested, which can be fewer than the instantiation reading the graph stores
+template <typename graph_type>
+void check_edge_values( graph_type const & g, vcp::const_edge_iterator begin, vcp::const_edge_iterator end, std::size_t relations ) {
+	for( vcp::const_edge_iterator it( begin ); it != end; ++it ) {
+		if( relations < 64 && (g.edge_value( it ) >> relations) != 0 ) {
+			throw std::invalid_argument( "edge value " + std::to_string( g.edge_value( it ) ) + " names a relation beyond r=" + std::to_string( relations ) );
+		}
+	}
+}
+
+template <typename graph_type>
+void check_relations( graph_type const &, std::size_t ) { // graphs of one relation carry no edge values
+}
+
+template <std::size_t r>
+void check_relations( vcp::multirelational_graph<r> const & g, std::size_t relations ) {
+	check_edge_values( g, g.edges_begin(), g.edges_end(), relations );
+}
+
+template <std::size_t r>
+void check_relations( vcp::multirelational_directed_graph<r> const & g, std::size_t relations ) {
+	check_edge_values( g, g.out_edges_begin(), g.out_edges_end(), relations );
+}
+
+// views are derived from the dense r=1 profiles
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+typename std::enable_if<(r != 1)>::type profile_views( graph_type const &, vcp::pair_reader &, vcp::buffered_writer &, generation_options const & ) {
+	throw std::invalid_argument( "--view requires r=1" );
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+typename std::enable_if<(r == 1)>::type profile_views( graph_type const & g, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	profile<view_rows<n,r,d> >( g, reader, out, options );
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+void profile_graph( graph_type const & g, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	typedef typename std::conditional<r == 1,dense_rows<n,r,d>,sparse_rows<n,r,d> >::type rows_type;
+	if( options.approx_budget != 0 ) {
+		profile_approx<n,r,d>( g, reader, out, options );
+	} else if( !options.views.empty() ) {
+		profile_views<n,r,d>( g, reader, out, options );
+	} else if( options.recode ) {
+		profile_recoded<n,r,d>( g, reader, out, options );
+	} else {
+		profile<rows_type>( g, reader, out, options );
+	}
+}
+
+// projections onto a subset of the relations are profiled as any other graph of r relations
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+typename std::enable_if<(r == 1)>::type profile_masked( graph_type const &, vcp::pair_reader &, vcp::buffered_writer &, generation_options const & ) {
+	throw std::invalid_argument( "--relations requires r>1" );
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+typename std::enable_if<(r > 1)>::type profile_masked( graph_type const & g, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	vcp::relation_mask<graph_type> masks( g );
+	profile_graph<n,r,d>( masks.view( options.relation_mask ), reader, out, options );
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+void generate( std::istream & file, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	graph_type g;
+	vcp::perf_counters::enter( vcp::perf_phase::load );
+	file >> g;
+	check_relations( g, options.relations );
+	vcp::perf_counters::enter( vcp::perf_phase::precomputation ); // engine construction, mapping tables, and dictionaries
+	if( options.relation_mask != 0 ) {
+		profile_masked<n,r,d>( g, reader, out, options );
+	} else {
+		profile_graph<n,r,d>( g, reader, out, options );
+	}
+}
+
+// profiles with the first instantiation, in increasing order of storage width, whose addresses hold the requested relations; every r of a storage width shares the instantiation for the largest, whose addresses are packed to r relations on output
+template <std::size_t n,std::size_t r,bool d>
+typename std::enable_if<(r < vcp::max_relations)>::type generate_storage( std::istream & file, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	if( options.relations <= r ) {
+		generate<n,r,d,typename std::conditional<d,vcp::multirelational_directed_graph<r>,vcp::multirelational_graph<r> >::type>( file, reader, out, options );
+	} else {
+		generate_storage<n,vcp::storage_relations<n,d>( r + 1 ),d>( file, reader, out, options );
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d>
+typename std::enable_if<(r == vcp::max_relations)>::type generate_storage( std::istream & file, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	generate<n,r,d,typename std::conditional<d,vcp::multirelational_directed_graph<r>,vcp::multirelational_graph<r> >::type>( file, reader, out, options );
+}
+
+template <std::size_t n,bool d>
+void generate_relations( std::istream & file, vcp::pair_reader & reader, vcp::buffered_writer & out, generation_options const & options ) {
+	if( options.relations == 1 ) {
+		generate<n,1,d,typename std::conditional<d,vcp::directed_graph,vcp::graph>::type>( file, reader, out, options );
+	} else {
+		generate_storage<n,vcp::storage_relations<n,d>( 2 ),d>( file, reader, out, options );
 	}
-	std::cout << '\n';
-	return os;
 }
 
 int main( int argc, char * argv[] ) {
@@ -57,132 +779,236 @@ int main( int argc, char * argv[] ) {
 	std::size_t r;
 	bool d;
 	std::string filename;
+	vcp::vector_format format;
+	bool direct;
+	vcp::pair_encoding pair_encoding;
+	std::string pair_filename;
+	bool perf_counters;
+	std::size_t cache_size;
+	std::string cache_filename;
+	generation_options options;
 	try {
-		TCLAP::CmdLine cmd( "Output VCP vectors for pairs read from standard input.", ' ', "1.0.0" );
+		TCLAP::CmdLine cmd( "Output VCP vectors for pairs read from standard input or enumerated from the graph.", ' ', "1.0.0" );
 		std::vector<std::size_t> allowedN {3, 4, 5, 6, 7, 8};
 		TCLAP::ValuesConstraint<std::size_t> allowedNVals( allowedN );
 		TCLAP::UnlabeledValueArg<std::size_t> nArg( "n", "n\tNumber of vertices in the VCP", true, 3, &allowedNVals, cmd );
-		TCLAP::UnlabeledValueArg<std::size_t> rArg( "r", "r\tNumber of relations in the VCP", true, 1, "[1,inf]", cmd );
+		TCLAP::UnlabeledValueArg<std::size_t> rArg( "r", "r\tNumber of relations in the VCP", true, 1, "[1,64]", cmd );
 		std::vector<std::size_t> allowedD {0, 1};
 		TCLAP::ValuesConstraint<std::size_t> allowedDVals( allowedD );
 		TCLAP::UnlabeledValueArg<std::size_t> dArg( "d", "d\tWhether the VCP considers directedness", true, 0, &allowedDVals, cmd );
 		TCLAP::UnlabeledValueArg<std::string> filenameArg( "graph_filename", "\tThe name of the file containing the graph", true, "", "graph_filename", cmd );
+		std::vector<std::string> allowedFormats {"text", "binary", "npy", "triplet"};
+		TCLAP::ValuesConstraint<std::string> allowedFormatVals( allowedFormats );
+		TCLAP::ValueArg<std::string> formatArg( "f", "format", "Output format: text, binary (little-endian uint64 rows, r=1 only), npy (r=1 only, requires seekable output), or triplet (little-endian pair index, address, count records)", false, "text", &allowedFormatVals, cmd );
+		std::vector<std::string> allowedPairFormats {"text", "u32", "u64"};
+		TCLAP::ValuesConstraint<std::string> allowedPairFormatVals( allowedPairFormats );
+		TCLAP::ValueArg<std::string> pairFormatArg( "", "pair-format", "Encoding of the input pairs: text (whitespace-separated vertex ids), u32, or u64 (packed little-endian v1, v2 records). Binary pair files are memory-mapped when they are regular files.", false, "text", &allowedPairFormatVals, cmd );
+		TCLAP::ValueArg<std::string> pairFileArg( "", "pair-file", "Read pairs from this file instead of standard input", false, "", "pair_filename", cmd );
+		std::vector<std::string> allowedPairs {"input", "distance2", "all-within-k"};
+		TCLAP::ValuesConstraint<std::string> allowedPairsVals( allowedPairs );
+		TCLAP::ValueArg<std::string> pairsArg( "", "pairs", "Source of pairs: input (read pairs), distance2 (every non-adjacent pair at distance two), or all-within-k (every non-adjacent pair within k hops). Enumerated pairs are profiled in the order ell_2_pairs prints them.", false, "input", &allowedPairsVals, cmd );
+		TCLAP::ValueArg<std::size_t> kArg( "k", "k", "Radius for --pairs=all-within-k", false, 2, "hops", cmd );
+		TCLAP::ValueArg<std::size_t> threadsArg( "t", "threads", "Number of profiling threads (0 for one per hardware thread); output order is unaffected", false, 1, "threads", cmd );
+		TCLAP::SwitchArg elementIdsArg( "e", "element-ids", "For r>1, write dense element ids in place of canonical subgraph addresses. Where the address space is small enough to enumerate, ids are those printed by vcp_map and the binary and npy formats write dense rows; otherwise ids are assigned in order of first observation, which requires a single thread.", cmd );
+		TCLAP::ValueArg<std::string> elementDictionaryArg( "", "element-dictionary", "With --element-ids, write each element id and its canonical subgraph address to this file once profiling completes", false, "", "dictionary_filename", cmd );
+		TCLAP::SwitchArg recodeArg( "", "recode", "For r>1, profile over dictionary codes of the relation combinations that occur on edges, which is faster when few combinations occur. Output is identical to profiling without this option.", cmd );
+#ifdef VCP_INSTRUMENT
+		TCLAP::ValueArg<std::size_t> topPairsArg( "", "top-pairs", "Number of most expensive pairs listed in the cost summary written to standard error at exit and on SIGUSR1", false, 20, "pairs", cmd );
+#endif
+		TCLAP::SwitchArg perfCountersArg( "", "perf-counters", "Count cycles, instructions, L1 data and last-level cache misses, dTLB misses, and branch mispredictions with perf_event_open, and write their attribution to the phases of profiling to standard error as JSON on completion", cmd );
+		TCLAP::SwitchArg dedupArg( "", "dedup", "Profile each input pair once however often it occurs, in either order, and derive its other occurrences from that profile. Pairs are read up front to count them.", cmd );
+		TCLAP::ValueArg<std::size_t> cacheSizeArg( "", "cache-size", "Cache the profiles of pairs in this many MiB of memory, serving repeated pairs and pairs repeated in reverse order without profiling them again", false, 256, "MiB", cmd );
+		TCLAP::ValueArg<std::string> cacheFileArg( "", "cache-file", "Append profiles evicted from the cache, and those remaining at completion, to this file, and serve pairs from the profiles it holds for the same graph. Implies a cache of --cache-size MiB.", false, "", "cache_filename", cmd );
+		TCLAP::ValueArg<std::size_t> approxArg( "", "approx", "For n=4 and r=1, estimate the profiles of pairs whose degrees sum to more than --approx-threshold by expanding a random sample of this many of their common and exclusive neighbors in expectation, scaling the counts it contributes to Horvitz-Thompson estimates. Negative estimates are written as zero, which biases small counts upward. Counts that need no expansion stay exact. 0 profiles every pair exactly.", false, 0, "candidates", cmd );
+		TCLAP::ValueArg<std::size_t> approxThresholdArg( "", "approx-threshold", "Profile pairs whose degrees sum to at most this exactly under --approx", false, 1024, "degree_sum", cmd );
+		TCLAP::SwitchArg approxVarianceArg( "", "approx-variance", "Under --approx, follow the estimates in each row with an estimate of the variance of each, rounded up; exact rows have zero variance", cmd );
+		TCLAP::SwitchArg statisticsArg( "", "statistics", "For n=4, read the global statistics that the engines complete vectors with from the sidecar file graph_filename.stats instead of counting them over every edge. If the sidecar is missing, damaged, or was written for a different graph file, the statistics are computed in parallel and the sidecar is written.", cmd );
+		TCLAP::MultiArg<std::string> viewArg( "", "view", "For r=1, write the profile of the view n',d' of each pair, and of every further view given, side by side in one row, all derived from the one n,d profile of the pair. n' may be n, or 3 when n=4, in which case the graph must have at least four vertices; d' may be d, or 0 when d=1 for the undirected graph of the reciprocated edges. For example, '--view 4,1 --view 3,0' with n=4 and d=1 writes the directed four-vertex profile followed by the three-vertex profile of the reciprocated edges.", false, "n',d'", cmd );
+		TCLAP::ValueArg<std::string> relationsArg( "", "relations", "For r>1, profile the projection of the graph onto these relations, given as comma-separated zero-based indices below r, as though every other relation were removed from the graph file. Edges that carry none of them are dropped. Output addresses keep the layout of r relations.", false, "", "indices", cmd );
+		TCLAP::SwitchArg directArg( "", "direct", "Write standard output with O_DIRECT in whole aligned blocks, bypassing the page cache. Ignored with a warning if standard output does not support it or is not positioned at a block boundary, as when appending to a file whose length is not a whole number of 4096-byte blocks.", cmd );
 		cmd.parse( argc, argv );
 		n = nArg.getValue();
 		r = rArg.getValue();
 		d = dArg.getValue();
 		filename = filenameArg.getValue();
+		if( n > 4 ) {
+			throw TCLAP::ArgException( "profiles of more than four vertices are not implemented; use n=3 or n=4", nArg.longID() );
+		}
+		if( r == 0 || r > vcp::max_relations ) {
+			throw TCLAP::ArgException( "r must be between 1 and " + std::to_string( vcp::max_relations ), rArg.longID() );
+		}
+		format = vcp::parse_vector_format( formatArg.getValue() );
+		direct = directArg.isSet();
+		perf_counters = perfCountersArg.isSet();
+		pair_encoding = vcp::parse_pair_encoding( pairFormatArg.getValue() );
+		pair_filename = pairFileArg.getValue();
+		options.format = format;
+		options.relations = r;
+		options.max_distance = pairsArg.getValue() == "input" ? 0 : pairsArg.getValue() == "distance2" ? 2 : kArg.getValue();
+		if( pairsArg.getValue() == "all-within-k" && kArg.getValue() < 2 ) {
+			throw TCLAP::ArgException( "k must be at least 2", kArg.longID() );
+		}
+		options.threads = threadsArg.getValue();
+		if( options.threads == 0 ) {
+			options.threads = std::max( 1u, std::thread::hardware_concurrency() );
+		}
+		options.element_ids = elementIdsArg.isSet();
+		options.element_dictionary = elementDictionaryArg.getValue();
+		options.recode = recodeArg.isSet();
+		options.dedup = dedupArg.isSet();
+		if( options.dedup && options.max_distance != 0 ) {
+			throw TCLAP::ArgException( "requires --pairs=input; enumerated pairs are distinct", dedupArg.longID() );
+		}
+		cache_size = cacheSizeArg.isSet() || cacheFileArg.isSet() ? cacheSizeArg.getValue() : 0;
+		cache_filename = cacheFileArg.getValue();
+		options.approx_budget = approxArg.getValue();
+		options.approx_threshold = approxThresholdArg.getValue();
+		options.approx_variance = approxVarianceArg.isSet();
+		if( options.approx_budget != 0 ) {
+			if( n != 4 || r != 1 ) {
+				throw TCLAP::ArgException( "requires n=4 and r=1", approxArg.longID() );
+			}
+			if( options.recode || options.dedup || cacheSizeArg.isSet() || cacheFileArg.isSet() ) { // estimates are neither cached nor shared between occurrences
+				throw TCLAP::ArgException( "cannot be combined with --recode, --dedup, --cache-size, or --cache-file", approxArg.longID() );
+			}
+		} else if( options.approx_variance || approxThresholdArg.isSet() ) {
+			throw TCLAP::ArgException( "requires --approx", options.approx_variance ? approxVarianceArg.longID() : approxThresholdArg.longID() );
+		}
+		if( statisticsArg.isSet() ) {
+			if( n != 4 ) {
+				throw TCLAP::ArgException( "requires n=4", statisticsArg.longID() );
+			}
+			if( options.recode ) { // the recoded graph has statistics of its own
+				throw TCLAP::ArgException( "cannot be combined with --recode", statisticsArg.longID() );
+			}
+			options.statistics_graph = filename;
+		}
+		options.relation_mask = 0;
+		if( relationsArg.isSet() ) {
+			if( r == 1 ) {
+				throw TCLAP::ArgException( "requires r>1", relationsArg.longID() );
+			}
+			if( statisticsArg.isSet() ) { // the sidecar holds the statistics of the whole graph
+				throw TCLAP::ArgException( "cannot be combined with --statistics", relationsArg.longID() );
+			}
+			std::string const & indices( relationsArg.getValue() );
+			for( std::size_t begin( 0 ); begin <= indices.size(); ) {
+				std::size_t end( std::min( indices.find( ',', begin ), indices.size() ) );
+				std::string const index( indices.substr( begin, end - begin ) );
+				if( index.empty() || index.find_first_not_of( "0123456789" ) != std::string::npos || index.size() > 2 || std::stoul( index ) >= r ) {
+					throw TCLAP::ArgException( "expected comma-separated relation indices below r, not " + indices, relationsArg.longID() );
+				}
+				options.relation_mask |= std::size_t( 1 ) << std::stoul( index );
+				begin = end + 1;
+			}
+		}
+		for( std::size_t i( 0 ); i < viewArg.getValue().size(); ++i ) {
+			std::string const & view( viewArg.getValue()[i] );
+			std::size_t const comma( view.find( ',' ) );
+			if( view.size() != 3 || comma != 1 || (view[0] != '3' && view[0] != '4') || (view[2] != '0' && view[2] != '1') ) {
+				throw TCLAP::ArgException( "expected n',d' with n' of 3 or 4 and d' of 0 or 1, not " + view, viewArg.longID() );
+			}
+			std::size_t const view_n( view[0] - '0' );
+			bool const view_d( view[2] == '1' );
+			if( view_n > n || view_n + 1 < n || (view_d && !d) ) {
+				throw TCLAP::ArgException( "a view may drop at most one vertex and cannot add directedness: " + view, viewArg.longID() );
+			}
+			options.views.push_back( std::make_pair( view_n, view_d ) );
+		}
+		if( !options.views.empty() ) {
+			if( r != 1 ) {
+				throw TCLAP::ArgException( "requires r=1", viewArg.longID() );
+			}
+			if( options.approx_budget != 0 ) {
+				throw TCLAP::ArgException( "cannot be combined with --approx", viewArg.longID() );
+			}
+		}
+#ifdef VCP_INSTRUMENT
+		vcp::pair_cost_recorder::retain_top( topPairsArg.getValue() );
+#endif
+		if( !options.element_dictionary.empty() && !options.element_ids ) {
+			throw TCLAP::ArgException( "requires --element-ids", elementDictionaryArg.longID() );
+		}
 	} catch( TCLAP::ArgException & e ) {
 		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
 		return 1;
 	}
 	
+	if( perf_counters ) {
+		std::vector<std::string> unavailable;
+		if( !vcp::perf_counters::enable( unavailable ) ) {
+			std::cerr << "warning: perf_event_open is not permitted; performance counters are disabled" << std::endl;
+			perf_counters = false;
+		} else if( !unavailable.empty() ) {
+			std::cerr << "warning: performance counters not supported here:";
+			for( std::size_t i( 0 ); i < unavailable.size(); ++i ) {
+				std::cerr << ' ' << unavailable[i];
+			}
+			std::cerr << std::endl;
+		}
+	}
+
+#ifdef VCP_INSTRUMENT
+	vcp::pair_cost_reporter reporter( std::cerr ); // before any profiling thread starts
+#endif
+
 	std::ifstream file;
 	file.open( filename, std::ifstream::in );
 	if( !file ) {
 		std::cerr << "error opening file: " << filename << std::endl;
 	}
 
-	vcp::vertex_id_t v1;
-	vcp::vertex_id_t v2;
+	int pair_fd( 0 );
+	if( !pair_filename.empty() ) {
+		pair_fd = open( pair_filename.c_str(), O_RDONLY );
+		if( pair_fd < 0 ) {
+			std::cerr << "error opening file: " << pair_filename << std::endl;
+			return 1;
+		}
+	}
 
-	if( d ) {
-		if( n == 3 ) {
-			if( r == 1 ) {
-				vcp::directed_graph g;
-				file >> g;
-				vcp::vcp<3,1,1> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			} else if( r == 2 ) {
-				vcp::multirelational_directed_graph<2> g;
-				file >> g;
-				vcp::vcp<3,2,1> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			} else if( r == 30 ) {
-				vcp::multirelational_directed_graph<30> g;
-				file >> g;
-				vcp::vcp<3,30,1> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			}
-		} else if( n == 4 ) {
-			if( r == 1 ) {
-				vcp::directed_graph g;
-				file >> g;
-				vcp::vcp<4,1,1> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			} else if( r == 2 ) {
-				vcp::multirelational_directed_graph<2> g;
-				file >> g;
-				vcp::vcp<4,2,1> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			} else if( r == 30 ) {
-				vcp::multirelational_directed_graph<30> g;
-				file >> g;
-				vcp::vcp<4,30,1> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			}
+	if( direct && !vcp::buffered_writer::enable_direct_io( 1 ) ) {
+		std::cerr << "warning: O_DIRECT is not supported for standard output or its offset is not block-aligned; writing normally" << std::endl;
+		direct = false;
+	}
+	vcp::buffered_writer out( 1, vcp::buffered_writer::default_capacity, direct );
+	std::unique_ptr<vcp::profile_cache> cache;
+	try {
+		if( cache_size != 0 || !cache_filename.empty() ) {
+			cache.reset( new vcp::profile_cache( cache_size << 20, cache_filename ) );
 		}
-	} else {
-		if( n == 3 ) {
-			if( r == 1 ) {
-				vcp::graph g;
-				file >> g;
-				vcp::vcp<3,1,0> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			} else if( r == 2 ) {
-				vcp::multirelational_graph<2> g;
-				file >> g;
-				vcp::vcp<3,2,0> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			} else if( r == 30 ) {
-				vcp::multirelational_graph<30> g;
-				file >> g;
-				vcp::vcp<3,30,0> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
+		options.cache = cache.get();
+		vcp::pair_reader pairs( pair_fd, pair_encoding );
+		if( d ) {
+			if( n == 3 ) {
+				generate_relations<3,1>( file, pairs, out, options );
+			} else {
+				generate_relations<4,1>( file, pairs, out, options );
 			}
-		} else if( n == 4 ) {
-			if( r == 1 ) {
-				vcp::graph g;
-				file >> g;
-				vcp::vcp<4,1,0> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			} else if( r == 2 ) {
-				vcp::multirelational_graph<2> g;
-				file >> g;
-				vcp::vcp<4,2,0> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
-			} else if( r == 30 ) {
-				vcp::multirelational_graph<30> g;
-				file >> g;
-				vcp::vcp<4,30,0> profiler( g );
-				while( std::cin >> v1 >> v2 ) {
-					std::cout << profiler.generate_vector( vcp::const_vertex_iterator( g.vertices_begin() + v1 ), vcp::const_vertex_iterator( g.vertices_begin() + v2) );
-				}
+		} else {
+			if( n == 3 ) {
+				generate_relations<3,0>( file, pairs, out, options );
+			} else {
+				generate_relations<4,0>( file, pairs, out, options );
 			}
 		}
+		if( cache != nullptr ) {
+			cache->flush();
+		}
+	} catch( std::exception const & e ) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
 	}
 
+	if( cache != nullptr ) {
+		std::cerr << "{\"cache\": ";
+		cache->write_summary( std::cerr );
+		std::cerr << '}' << std::endl;
+	}
+	if( perf_counters ) {
+		std::cerr << "{\"phases\": ";
+		vcp::perf_counters::write_summary( std::cerr );
+		std::cerr << '}' << std::endl;
+	}
 	return 0;
 }
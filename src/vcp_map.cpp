@@ -11,14 +11,21 @@ The Vertex Collocation Profiles code base is distributed in the hope that it wil
 You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <vector>
 #include <tclap/CmdLine.h>
+#include <vcp/buffered_writer.hpp>
+#include <vcp/vcp_canonical_mapper.hpp>
 #include <vcp/vcp_static_mapper.hpp>
 
 class MemoryArgConstraint : public TCLAP::Constraint<std::string> {
@@ -49,15 +56,31 @@ class MemoryArgConstraint : public TCLAP::Constraint<std::string> {
 		}
 };
 
+template <typename mapper_type>
+void write_mapping( mapper_type const & mapper, std::size_t subgraph_count ) {
+	vcp::buffered_writer out( 1 );
+	for( std::size_t address( 0 ); address < subgraph_count; ++address ) {
+		out.write_decimal( mapper.element_address( address ) );
+		out.put( '\n' );
+	}
+	out.flush();
+}
+
 int main( int argc, const char* argv[] ) {
 	std::size_t n;
 	std::size_t r;
 	bool d;
+	bool canonical;
+	std::size_t threads;
+	std::string cache_path;
 	std::size_t max_bytes( std::numeric_limits<std::size_t>::max() );
 	try {
 		TCLAP::CmdLine cmd( "Output the subgraph-to-element mapping for a particular VCP", ' ', "1.0.0" );
 		MemoryArgConstraint mac;
-		TCLAP::ValueArg<std::string> memoryArg( "m", "mmax", "If more than MAXIMUM_MEMORY would be required for computation, do not proceed with computation. Print the number of subgraphs in the VCP and exit.", false, "", &mac, cmd );
+		TCLAP::ValueArg<std::string> memoryArg( "m", "mmax", "If more than MAXIMUM_MEMORY would be required for computation, do not proceed with computation. Print the number of subgraphs in the VCP and exit. Not applicable with --canonical.", false, "", &mac, cmd );
+		TCLAP::SwitchArg canonicalArg( "c", "canonical", "Compute the mapping from one representative per isomorphism class rather than from a table of every subgraph. Memory is proportional to the number of elements, at the cost of a canonical labeling per subgraph.", cmd );
+		TCLAP::ValueArg<std::size_t> threadsArg( "t", "threads", "Number of threads across which to divide the subgraph address space when building the mapping table (0 for one per hardware thread)", false, 1, "threads", cmd );
+		TCLAP::ValueArg<std::string> cacheDirArg( "", "cache-dir", "Directory holding binary mapping tables keyed by n, r, and d. An existing table is memory-mapped instead of recomputed, and a missing one is written after it is built. Not applicable with --canonical.", false, "", "directory", cmd );
 		std::vector<std::size_t> allowedN {3, 4, 5, 6, 7, 8};
 		TCLAP::ValuesConstraint<std::size_t> allowedNVals( allowedN );
 		TCLAP::UnlabeledValueArg<std::size_t> nArg( "n", "n\tNumber of vertices in the VCP", true, 3, &allowedNVals, cmd );
@@ -71,6 +94,14 @@ int main( int argc, const char* argv[] ) {
 		n = nArg.getValue();
 		r = rArg.getValue();
 		d = dArg.getValue();
+		canonical = canonicalArg.getValue();
+		threads = threadsArg.getValue();
+		if( threads == 0 ) {
+			threads = std::max( 1u, std::thread::hardware_concurrency() );
+		}
+		if( cacheDirArg.isSet() ) {
+			cache_path = cacheDirArg.getValue() + "/" + vcp::vcp_static_mapper::cache_filename( n, r, d );
+		}
 		std::string s( memoryArg.getValue() );
 		if( !s.empty() ) {
 			max_bytes = 1;
@@ -79,7 +110,7 @@ int main( int argc, const char* argv[] ) {
 				s = s.substr( 0, s.size() - 1 );
 				max_bytes *= 1024;
 			} else if( suffix == 'm' ) {
-				s = s.substr( 0, s.size() - 11 );
+				s = s.substr( 0, s.size() - 1 );
 				max_bytes *= 1024 * 1024;
 			} else if( suffix == 'g' ) {
 				s = s.substr( 0, s.size() - 1 );
@@ -95,12 +126,23 @@ int main( int argc, const char* argv[] ) {
 	}
 	
 	std::size_t subgraph_count( vcp::vcp_static_mapper::subgraph_count( n, r, d ) );
-	if( subgraph_count * sizeof( std::size_t ) > max_bytes ) {
+	if( !canonical && subgraph_count * sizeof( std::uint32_t ) > max_bytes ) {
 		std::cout << subgraph_count << std::endl;
 		return 0;
 	}
-	vcp::vcp_static_mapper mapper( n, r, d );
-	std::cout << mapper;
+	try {
+		if( canonical ) {
+			write_mapping( vcp::vcp_canonical_mapper( n, r, d ), subgraph_count );
+		} else {
+			write_mapping( vcp::vcp_static_mapper( n, r, d, threads, cache_path ), subgraph_count );
+		}
+	} catch( std::system_error const & e ) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	} catch( std::length_error const & e ) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
 	
 	return 0;
 }
@@ -0,0 +1,583 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <tclap/CmdLine.h>
+#include <vcp/buffered_writer.hpp>
+#include <vcp/directed_graph.hpp>
+#include <vcp/graph.hpp>
+#include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/multirelational_graph.hpp>
+#include <vcp/profile_cache.hpp>
+#include <vcp/vcp.hpp>
+#include <vcp/vector_writer.hpp>
+
+// Protocol, all integers little-endian. On connecting, the server sends four uint32 values: n, r, d, and the width of each
+// response row, which is the element count for r=1 and the size in bytes of a subgraph address for r>1. Each request is a
+// uint64 id, a uint32 pair count, and that many pairs of uint32 vertex ids. Each response is the request id, a uint32 status
+// (0 for success, 1 for a rejected request), a uint64 payload length, and the payload: for r=1, one row of uint64 counts per
+// pair, and for r>1, a triplet record of pair index, address, and count for every nonzero element, as in vcp_generate; for
+// a rejected request, the reason as text. Requests may be pipelined, and responses are sent in the order of the requests;
+// a client with more than 64 requests outstanding must read responses while it writes, because the server stops reading.
+
+std::uint32_t const max_batch_pairs( 1 << 24 );
+
+class connection;
+
+// one request, whose pairs are divided into chunks that any worker may profile
+struct batch {
+	batch( std::shared_ptr<connection> const & owner, std::uint64_t id, std::uint64_t sequence );
+	std::shared_ptr<connection> owner;
+	std::uint64_t id;
+	std::uint64_t sequence; // position in the owner's response stream
+	std::vector<std::uint32_t> pairs;
+	std::vector<std::string> chunks;
+	std::atomic<std::size_t> remaining;
+	std::string error; // nonempty if the request is rejected
+};
+
+batch::batch( std::shared_ptr<connection> const & owner, std::uint64_t id, std::uint64_t sequence ) : owner( owner ), id( id ), sequence( sequence ), remaining( 0 ) {
+}
+
+struct job {
+	std::shared_ptr<batch> work;
+	std::size_t chunk;
+};
+
+class job_queue {
+	public:
+		job_queue();
+		void push( job const & next );
+		bool pop( job & next ); // false once the queue is closed and empty
+		void close();
+	private:
+		std::mutex mutex;
+		std::condition_variable available;
+		std::deque<job> jobs;
+		bool closed;
+};
+
+job_queue::job_queue() : closed( false ) {
+}
+
+void job_queue::push( job const & next ) {
+	std::lock_guard<std::mutex> lock( mutex );
+	jobs.push_back( next );
+	available.notify_one();
+}
+
+bool job_queue::pop( job & next ) {
+	std::unique_lock<std::mutex> lock( mutex );
+	available.wait( lock, [this]() { return closed || !jobs.empty(); } );
+	if( jobs.empty() ) {
+		return false;
+	}
+	next = jobs.front();
+	jobs.pop_front();
+	return true;
+}
+
+void job_queue::close() {
+	std::lock_guard<std::mutex> lock( mutex );
+	closed = true;
+	available.notify_all();
+}
+
+// streams responses in request order however their chunks finish, so that clients may pipeline requests; a writer thread per connection keeps a slow client from holding up the workers
+class connection {
+	public:
+		explicit connection( int fd );
+		~connection();
+		int descriptor() const;
+		std::uint64_t admit(); // the sequence number of the next request, once fewer than max_in_flight are unanswered
+		void complete( batch const & done );
+		void write_responses(); // runs on the writer thread until finish is called and every admitted request is answered
+		void finish();
+		void send_hello( std::uint32_t n, std::uint32_t r, std::uint32_t d, std::uint32_t width );
+	private:
+		constexpr static const std::uint64_t max_in_flight = 64;
+		int fd;
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::map<std::uint64_t,std::shared_ptr<std::string> > finished; // responses waiting for earlier ones
+		std::uint64_t admitted;
+		std::uint64_t next_response;
+		bool finishing;
+		bool broken; // the client went away; responses are discarded
+		vcp::buffered_writer out;
+};
+
+constexpr const std::uint64_t connection::max_in_flight;
+
+connection::connection( int fd ) : fd( fd ), admitted( 0 ), next_response( 0 ), finishing( false ), broken( false ), out( fd, 1 << 16 ) {
+}
+
+connection::~connection() {
+	close( fd );
+}
+
+int connection::descriptor() const {
+	return fd;
+}
+
+std::uint64_t connection::admit() {
+	std::unique_lock<std::mutex> lock( mutex );
+	changed.wait( lock, [this]() { return admitted - next_response < max_in_flight; } );
+	return admitted++;
+}
+
+void connection::send_hello( std::uint32_t n, std::uint32_t r, std::uint32_t d, std::uint32_t width ) {
+	out.write_le( n );
+	out.write_le( r );
+	out.write_le( d );
+	out.write_le( width );
+	out.flush();
+}
+
+void connection::complete( batch const & done ) {
+	std::shared_ptr<std::string> response( new std::string() ); // assembled outside the lock
+	std::size_t length( done.error.size() );
+	for( std::size_t i( 0 ); i < done.chunks.size(); ++i ) {
+		length += done.chunks[i].size();
+	}
+	vcp::buffered_writer header( -1, 32 );
+	header.write_le( done.id );
+	header.write_le( static_cast<std::uint32_t>( done.error.empty() ? 0 : 1 ) );
+	header.write_le( static_cast<std::uint64_t>( length ) );
+	response->reserve( header.size() + length );
+	response->append( header.data(), header.size() );
+	response->append( done.error );
+	for( std::size_t i( 0 ); i < done.chunks.size(); ++i ) {
+		response->append( done.chunks[i] );
+	}
+	std::lock_guard<std::mutex> lock( mutex );
+	finished[done.sequence] = response;
+	changed.notify_all();
+}
+
+void connection::write_responses() {
+	std::unique_lock<std::mutex> lock( mutex );
+	for( ;; ) {
+		changed.wait( lock, [this]() { return (!finished.empty() && finished.begin()->first == next_response) || (finishing && next_response == admitted); } );
+		if( finished.empty() || finished.begin()->first != next_response ) {
+			return;
+		}
+		std::shared_ptr<std::string> response( finished.begin()->second );
+		finished.erase( finished.begin() );
+		lock.unlock();
+		if( !broken ) {
+			try {
+				out.write( response->data(), response->size() );
+				out.flush();
+			} catch( std::system_error const & ) {
+				broken = true;
+			}
+		}
+		lock.lock();
+		++next_response;
+		changed.notify_all();
+	}
+}
+
+void connection::finish() {
+	std::lock_guard<std::mutex> lock( mutex );
+	finishing = true;
+	changed.notify_all();
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+class server_worker {
+	public:
+		server_worker( graph_type const & g, vcp::profile_cache * cache, std::uint64_t fingerprint );
+		void operator()( job const & next );
+		static std::size_t width();
+		static vcp::vector_format format();
+	private:
+		typedef vcp::cached_vcp<n,r,d> profiler_type;
+		graph_type const & g;
+		profiler_type profiler;
+		std::vector<unsigned long> counts;
+		vcp::buffered_writer chunk_out;
+		static std::size_t width( std::true_type );
+		static std::size_t width( std::false_type );
+		void emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer, std::true_type );
+		void emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer, std::false_type );
+};
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+server_worker<n,r,d,graph_type>::server_worker( graph_type const & g, vcp::profile_cache * cache, std::uint64_t fingerprint ) : g( g ), profiler( g, cache, fingerprint ), counts( r == 1 ? width() : 0 ), chunk_out( -1, 1 << 16 ) {
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+std::size_t server_worker<n,r,d,graph_type>::width() { // element count of the dense r=1 rows, or bytes per address of the r>1 triplets
+	return width( std::integral_constant<bool,r == 1>() );
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+std::size_t server_worker<n,r,d,graph_type>::width( std::true_type ) {
+	return profiler_type::element_count();
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+std::size_t server_worker<n,r,d,graph_type>::width( std::false_type ) {
+	return (n*(n-1)*r*(d+1)/2 + 63) / 64 * 8;
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+vcp::vector_format server_worker<n,r,d,graph_type>::format() {
+	return r == 1 ? vcp::vector_format::binary : vcp::vector_format::triplet;
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+void server_worker<n,r,d,graph_type>::emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer, std::true_type ) {
+	profiler.generate_vector( v1, v2, counts.begin() );
+	writer.write_row( counts.begin(), counts.end() );
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+void server_worker<n,r,d,graph_type>::emit( vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, vcp::vector_writer & writer, std::false_type ) {
+	auto sink = [&writer]( typename profiler_type::subgraph_address_type const & address, unsigned long count ) {
+		writer.write_entry( address, count );
+	};
+	profiler.generate_vector( v1, v2, sink );
+	writer.end_row();
+}
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+void server_worker<n,r,d,graph_type>::operator()( job const & next ) {
+	batch & work( *next.work );
+	std::size_t const pair_count( work.pairs.size() / 2 );
+	std::size_t const chunk_pairs( (pair_count + work.chunks.size() - 1) / work.chunks.size() );
+	std::size_t const first( next.chunk * chunk_pairs );
+	vcp::vector_writer writer( chunk_out, format(), r == 1 ? width() : 0, n*(n-1)*r*(d+1)/2 );
+	writer.set_row_index( first ); // triplet pair indices are relative to the request
+	for( std::size_t i( first ); i < std::min( pair_count, first + chunk_pairs ); ++i ) {
+		emit( g.vertices_begin() + work.pairs[2 * i], g.vertices_begin() + work.pairs[2 * i + 1], writer, std::integral_constant<bool,r == 1>() );
+	}
+	work.chunks[next.chunk].assign( chunk_out.data(), chunk_out.size() );
+	chunk_out.clear();
+	if( --work.remaining == 0 ) {
+		work.owner->complete( work );
+	}
+}
+
+bool read_fully( int fd, void * data, std::size_t size ) { // false at end of stream before any byte is read
+	char * bytes( static_cast<char *>( data ) );
+	std::size_t done( 0 );
+	while( done < size ) {
+		ssize_t got( read( fd, bytes + done, size - done ) );
+		if( got < 0 && errno == EINTR ) {
+			continue;
+		}
+		if( got <= 0 ) {
+			if( got == 0 && done == 0 ) {
+				return false;
+			}
+			throw std::runtime_error( got == 0 ? "truncated request" : std::strerror( errno ) );
+		}
+		done += got;
+	}
+	return true;
+}
+
+template <typename integral_type>
+integral_type decode_le( unsigned char const * bytes ) {
+	integral_type value( 0 );
+	for( std::size_t i( sizeof( integral_type ) ); i-- > 0; ) {
+		value = (value << 8) | bytes[i];
+	}
+	return value;
+}
+
+// reads requests until the client closes its end, validates them, and queues their chunks
+void serve_connection( std::shared_ptr<connection> client, job_queue & jobs, std::size_t vertex_count, std::size_t chunk_pairs ) {
+	std::thread writer( &connection::write_responses, client.get() );
+	try {
+		unsigned char header[12];
+		while( read_fully( client->descriptor(), header, sizeof( header ) ) ) {
+			std::uint64_t const id( decode_le<std::uint64_t>( header ) );
+			std::uint32_t const pair_count( decode_le<std::uint32_t>( header + 8 ) );
+			if( pair_count > max_batch_pairs ) { // the stream cannot be resynchronized without reading the pairs, so the connection ends here
+				std::shared_ptr<batch> work( new batch( client, id, client->admit() ) );
+				work->error = "a request may contain at most " + std::to_string( max_batch_pairs ) + " pairs";
+				client->complete( *work );
+				break;
+			}
+			std::vector<unsigned char> bytes( 8 * static_cast<std::size_t>( pair_count ) );
+			if( pair_count != 0 && !read_fully( client->descriptor(), &bytes[0], bytes.size() ) ) { // thrown before the request is admitted, since a response it awaits would never be completed
+				throw std::runtime_error( "truncated request" );
+			}
+			std::shared_ptr<batch> work( new batch( client, id, client->admit() ) );
+			work->pairs.resize( 2 * static_cast<std::size_t>( pair_count ) );
+			for( std::size_t i( 0 ); i < work->pairs.size(); ++i ) {
+				work->pairs[i] = decode_le<std::uint32_t>( &bytes[4 * i] );
+				if( work->pairs[i] >= vertex_count && work->error.empty() ) {
+					work->error = "vertex id " + std::to_string( work->pairs[i] ) + " is not in the graph";
+				}
+			}
+			if( !work->error.empty() || pair_count == 0 ) {
+				client->complete( *work );
+				continue;
+			}
+			std::size_t const chunk_count( (pair_count + chunk_pairs - 1) / chunk_pairs );
+			work->chunks.resize( chunk_count );
+			work->remaining = chunk_count;
+			for( std::size_t chunk( 0 ); chunk < chunk_count; ++chunk ) {
+				jobs.push( job{ work, chunk } );
+			}
+		}
+	} catch( std::exception const & e ) {
+		std::cerr << "warning: closing connection: " << e.what() << std::endl;
+	}
+	client->finish();
+	writer.join();
+}
+
+struct server_options {
+	std::string socket_path;
+	std::size_t threads;
+	std::size_t chunk_pairs;
+	std::size_t cache_bytes; // 0 without a cache in memory
+	std::string cache_filename;
+};
+
+template <std::size_t n,std::size_t r,bool d,typename graph_type>
+void serve( std::istream & file, server_options const & options ) {
+	typedef server_worker<n,r,d,graph_type> worker_type;
+	graph_type g;
+	file >> g;
+	std::unique_ptr<vcp::profile_cache> cache;
+	if( options.cache_bytes != 0 || !options.cache_filename.empty() ) {
+		cache.reset( new vcp::profile_cache( options.cache_bytes, options.cache_filename ) );
+	}
+	std::uint64_t const fingerprint( cache != nullptr ? vcp::graph_fingerprint( g ) : 0 );
+	std::vector<std::unique_ptr<worker_type> > workers; // each profiler's global precomputation is done once, here
+	for( std::size_t i( 0 ); i < options.threads; ++i ) {
+		workers.push_back( std::unique_ptr<worker_type>( new worker_type( g, cache.get(), fingerprint ) ) );
+	}
+
+	int listener( socket( AF_UNIX, SOCK_STREAM, 0 ) );
+	if( listener < 0 ) {
+		throw std::system_error( errno, std::system_category(), "socket" );
+	}
+	sockaddr_un address;
+	std::memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	if( options.socket_path.size() >= sizeof( address.sun_path ) ) {
+		throw std::invalid_argument( "socket path is too long: " + options.socket_path );
+	}
+	std::strcpy( address.sun_path, options.socket_path.c_str() );
+	unlink( options.socket_path.c_str() );
+	if( bind( listener, reinterpret_cast<sockaddr *>( &address ), sizeof( address ) ) != 0 || listen( listener, 64 ) != 0 ) {
+		throw std::system_error( errno, std::system_category(), "bind " + options.socket_path );
+	}
+
+	// SIGINT and SIGTERM stop accepting connections; those already open are answered until their clients close them
+	sigset_t stop_signals;
+	sigemptyset( &stop_signals );
+	sigaddset( &stop_signals, SIGINT );
+	sigaddset( &stop_signals, SIGTERM );
+	pthread_sigmask( SIG_BLOCK, &stop_signals, nullptr );
+	signal( SIGPIPE, SIG_IGN );
+	std::shared_ptr<std::atomic<bool> > stopping( new std::atomic<bool>( false ) );
+	std::thread( [stop_signals,stopping,listener]() {
+		int signal;
+		sigwait( &stop_signals, &signal );
+		*stopping = true;
+		shutdown( listener, SHUT_RDWR );
+	} ).detach();
+
+	job_queue jobs;
+	std::vector<std::thread> pool;
+	for( std::size_t i( 0 ); i < workers.size(); ++i ) {
+		pool.push_back( std::thread( [&jobs,&workers,i]() {
+			job next;
+			while( jobs.pop( next ) ) {
+				(*workers[i])( next );
+				next.work.reset();
+			}
+		} ) );
+	}
+
+	std::cerr << "listening on " << options.socket_path << std::endl;
+	std::vector<std::pair<std::thread,std::shared_ptr<std::atomic<bool> > > > readers;
+	int failure( 0 );
+	while( !*stopping ) {
+		int fd( accept( listener, nullptr, nullptr ) );
+		if( fd < 0 ) {
+			if( errno == EINTR || errno == ECONNABORTED ) {
+				continue;
+			}
+			failure = *stopping ? 0 : errno;
+			break;
+		}
+		std::shared_ptr<connection> client( new connection( fd ) );
+		std::shared_ptr<std::atomic<bool> > finished( new std::atomic<bool>( false ) );
+		try {
+			client->send_hello( n, r, d, worker_type::width() );
+		} catch( std::system_error const & ) {
+			continue;
+		}
+		readers.push_back( std::make_pair( std::thread( [client,finished,&jobs,&g,&options]() {
+			serve_connection( client, jobs, g.vertex_count(), options.chunk_pairs );
+			*finished = true;
+		} ), finished ) );
+		for( std::size_t i( readers.size() ); i-- > 0; ) { // reap readers whose clients have gone
+			if( *readers[i].second ) {
+				readers[i].first.join();
+				readers.erase( readers.begin() + i );
+			}
+		}
+	}
+	close( listener );
+	unlink( options.socket_path.c_str() );
+	for( std::size_t i( 0 ); i < readers.size(); ++i ) {
+		readers[i].first.join();
+	}
+	jobs.close();
+	for( std::size_t i( 0 ); i < pool.size(); ++i ) {
+		pool[i].join();
+	}
+	if( cache != nullptr ) {
+		cache->flush();
+		std::cerr << "{\"cache\": ";
+		cache->write_summary( std::cerr );
+		std::cerr << '}' << std::endl;
+	}
+	if( failure != 0 ) {
+		throw std::system_error( failure, std::system_category(), "accept" );
+	}
+}
+
+int main( int argc, char * argv[] ) {
+	std::size_t n;
+	std::size_t r;
+	bool d;
+	std::string filename;
+	server_options options;
+	try {
+		TCLAP::CmdLine cmd( "Load a graph once and answer batched VCP queries over a Unix-domain socket.", ' ', "1.0.0" );
+		std::vector<std::size_t> allowedN {3, 4};
+		TCLAP::ValuesConstraint<std::size_t> allowedNVals( allowedN );
+		TCLAP::UnlabeledValueArg<std::size_t> nArg( "n", "n\tNumber of vertices in the VCP", true, 3, &allowedNVals, cmd );
+		std::vector<std::size_t> allowedR {1, 2, 30};
+		TCLAP::ValuesConstraint<std::size_t> allowedRVals( allowedR );
+		TCLAP::UnlabeledValueArg<std::size_t> rArg( "r", "r\tNumber of relations in the VCP", true, 1, &allowedRVals, cmd );
+		std::vector<std::size_t> allowedD {0, 1};
+		TCLAP::ValuesConstraint<std::size_t> allowedDVals( allowedD );
+		TCLAP::UnlabeledValueArg<std::size_t> dArg( "d", "d\tWhether the VCP considers directedness", true, 0, &allowedDVals, cmd );
+		TCLAP::UnlabeledValueArg<std::string> filenameArg( "graph_filename", "\tThe name of the file containing the graph", true, "", "graph_filename", cmd );
+		TCLAP::UnlabeledValueArg<std::string> socketArg( "socket_path", "\tThe path at which to listen; an existing file there is replaced", true, "", "socket_path", cmd );
+		TCLAP::ValueArg<std::size_t> threadsArg( "t", "threads", "Number of profiling threads, each with its own profiler (0 for one per hardware thread)", false, 0, "threads", cmd );
+		TCLAP::ValueArg<std::size_t> chunkArg( "", "chunk", "Number of pairs of a request profiled together by one thread; larger requests are divided among threads", false, 256, "pairs", cmd );
+		TCLAP::ValueArg<std::size_t> cacheSizeArg( "", "cache-size", "Cache the profiles of answered pairs in this many MiB of memory, serving repeated pairs and pairs repeated in reverse order without profiling them again", false, 256, "MiB", cmd );
+		TCLAP::ValueArg<std::string> cacheFileArg( "", "cache-file", "Append profiles evicted from the cache, and those remaining at shutdown, to this file, and serve pairs from the profiles it holds for the same graph. Implies a cache of --cache-size MiB.", false, "", "cache_filename", cmd );
+		cmd.parse( argc, argv );
+		n = nArg.getValue();
+		r = rArg.getValue();
+		d = dArg.getValue();
+		filename = filenameArg.getValue();
+		options.socket_path = socketArg.getValue();
+		options.threads = threadsArg.getValue();
+		if( options.threads == 0 ) {
+			options.threads = std::max( 1u, std::thread::hardware_concurrency() );
+		}
+		options.chunk_pairs = chunkArg.getValue();
+		if( options.chunk_pairs == 0 ) {
+			throw TCLAP::ArgException( "must be positive", chunkArg.longID() );
+		}
+		options.cache_bytes = cacheSizeArg.isSet() || cacheFileArg.isSet() ? cacheSizeArg.getValue() << 20 : 0;
+		options.cache_filename = cacheFileArg.getValue();
+	} catch( TCLAP::ArgException & e ) {
+		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+		return 1;
+	}
+
+	std::ifstream file;
+	file.open( filename, std::ifstream::in );
+	if( !file ) {
+		std::cerr << "error opening file: " << filename << std::endl;
+		return 1;
+	}
+
+	try {
+		if( d ) {
+			if( n == 3 ) {
+				if( r == 1 ) {
+					serve<3,1,1,vcp::directed_graph>( file, options );
+				} else if( r == 2 ) {
+					serve<3,2,1,vcp::multirelational_directed_graph<2>>( file, options );
+				} else if( r == 30 ) {
+					serve<3,30,1,vcp::multirelational_directed_graph<30>>( file, options );
+				}
+			} else if( n == 4 ) {
+				if( r == 1 ) {
+					serve<4,1,1,vcp::directed_graph>( file, options );
+				} else if( r == 2 ) {
+					serve<4,2,1,vcp::multirelational_directed_graph<2>>( file, options );
+				} else if( r == 30 ) {
+					serve<4,30,1,vcp::multirelational_directed_graph<30>>( file, options );
+				}
+			}
+		} else {
+			if( n == 3 ) {
+				if( r == 1 ) {
+					serve<3,1,0,vcp::graph>( file, options );
+				} else if( r == 2 ) {
+					serve<3,2,0,vcp::multirelational_graph<2>>( file, options );
+				} else if( r == 30 ) {
+					serve<3,30,0,vcp::multirelational_graph<30>>( file, options );
+				}
+			} else if( n == 4 ) {
+				if( r == 1 ) {
+					serve<4,1,0,vcp::graph>( file, options );
+				} else if( r == 2 ) {
+					serve<4,2,0,vcp::multirelational_graph<2>>( file, options );
+				} else if( r == 30 ) {
+					serve<4,30,0,vcp::multirelational_graph<30>>( file, options );
+				}
+			}
+		}
+	} catch( std::exception const & e ) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
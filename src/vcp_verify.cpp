@@ -0,0 +1,513 @@
+/*
+Copyright (C) 2013 by Ryan N. Lichtenwalter
+Email: rlichtenwalter@gmail.com
+
+This file is part of the Vertex Collocation Profiles code base.
+
+The Vertex Collocation Profiles code base is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+The Vertex Collocation Profiles code base is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with the Vertex Collocation Profiles code base. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <array>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <tclap/CmdLine.h>
+#include <vcp/directed_graph.hpp>
+#include <vcp/graph.hpp>
+#include <vcp/multirelational_directed_graph.hpp>
+#include <vcp/multirelational_graph.hpp>
+#include <vcp/mutable_graph.hpp>
+#include <vcp/relation_storage.hpp>
+#include <vcp/synthetic_graph.hpp>
+#include <vcp/v3_sample.hpp>
+#include <vcp/vcp.hpp>
+#include <vcp/vcp_canonical_mapper.hpp>
+#include <vcp/vcp_maintainer.hpp>
+
+struct verify_options {
+	std::size_t vertices;
+	double mean_degree;
+	std::size_t trials;
+	double reciprocity;
+	std::size_t combinations;
+	std::uint64_t seed;
+	std::size_t updates;
+	std::size_t approx_seeds; // 0 to verify exact profiles
+	std::size_t approx_budget;
+	double approx_z;
+};
+
+// collects the nonzero entries of a specialized vector, keyed by element index for the dense r=1 engines and otherwise by canonical subgraph address, packed to the given relations as vcp_generate packs those of a wider instantiation
+template <std::size_t n,std::size_t r,bool d,typename profiler_type,typename entry_type>
+void specialized_entries( profiler_type & profiler, vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, std::size_t, std::vector<entry_type> & entries, std::true_type ) {
+	std::array<unsigned long,profiler_type::element_count()> counts;
+	profiler.generate_vector( v1, v2, counts.begin() );
+	for( std::size_t i( 0 ); i < counts.size(); ++i ) {
+		if( counts[ i ] != 0 ) {
+			entries.push_back( entry_type( i, counts[ i ] ) );
+		}
+	}
+}
+
+template <std::size_t n,std::size_t r,bool d,typename profiler_type,typename entry_type>
+void specialized_entries( profiler_type & profiler, vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, std::size_t relations, std::vector<entry_type> & entries, std::false_type ) {
+	auto sink = [&entries,relations]( typename profiler_type::subgraph_address_type const & address, unsigned long count ) {
+		entries.push_back( entry_type( typename entry_type::first_type( vcp::pack_relations<n,r,d>( address, relations ) ), count ) );
+	};
+	profiler.generate_vector( v1, v2, sink );
+	std::sort( entries.begin(), entries.end() );
+}
+
+// collects the entries of the reference vector in the same keys
+template <typename reference_type,typename entry_type>
+void reference_entries( reference_type & reference, vcp::vcp_canonical_mapper const & mapper, vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, std::vector<entry_type> & entries, std::true_type ) {
+	auto sink = [&entries,&mapper]( typename reference_type::subgraph_address_type const & address, unsigned long count ) {
+		entries.push_back( entry_type( mapper.element_address( address ), count ) );
+	};
+	reference.generate_vector( v1, v2, sink );
+	std::sort( entries.begin(), entries.end() );
+}
+
+template <typename reference_type,typename entry_type>
+void reference_entries( reference_type & reference, vcp::vcp_canonical_mapper const &, vcp::const_vertex_iterator v1, vcp::const_vertex_iterator v2, std::vector<entry_type> & entries, std::false_type ) {
+	auto sink = [&entries]( typename reference_type::subgraph_address_type const & address, unsigned long count ) {
+		entries.push_back( entry_type( address, count ) );
+	};
+	reference.generate_vector( v1, v2, sink );
+}
+
+// adjusts the entries of a stored vector for an edge update with vcp_maintainer, in the keys of reference_entries
+template <typename maintainer_type,typename entry_type>
+void adjust_entries( maintainer_type const & maintainer, vcp::vcp_canonical_mapper const & mapper, vcp::vertex_id_t v1, vcp::vertex_id_t v2, vcp::edge_update const & update, std::vector<entry_type> & entries, std::true_type ) {
+	std::vector<unsigned long> counts( mapper.element_count(), 0 );
+	for( std::size_t i( 0 ); i < entries.size(); ++i ) {
+		counts[ entries[ i ].first ] = entries[ i ].second;
+	}
+	maintainer.adjust( v1, v2, update, counts.begin() );
+	entries.clear();
+	for( std::size_t i( 0 ); i < counts.size(); ++i ) {
+		if( counts[ i ] != 0 ) {
+			entries.push_back( entry_type( i, counts[ i ] ) );
+		}
+	}
+}
+
+template <typename maintainer_type,typename entry_type>
+void adjust_entries( maintainer_type const & maintainer, vcp::vcp_canonical_mapper const &, vcp::vertex_id_t v1, vcp::vertex_id_t v2, vcp::edge_update const & update, std::vector<entry_type> & entries, std::false_type ) {
+	std::map<typename entry_type::first_type,unsigned long> counts( entries.begin(), entries.end() );
+	maintainer.adjust( v1, v2, update, counts );
+	entries.assign( counts.begin(), counts.end() );
+}
+
+// applies seeded random edge insertions and deletions to the reference vectors of every pair with vcp_maintainer, compacting the mutable graph midway, then compares them with the reference vectors of the compacted graph
+template <std::size_t n,std::size_t r,bool d,typename graph_type,typename entry_type>
+std::size_t verify_updates( graph_type const & g, vcp::vcp_canonical_mapper const & mapper, std::vector<std::vector<entry_type> > maintained, std::size_t updates, std::uint64_t seed, bool report ) {
+	vcp::mutable_graph<r,d> graph( std::shared_ptr<graph_type const>( std::shared_ptr<graph_type const>(), &g ) ); // g outlives the graph
+	vcp::vcp_maintainer<n,r,d> maintainer( graph );
+	std::mt19937_64 random( seed );
+	std::vector<vcp::edge_update> applied;
+	for( std::size_t k( 0 ); k < updates && g.vertex_count() > 1; ++k ) {
+		vcp::edge_update update;
+		update.source = random() % g.vertex_count();
+		update.target = (update.source + 1 + random() % (g.vertex_count() - 1)) % g.vertex_count();
+		update.relation = random() % r;
+		update.insertion = ((maintainer.value( update.source, update.target ) >> update.relation) & 1) == 0; // toggle, so that edges of the graph are deleted as well
+		std::size_t i( 0 );
+		for( vcp::vertex_id_t v1( 0 ); v1 < g.vertex_count(); ++v1 ) {
+			for( vcp::vertex_id_t v2( 0 ); v2 < g.vertex_count(); ++v2 ) {
+				if( v1 != v2 ) {
+					adjust_entries( maintainer, mapper, v1, v2, update, maintained[ i++ ], std::integral_constant<bool,r == 1>() );
+				}
+			}
+		}
+		maintainer.apply( update );
+		applied.push_back( update );
+		if( k == updates / 2 ) { // later updates are applied while the base is rebuilt
+			graph.compact();
+		}
+	}
+
+	graph.wait();
+	graph.compact();
+	graph.wait();
+	std::stringstream text;
+	maintainer.write( text );
+	std::shared_ptr<graph_type const> const compacted( graph.current().base() );
+	graph_type const & updated( *compacted );
+	vcp::vcp_reference<n,r,d> reference( updated );
+	std::size_t discrepancies( 0 );
+	std::size_t i( 0 );
+	for( vcp::const_vertex_iterator v1( updated.vertices_begin() ); v1 != updated.vertices_end(); ++v1 ) {
+		for( vcp::const_vertex_iterator v2( updated.vertices_begin() ); v2 != updated.vertices_end(); ++v2 ) {
+			if( v1 == v2 ) {
+				continue;
+			}
+			std::vector<entry_type> expected;
+			reference_entries( reference, mapper, v1, v2, expected, std::integral_constant<bool,r == 1>() );
+			if( expected != maintained[ i ] && discrepancies++ == 0 && report ) {
+				std::cerr << "vcp_maintainer<" << n << "," << r << "," << d << "> seed " << seed << " pair " << updated.vertex_id( v1 ) << " " << updated.vertex_id( v2 ) << " after updates";
+				for( std::size_t j( 0 ); j < applied.size(); ++j ) {
+					std::cerr << ' ' << (applied[ j ].insertion ? '+' : '-') << applied[ j ].source << ',' << applied[ j ].target << ',' << applied[ j ].relation;
+				}
+				std::cerr << ":\n\texpected";
+				for( std::size_t j( 0 ); j < expected.size(); ++j ) {
+					std::cerr << ' ' << expected[ j ].first << ':' << expected[ j ].second;
+				}
+				std::cerr << "\n\tactual  ";
+				for( std::size_t j( 0 ); j < maintained[ i ].size(); ++j ) {
+					std::cerr << ' ' << maintained[ i ][ j ].first << ':' << maintained[ i ][ j ].second;
+				}
+				std::cerr << '\n' << text.str();
+			}
+			++i;
+		}
+	}
+	return discrepancies;
+}
+
+// the graph of a trial, of r relations and directed if d, drawn with seeds from seed to seed + 2
+vcp::synthetic_graph trial_graph( verify_options const & options, std::size_t trial, std::size_t r, bool d, std::uint64_t seed ) {
+	vcp::synthetic_graph skeleton( 0 );
+	if( trial % 3 == 0 ) { // alternate generators so that both uniform and skewed degree distributions are covered
+		skeleton = vcp::synthetic_graph::erdos_renyi( options.vertices, options.mean_degree, seed );
+	} else if( trial % 3 == 1 ) {
+		skeleton = vcp::synthetic_graph::barabasi_albert( options.vertices, static_cast<std::size_t>( options.mean_degree / 2 + 0.5 ), seed );
+	} else {
+		std::size_t scale( 0 );
+		while( (std::size_t( 1 ) << scale) < options.vertices ) {
+			++scale;
+		}
+		skeleton = vcp::synthetic_graph::rmat( scale, options.mean_degree, 0.57, 0.19, 0.19, seed );
+	}
+	if( d ) {
+		skeleton.orient( options.reciprocity, seed + 1 );
+	}
+	skeleton.label( r, options.combinations, seed + 2 );
+	return skeleton;
+}
+
+// compares vcp<n,storage_r,d> on graphs of r relations, its addresses packed to r relations, with the reference engine for r
+template <std::size_t n,std::size_t r,bool d,std::size_t storage_r = r>
+std::size_t verify( verify_options const & options, bool first ) {
+	typedef typename vcp::vcp_reference<n,r,d>::graph_type graph_type;
+	typedef typename vcp::vcp_reference<n,storage_r,d>::graph_type storage_graph_type;
+	typedef typename std::conditional<r == 1,std::size_t,typename vcp::vcp_reference<n,r,d>::subgraph_address_type>::type key_type;
+	typedef std::pair<key_type,unsigned long> entry_type;
+	vcp::vcp_canonical_mapper const mapper( n, 1, d ); // translates reference addresses to the element indices of the dense r=1 vectors
+	std::size_t pairs( 0 );
+	std::size_t discrepancies( 0 );
+	std::size_t update_discrepancies( 0 );
+	double specialized_seconds( 0 );
+	double reference_seconds( 0 );
+	for( std::size_t trial( 0 ); trial < options.trials; ++trial ) {
+		std::uint64_t const seed( options.seed + 4 * trial );
+		std::stringstream text;
+		trial_graph( options, trial, r, d, seed ).write( text );
+		graph_type g;
+		text >> g;
+		std::istringstream stored_text( text.str() );
+		storage_graph_type stored;
+		stored_text >> stored;
+
+		vcp::vcp<n,storage_r,d> specialized( stored );
+		vcp::vcp_reference<n,r,d> reference( g );
+		std::vector<std::vector<entry_type> > expected;
+		std::vector<std::vector<entry_type> > actual;
+		std::chrono::steady_clock::time_point start( std::chrono::steady_clock::now() );
+		for( vcp::const_vertex_iterator v1( stored.vertices_begin() ); v1 != stored.vertices_end(); ++v1 ) { // every ordered pair, so that adjacency and direction between v1 and v2 are exercised
+			for( vcp::const_vertex_iterator v2( stored.vertices_begin() ); v2 != stored.vertices_end(); ++v2 ) {
+				if( v1 != v2 ) {
+					actual.push_back( std::vector<entry_type>() );
+					specialized_entries<n,storage_r,d>( specialized, v1, v2, r, actual.back(), std::integral_constant<bool,r == 1>() );
+				}
+			}
+		}
+		specialized_seconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		start = std::chrono::steady_clock::now();
+		for( vcp::const_vertex_iterator v1( g.vertices_begin() ); v1 != g.vertices_end(); ++v1 ) {
+			for( vcp::const_vertex_iterator v2( g.vertices_begin() ); v2 != g.vertices_end(); ++v2 ) {
+				if( v1 != v2 ) {
+					expected.push_back( std::vector<entry_type>() );
+					reference_entries( reference, mapper, v1, v2, expected.back(), std::integral_constant<bool,r == 1>() );
+				}
+			}
+		}
+		reference_seconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+		std::size_t i( 0 );
+		for( vcp::const_vertex_iterator v1( g.vertices_begin() ); v1 != g.vertices_end(); ++v1 ) {
+			for( vcp::const_vertex_iterator v2( g.vertices_begin() ); v2 != g.vertices_end(); ++v2 ) {
+				if( v1 == v2 ) {
+					continue;
+				}
+				if( expected[ i ] != actual[ i ] ) {
+					if( discrepancies++ == 0 ) { // the first discrepancy is enough to reproduce the failure with the printed seed
+						std::cerr << "vcp<" << n << "," << storage_r << "," << d << ">" << (storage_r != r ? " packed to r=" + std::to_string( r ) : "") << " trial " << trial << " seed " << seed << " pair " << g.vertex_id( v1 ) << " " << g.vertex_id( v2 ) << ":\n\texpected";
+						for( std::size_t j( 0 ); j < expected[ i ].size(); ++j ) {
+							std::cerr << ' ' << expected[ i ][ j ].first << ':' << expected[ i ][ j ].second;
+						}
+						std::cerr << "\n\tactual  ";
+						for( std::size_t j( 0 ); j < actual[ i ].size(); ++j ) {
+							std::cerr << ' ' << actual[ i ][ j ].first << ':' << actual[ i ][ j ].second;
+						}
+						std::cerr << '\n' << text.str();
+					}
+				}
+				++i;
+				++pairs;
+			}
+		}
+		if( options.updates != 0 ) {
+			update_discrepancies += verify_updates<n,r,d>( g, mapper, expected, options.updates, seed + 3, update_discrepancies == 0 );
+		}
+	}
+
+	std::cout << (first ? "" : ",") << "\n\t\t{\"n\": " << n << ", \"r\": " << r << ", \"d\": " << d;
+	if( storage_r != r ) {
+		std::cout << ", \"storage_r\": " << storage_r;
+	}
+	std::cout << ", \"trials\": " << options.trials << ", \"pairs\": " << pairs << ", \"discrepancies\": " << discrepancies;
+	if( options.updates != 0 ) {
+		std::cout << ", \"update_discrepancies\": " << update_discrepancies;
+	}
+	std::cout << ", \"specialized_seconds\": " << specialized_seconds << ", \"reference_seconds\": " << reference_seconds;
+	std::cout << ", \"speedup\": " << (specialized_seconds > 0 ? reference_seconds / specialized_seconds : 0) << "}";
+	return discrepancies + update_discrepancies;
+}
+
+// the distance of the mean of a count's estimates from its exact value in standard errors; a zero standard error admits only rounding noise
+double standard_errors( double mean, unsigned long exact, double error ) {
+	double const distance( std::fabs( mean - exact ) );
+	if( error > 0 ) {
+		return distance / error;
+	}
+	return distance > 1e-9 * (1 + exact) ? std::numeric_limits<double>::infinity() : 0;
+}
+
+// profiles every ordered pair with vcp<4,1,d> under --approx with one salt per seed and compares the mean estimate of each count with its exact value, in standard errors of the mean from the reported variances; the unclamped estimates must agree, while the clamped counts written by vcp_generate are only reported
+template <bool d>
+std::size_t verify_approx( verify_options const & options, bool first ) {
+	typedef typename vcp::vcp_reference<4,1,d>::graph_type graph_type;
+	typedef vcp::vcp<4,1,d> profiler_type;
+	std::size_t pairs( 0 );
+	std::size_t estimates( 0 );
+	std::size_t outliers( 0 );
+	std::size_t clamped_outliers( 0 );
+	double max_z( 0 );
+	double clamped_max_z( 0 );
+	double const seeds( options.approx_seeds );
+	for( std::size_t trial( 0 ); trial < options.trials; ++trial ) {
+		std::uint64_t const seed( options.seed + 4 * trial );
+		std::stringstream text;
+		trial_graph( options, trial, 1, d, seed ).write( text );
+		graph_type g;
+		text >> g;
+
+		profiler_type profiler( g );
+		std::vector<vcp::v3_sample> samples;
+		for( std::size_t salt( 0 ); salt < options.approx_seeds; ++salt ) {
+			samples.push_back( vcp::v3_sample( profiler_type::element_count(), options.approx_budget, 0, salt ) ); // a zero threshold samples every pair with neighbors
+		}
+		std::array<unsigned long,profiler_type::element_count()> exact;
+		std::array<unsigned long,profiler_type::element_count()> counts;
+		std::vector<double> sums( exact.size() );
+		std::vector<double> clamped_sums( exact.size() );
+		std::vector<double> variances( exact.size() );
+		for( vcp::const_vertex_iterator v1( g.vertices_begin() ); v1 != g.vertices_end(); ++v1 ) {
+			for( vcp::const_vertex_iterator v2( g.vertices_begin() ); v2 != g.vertices_end(); ++v2 ) {
+				if( v1 == v2 ) {
+					continue;
+				}
+				profiler.generate_vector( v1, v2, exact.begin() );
+				std::fill( sums.begin(), sums.end(), 0 );
+				std::fill( clamped_sums.begin(), clamped_sums.end(), 0 );
+				std::fill( variances.begin(), variances.end(), 0 );
+				for( std::size_t salt( 0 ); salt < samples.size(); ++salt ) {
+					profiler.estimate_vector( v1, v2, counts.begin(), samples[ salt ] );
+					std::vector<double> const & variance( samples[ salt ].variances() );
+					bool const sampled( std::find_if( variance.begin(), variance.end(), []( double value ) { return value != 0; } ) != variance.end() ); // without variance the counts are exact and the estimates may belong to an earlier pair
+					for( std::size_t element( 0 ); element < exact.size(); ++element ) {
+						sums[ element ] += sampled ? samples[ salt ].estimates()[ element ] : counts[ element ];
+						clamped_sums[ element ] += counts[ element ];
+						variances[ element ] += variance[ element ];
+					}
+				}
+				for( std::size_t element( 0 ); element < exact.size(); ++element ) {
+					double const error( std::sqrt( variances[ element ] ) / seeds ); // the variance of the mean is the mean variance divided by the number of seeds
+					double const z( standard_errors( sums[ element ] / seeds, exact[ element ], error ) );
+					double const clamped_z( standard_errors( clamped_sums[ element ] / seeds, exact[ element ], error ) );
+					if( std::isfinite( z ) ) {
+						max_z = std::max( max_z, z );
+					}
+					if( std::isfinite( clamped_z ) ) {
+						clamped_max_z = std::max( clamped_max_z, clamped_z );
+					}
+					if( z > options.approx_z && outliers++ == 0 ) {
+						std::cerr << "vcp<4,1," << d << "> --approx " << options.approx_budget << " trial " << trial << " seed " << seed << " pair " << g.vertex_id( v1 ) << " " << g.vertex_id( v2 ) << " element " << element << ": exact " << exact[ element ] << ", mean estimate " << sums[ element ] / seeds << ", standard error " << error << '\n' << text.str();
+					}
+					if( clamped_z > options.approx_z ) {
+						++clamped_outliers;
+					}
+					++estimates;
+				}
+				++pairs;
+			}
+		}
+	}
+
+	std::cout << (first ? "" : ",") << "\n\t\t{\"n\": 4, \"r\": 1, \"d\": " << d << ", \"approx_budget\": " << options.approx_budget << ", \"approx_seeds\": " << options.approx_seeds;
+	std::cout << ", \"trials\": " << options.trials << ", \"pairs\": " << pairs << ", \"estimates\": " << estimates << ", \"outliers\": " << outliers << ", \"max_z\": " << max_z;
+	std::cout << ", \"clamped_outliers\": " << clamped_outliers << ", \"clamped_max_z\": " << clamped_max_z << "}";
+	return outliers;
+}
+
+// verifies r among the storage widths that vcp_generate instantiates for n and d, from the narrowest, reporting whether it is one
+template <std::size_t n,std::size_t storage_r,bool d>
+typename std::enable_if<(storage_r <= vcp::max_relations),bool>::type run_storage( std::size_t r, verify_options const & options, bool & first, std::size_t & discrepancies ) {
+	if( r != storage_r ) {
+		return run_storage<n,vcp::storage_relations<n,d>( storage_r + 1 ),d>( r, options, first, discrepancies );
+	}
+	discrepancies += verify<n,storage_r,d>( options, first );
+	first = false;
+	return true;
+}
+
+template <std::size_t n,std::size_t storage_r,bool d>
+typename std::enable_if<(storage_r > vcp::max_relations),bool>::type run_storage( std::size_t, verify_options const &, bool &, std::size_t & ) {
+	return false;
+}
+
+// verifies r itself, and for an r that is not a storage width, the instantiation that vcp_generate profiles it with, whose addresses are packed to r relations
+template <std::size_t n,std::size_t r,bool d>
+std::size_t run_packed( verify_options const & options, bool & first, bool direct ) {
+	std::size_t discrepancies( 0 );
+	if( direct ) {
+		discrepancies += verify<n,r,d>( options, first );
+		first = false;
+	}
+	discrepancies += verify<n,r,d,vcp::storage_relations<n,d>( r )>( options, first );
+	first = false;
+	return discrepancies;
+}
+
+// one entry per vcp<n,r,d> instantiation built by vcp_generate, and for r=2, r=11, and r=30, which are not storage widths, the packed output of the instantiation that profiles them; r=2 and r=30 are also verified directly
+template <std::size_t n,bool d>
+std::size_t run_relations( std::size_t r, verify_options const & options, bool & first ) {
+	std::size_t discrepancies( 0 );
+	if( r == 1 ) {
+		discrepancies += verify<n,1,d>( options, first );
+		first = false;
+	} else if( r == 2 ) {
+		discrepancies += run_packed<n,2,d>( options, first, true );
+	} else if( r == 11 ) {
+		discrepancies += run_packed<n,11,d>( options, first, false );
+	} else if( r == 30 ) {
+		discrepancies += run_packed<n,30,d>( options, first, true );
+	} else {
+		run_storage<n,vcp::storage_relations<n,d>( 2 ),d>( r, options, first, discrepancies );
+	}
+	return discrepancies;
+}
+
+std::size_t run( std::size_t n, std::size_t r, bool d, verify_options const & options, bool & first ) {
+	if( d ) {
+		return n == 3 ? run_relations<3,1>( r, options, first ) : run_relations<4,1>( r, options, first );
+	}
+	return n == 3 ? run_relations<3,0>( r, options, first ) : run_relations<4,0>( r, options, first );
+}
+
+int main( int argc, char * argv[] ) {
+	std::vector<std::size_t> ns;
+	std::vector<std::size_t> rs;
+	std::vector<std::size_t> ds;
+	verify_options options;
+	try {
+		TCLAP::CmdLine cmd( "Compare each VCP specialization with the exhaustive reference engine on seeded random graphs, reporting discrepancies and relative speed as JSON. The first discrepancy of each specialization is described on standard error, and the exit status is nonzero if any occur.", ' ', "1.0.0" );
+		TCLAP::ValueArg<std::size_t> verticesArg( "v", "vertices", "Number of vertices per graph; every ordered pair of distinct vertices is profiled", false, 16, "vertices", cmd );
+		TCLAP::ValueArg<double> degreeArg( "", "degree", "Mean degree of each undirected graph before orientation", false, 4, "degree", cmd );
+		TCLAP::ValueArg<std::size_t> trialsArg( "", "trials", "Number of graphs per specialization, cycling through the Erdos-Renyi, Barabasi-Albert, and R-MAT generators", false, 30, "trials", cmd );
+		TCLAP::ValueArg<double> reciprocityArg( "", "reciprocity", "For d=1, the probability that an edge is kept in both directions", false, 0.5, "probability", cmd );
+		TCLAP::ValueArg<std::size_t> combinationsArg( "", "combinations", "For r>1, the number of distinct relation combinations from which edge values are drawn (0 to draw from all of them); small pools produce isomorphic subgraphs with equal edge values", false, 3, "combinations", cmd );
+		TCLAP::ValueArg<std::uint64_t> seedArg( "s", "seed", "Seed of the first trial", false, 1, "seed", cmd );
+		TCLAP::ValueArg<std::size_t> updatesArg( "u", "updates", "Number of random edge insertions and deletions applied to each graph, through vcp_maintainer, to the reference vectors of every pair, which are then compared with the reference vectors of the updated graph (0 to skip)", false, 0, "updates", cmd );
+		TCLAP::ValueArg<std::size_t> approxArg( "", "approx", "Instead of the exact specializations, verify the estimates of vcp_generate --approx for n=4 and r=1: profile every pair with this many independent samples and compare the mean estimate of each count with its exact value in standard errors of the mean, derived from the reported variances (0 to verify exact profiles)", false, 0, "seeds", cmd );
+		TCLAP::ValueArg<std::size_t> approxBudgetArg( "", "approx-budget", "Under --approx, the expected number of v3 candidates expanded per pair", false, 2, "candidates", cmd );
+		TCLAP::ValueArg<double> approxZArg( "", "approx-z", "Under --approx, the number of standard errors beyond which a mean estimate is a discrepancy", false, 6, "z", cmd );
+		std::vector<std::size_t> allowedN {3, 4};
+		TCLAP::ValuesConstraint<std::size_t> allowedNVals( allowedN );
+		TCLAP::MultiArg<std::size_t> nArg( "n", "n", "Verify only specializations with this n (repeatable)", false, &allowedNVals, cmd );
+		std::vector<std::size_t> allowedR {1, 2, 5, 10, 11, 16, 21, 26, 30, 32, 37, 42, 48, 53, 58, 64};
+		TCLAP::ValuesConstraint<std::size_t> allowedRVals( allowedR );
+		TCLAP::MultiArg<std::size_t> rArg( "r", "r", "Verify only specializations with this r (repeatable). For r>1, vcp_generate instantiates the storage widths, the largest r whose subgraph addresses fill as many 64-bit words as fewer relations do; a storage width that vcp_generate does not instantiate for n and d is skipped. r=2, r=11, and r=30 are not storage widths and verify the output of the instantiation that profiles them, packed to r relations, and r=2 and r=30 also verify vcp<n,r,d> itself.", false, &allowedRVals, cmd );
+		std::vector<std::size_t> allowedD {0, 1};
+		TCLAP::ValuesConstraint<std::size_t> allowedDVals( allowedD );
+		TCLAP::MultiArg<std::size_t> dArg( "d", "d", "Verify only specializations with this d (repeatable)", false, &allowedDVals, cmd );
+		cmd.parse( argc, argv );
+		options.vertices = verticesArg.getValue();
+		options.mean_degree = degreeArg.getValue();
+		options.trials = trialsArg.getValue();
+		options.reciprocity = reciprocityArg.getValue();
+		options.combinations = combinationsArg.getValue();
+		options.seed = seedArg.getValue();
+		options.updates = updatesArg.getValue();
+		options.approx_seeds = approxArg.getValue();
+		options.approx_budget = approxBudgetArg.getValue();
+		options.approx_z = approxZArg.getValue();
+		if( options.approx_seeds != 0 ) {
+			if( nArg.isSet() || rArg.isSet() || updatesArg.isSet() ) {
+				throw TCLAP::ArgException( "verifies only n=4 and r=1 and cannot be combined with -n, -r, or --updates", approxArg.longID() );
+			}
+		} else if( approxBudgetArg.isSet() || approxZArg.isSet() ) {
+			throw TCLAP::ArgException( "requires --approx", approxBudgetArg.isSet() ? approxBudgetArg.longID() : approxZArg.longID() );
+		}
+		ns = nArg.isSet() ? nArg.getValue() : allowedN;
+		rs = rArg.isSet() ? rArg.getValue() : allowedR;
+		ds = dArg.isSet() ? dArg.getValue() : allowedD;
+	} catch( TCLAP::ArgException & e ) {
+		std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+		return 1;
+	}
+
+	std::size_t discrepancies( 0 );
+	try {
+		std::cout << "{\n\t\"vertices\": " << options.vertices << ", \"degree\": " << options.mean_degree << ", \"seed\": " << options.seed << ",\n\t\"results\": [";
+		bool first( true );
+		for( std::size_t k( 0 ); k < ds.size() && options.approx_seeds != 0; ++k ) {
+			discrepancies += ds[ k ] ? verify_approx<1>( options, first ) : verify_approx<0>( options, first );
+			first = false;
+		}
+		for( std::size_t i( 0 ); i < ns.size() && options.approx_seeds == 0; ++i ) {
+			for( std::size_t j( 0 ); j < rs.size(); ++j ) {
+				for( std::size_t k( 0 ); k < ds.size(); ++k ) {
+					discrepancies += run( ns[ i ], rs[ j ], ds[ k ], options, first );
+				}
+			}
+		}
+		std::cout << "\n\t]\n}" << std::endl;
+	} catch( std::exception const & e ) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return discrepancies == 0 ? 0 : 2;
+}